@@ -0,0 +1,188 @@
+// Compares DynamicArray with std::vector on growth, resize and insert/erase workloads.
+// Covers the trivially copyable path (memcpy/realloc), the trivially relocatable path (nested containers) and the
+// generic path. Contents of both containers are compared after every workload. Returns non-zero if they differ.
+//
+// Usage: ArrayBenchmark [element count]
+
+#include <Rush/UtilArray.h>
+#include <Rush/UtilTimer.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+using namespace Rush;
+
+namespace
+{
+
+// Similar in size to VkWriteDescriptorSet or PrimitiveBatch::BatchVertex
+struct Vertex
+{
+	float pos[3];
+	float tex[2];
+	u32   color;
+	u32   padding[2];
+};
+
+bool operator==(const Vertex& a, const Vertex& b) { return memcmp(&a, &b, sizeof(Vertex)) == 0; }
+
+Vertex makeVertex(size_t i)
+{
+	Vertex v = {};
+	v.pos[0] = float(i);
+	v.color  = u32(i);
+	return v;
+}
+
+// Inner arrays of the nested workloads are small, so per-element relocation dominates
+template <typename Inner> Inner makeInner(size_t i)
+{
+	Inner result;
+	for (size_t j = 0; j < 4; ++j)
+	{
+		result.push_back(u32(i + j));
+	}
+	return result;
+}
+
+template <typename A, typename B> bool equal(const A& a, const B& b)
+{
+	if (a.size() != b.size())
+	{
+		return false;
+	}
+	for (size_t i = 0; i < a.size(); ++i)
+	{
+		if (!(a[i] == b[i]))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool equal(const DynamicArray<DynamicArray<u32>>& a, const std::vector<std::vector<u32>>& b)
+{
+	if (a.size() != b.size())
+	{
+		return false;
+	}
+	for (size_t i = 0; i < a.size(); ++i)
+	{
+		if (!equal(a[i], b[i]))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+template <typename Array> void pushVertices(Array& array, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		array.push_back(makeVertex(i));
+	}
+}
+
+template <typename Array, typename Inner> void pushNested(Array& array, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		array.push_back(makeInner<Inner>(i));
+	}
+}
+
+template <typename Array> void resizeRepeatedly(Array& array, size_t count)
+{
+	for (size_t size = 1; size <= count; size *= 2)
+	{
+		array.resize(size);
+		array.resize(size / 2);
+	}
+	array.resize(count);
+}
+
+// Inserts and erases small ranges near the front, so that most of the array is shifted every time
+template <typename Array> void insertErase(Array& array, size_t count)
+{
+	const u32 values[16] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15};
+
+	array.resize(count);
+	for (size_t i = 0; i < count; ++i)
+	{
+		array[i] = u32(i);
+	}
+
+	const size_t iterations = 1000;
+	for (size_t i = 0; i < iterations; ++i)
+	{
+		const size_t pos = i % 8;
+		array.insert(array.begin() + pos, values, values + 16);
+		array.erase(array.begin() + pos + 4, array.begin() + pos + 12);
+	}
+}
+
+template <typename F> double measure(F&& fn)
+{
+	Timer timer;
+	fn();
+	return timer.time();
+}
+
+bool report(const char* name, double rushTime, double stdTime, bool contentsEqual)
+{
+	printf("%-30s DynamicArray %8.3f ms, std::vector %8.3f ms, ratio %5.2f%s\n", name, rushTime * 1000.0,
+	    stdTime * 1000.0, stdTime / rushTime, contentsEqual ? "" : " CONTENTS DIFFER");
+	return contentsEqual;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+	const size_t count = argc > 1 ? size_t(strtoull(argv[1], nullptr, 10)) : 200000;
+
+	bool success = true;
+
+	{
+		DynamicArray<Vertex> a;
+		std::vector<Vertex>  b;
+
+		const double rushTime = measure([&] { pushVertices(a, count); });
+		const double stdTime  = measure([&] { pushVertices(b, count); });
+		success &= report("push_back, trivially copyable", rushTime, stdTime, equal(a, b));
+	}
+
+	{
+		DynamicArray<DynamicArray<u32>> a;
+		std::vector<std::vector<u32>>   b;
+
+		const double rushTime = measure([&] { pushNested<decltype(a), DynamicArray<u32>>(a, count / 4); });
+		const double stdTime  = measure([&] { pushNested<decltype(b), std::vector<u32>>(b, count / 4); });
+		success &= report("push_back, nested arrays", rushTime, stdTime, equal(a, b));
+	}
+
+	{
+		DynamicArray<Vertex> a;
+		std::vector<Vertex>  b;
+
+		const double rushTime = measure([&] { resizeRepeatedly(a, count); });
+		const double stdTime  = measure([&] { resizeRepeatedly(b, count); });
+		success &= report("resize, trivially copyable", rushTime, stdTime, equal(a, b));
+	}
+
+	{
+		DynamicArray<u32> a;
+		std::vector<u32>  b;
+
+		const double rushTime = measure([&] { insertErase(a, count / 4); });
+		const double stdTime  = measure([&] { insertErase(b, count / 4); });
+		success &= report("insert/erase near front", rushTime, stdTime, equal(a, b));
+	}
+
+	printf(success ? "All checks passed\n" : "FAILED\n");
+
+	return success ? 0 : 1;
+}
@@ -0,0 +1,182 @@
+// Stress test and throughput benchmark for SpscQueue and MpscQueue.
+// Producers push sequence-numbered items, the consumer checks that every item arrives exactly once and that items of
+// each producer arrive in order. Returns non-zero if any check fails.
+//
+// Usage: QueueBenchmark [items per producer] [producer count]
+
+#include <Rush/UtilQueue.h>
+#include <Rush/UtilTimer.h>
+
+#include <atomic>
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+
+using namespace Rush;
+
+namespace
+{
+
+constexpr u32 QueueCapacity = 1024;
+constexpr u32 BatchSize     = 16;
+constexpr u32 MaxProducers  = 64;
+
+u64 makeItem(u32 producer, u32 sequence) { return (u64(producer) << 32) | sequence; }
+u32 getProducer(u64 item) { return u32(item >> 32); }
+u32 getSequence(u64 item) { return u32(item); }
+
+void printResult(const char* name, u64 itemCount, double seconds)
+{
+	printf("%-28s %10llu items %8.3f sec %8.2f M items/sec\n", name, (unsigned long long)itemCount, seconds,
+	    double(itemCount) / seconds / 1e6);
+}
+
+// Consumes items until all producers are done, returns false if an item is missing, duplicated or out of order.
+// Sets the abort flag on failure, so that producers blocked on a full queue stop instead of spinning forever.
+template <typename Queue>
+bool consume(Queue& queue, u32 producerCount, u32 itemsPerProducer, std::atomic<bool>& aborted)
+{
+	u32 expectedSequence[MaxProducers] = {};
+
+	const u64 totalCount    = u64(producerCount) * itemsPerProducer;
+	u64       receivedCount = 0;
+
+	u64 items[BatchSize];
+	while (receivedCount != totalCount)
+	{
+		const size_t count = queue.popBatch(items, BatchSize);
+		if (count == 0)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			const u32 producer = getProducer(items[i]);
+			const u32 sequence = getSequence(items[i]);
+			if (producer >= producerCount || sequence != expectedSequence[producer])
+			{
+				printf("Unexpected item from producer %u: sequence %u, expected %u\n", producer, sequence,
+				    producer < producerCount ? expectedSequence[producer] : 0);
+				aborted = true;
+				return false;
+			}
+			expectedSequence[producer]++;
+		}
+
+		receivedCount += count;
+	}
+
+	u64 leftover;
+	if (queue.pop(leftover))
+	{
+		printf("Queue contains more items than were pushed\n");
+		return false;
+	}
+
+	return true;
+}
+
+// Alternates between single and batch pushes, so that both paths race with each other
+template <typename Queue> void produce(Queue& queue, u32 producer, u32 itemCount, const std::atomic<bool>& aborted)
+{
+	u32 sequence = 0;
+	while (sequence != itemCount && !aborted.load(std::memory_order_relaxed))
+	{
+		if (sequence % (2 * BatchSize) < BatchSize)
+		{
+			if (queue.push(makeItem(producer, sequence)))
+			{
+				++sequence;
+			}
+			else
+			{
+				std::this_thread::yield();
+			}
+		}
+		else
+		{
+			u64       items[BatchSize];
+			const u32 count = min<u32>(BatchSize, itemCount - sequence);
+			for (u32 i = 0; i < count; ++i)
+			{
+				items[i] = makeItem(producer, sequence + i);
+			}
+
+			const size_t pushed = queue.pushBatch(items, count);
+			if (pushed)
+			{
+				sequence += u32(pushed);
+			}
+			else
+			{
+				std::this_thread::yield();
+			}
+		}
+	}
+}
+
+bool runSpsc(u32 itemCount)
+{
+	SpscQueue<u64> queue(QueueCapacity);
+
+	std::atomic<bool> aborted = {false};
+
+	Timer timer;
+
+	std::thread producer([&] { produce(queue, 0, itemCount, aborted); });
+	const bool  result = consume(queue, 1, itemCount, aborted);
+	producer.join();
+
+	printResult("SpscQueue, 1 producer", itemCount, timer.time());
+
+	return result;
+}
+
+bool runMpsc(u32 producerCount, u32 itemsPerProducer)
+{
+	MpscQueue<u64> queue(QueueCapacity);
+
+	std::atomic<bool> aborted = {false};
+
+	Timer timer;
+
+	std::thread producers[MaxProducers];
+	for (u32 i = 0; i < producerCount; ++i)
+	{
+		producers[i] =
+		    std::thread([&queue, &aborted, i, itemsPerProducer] { produce(queue, i, itemsPerProducer, aborted); });
+	}
+
+	const bool result = consume(queue, producerCount, itemsPerProducer, aborted);
+
+	for (u32 i = 0; i < producerCount; ++i)
+	{
+		producers[i].join();
+	}
+
+	char name[64];
+	snprintf(name, sizeof(name), "MpscQueue, %u producer%s", producerCount, producerCount == 1 ? "" : "s");
+	printResult(name, u64(producerCount) * itemsPerProducer, timer.time());
+
+	return result;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+	const u32 itemsPerProducer = argc > 1 ? u32(strtoul(argv[1], nullptr, 10)) : 100000;
+	const u32 producerCount    = argc > 2 ? clamp<u32>(u32(strtoul(argv[2], nullptr, 10)), 1, MaxProducers) : 4;
+
+	bool success = true;
+
+	success &= runSpsc(itemsPerProducer);
+	success &= runMpsc(1, itemsPerProducer);
+	success &= runMpsc(producerCount, itemsPerProducer);
+
+	printf(success ? "All checks passed\n" : "FAILED\n");
+
+	return success ? 0 : 1;
+}
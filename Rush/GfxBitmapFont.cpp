@@ -138,21 +138,21 @@ bool BitmapFontDesc::read(DataStream& stream)
 		switch (blockType)
 		{
 		case BlockType::Info:
-			info = (InfoBlock*)allocateBytes(blockSize);
+			info = (InfoBlock*)allocateBytes(blockSize, MemoryTag::Font);
 			if (info)
 			{
 				stream.read(info, blockSize);
 			}
 			break;
 		case BlockType::Common:
-			common = (CommonBlock*)allocateBytes(blockSize);
+			common = (CommonBlock*)allocateBytes(blockSize, MemoryTag::Font);
 			if (common)
 			{
 				stream.read(common, blockSize);
 			}
 			break;
 		case BlockType::Pages:
-			pages = (PagesBlock*)allocateBytes(blockSize);
+			pages = (PagesBlock*)allocateBytes(blockSize, MemoryTag::Font);
 			if (pages)
 			{
 				stream.read(pages, blockSize);
@@ -161,7 +161,7 @@ bool BitmapFontDesc::read(DataStream& stream)
 			}
 			break;
 		case BlockType::Chars:
-			chars = (CharsBlock*)allocateBytes(blockSize);
+			chars = (CharsBlock*)allocateBytes(blockSize, MemoryTag::Font);
 			if (chars)
 			{
 				stream.read(chars, blockSize);
@@ -169,7 +169,7 @@ bool BitmapFontDesc::read(DataStream& stream)
 			}
 			break;
 		case BlockType::Kerning:
-			kerning = (KerningBlock*)allocateBytes(blockSize);
+			kerning = (KerningBlock*)allocateBytes(blockSize, MemoryTag::Font);
 			if (kerning)
 			{
 				stream.read(kerning, blockSize);
@@ -398,6 +398,8 @@ void BitmapFontRenderer::createSprites()
 
 BitmapFontData BitmapFontRenderer::createEmbeddedFont(bool shadow, u32 pad_x, u32 pad_y)
 {
+	MemoryTagScope tagScope(MemoryTag::Font);
+
 	const u16 charWidth  = u16(6 + pad_x);
 	const u16 charHeight = u16(8 + pad_y);
 	const u16 charCount  = '~' - ' ' + 1;
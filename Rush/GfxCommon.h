@@ -74,6 +74,7 @@
 #define RUSH_RENDER_SUPPORT_RAY_TRACING     1
 #define RUSH_RENDER_SUPPORT_BUFFER_ADDRESS  1
 #define RUSH_RENDER_SUPPORT_QUERY           1
+#define RUSH_RENDER_SUPPORT_GPU_ZONES       1
 #else // RUSH_RENDER_API_EXTERNAL
 #define RUSH_RENDER_API_NAME "Unknown"
 #endif
@@ -1016,14 +1017,16 @@ enum class GfxAccelerationStructureType
 	TopLevel,
 };
 
-enum class GfxAccelerationStructureBuildFlags
+enum class GfxAccelerationStructureBuildFlags : u8
 {
-	AllowUpdate     = 0x01,
-	AllowCompaction = 0x02,
+	None            = 0x00,
+	AllowUpdate     = 0x01, // structure can be refit, see GfxAccelerationStructureBuild::update
+	AllowCompaction = 0x02, // bottom level structure can be compacted, see Gfx_CompactAccelerationStructures()
 	FastTrace       = 0x04,
 	FastBuild       = 0x08,
 	LowMemory       = 0x10,
 };
+RUSH_IMPLEMENT_FLAG_OPERATORS(GfxAccelerationStructureBuildFlags, u8);
 
 struct GfxRayTracingGeometryDesc
 {
@@ -1054,6 +1057,18 @@ struct GfxAccelerationStructureDesc
 	u32                        geometyCount = 0;
 
 	u32                        instanceCount = 0;
+
+	GfxAccelerationStructureBuildFlags flags = GfxAccelerationStructureBuildFlags::FastTrace;
+};
+
+struct GfxAccelerationStructureBuild
+{
+	GfxAccelerationStructure accelerationStructure;
+	GfxBuffer                instanceBuffer; // top level structures only
+
+	// Refit the result of the previous build using current geometry or instance data.
+	// Topology must not change. Requires AllowUpdate, falls back to a full build if the structure was never built.
+	bool update = false;
 };
 
 struct GfxRayTracingPipelineDesc
@@ -1070,14 +1085,34 @@ struct GfxRayTracingPipelineDesc
 
 enum class GfxQuueryType : u8
 {
-	Occlusion = 0,
-	Timestamp = 1,
+	Occlusion          = 0,
+	Timestamp          = 1,
+	PipelineStatistics = 2,
+};
+
+enum class GfxPipelineStatisticFlags : u32
+{
+	None = 0,
+
+	InputAssemblyVertices           = 1 << 0,
+	InputAssemblyPrimitives         = 1 << 1,
+	VertexShaderInvocations         = 1 << 2,
+	GeometryShaderInvocations       = 1 << 3,
+	GeometryShaderPrimitives        = 1 << 4,
+	ClippingInvocations             = 1 << 5,
+	ClippingPrimitives              = 1 << 6,
+	FragmentShaderInvocations       = 1 << 7,
+	TessControlShaderPatches        = 1 << 8,
+	TessEvaluationShaderInvocations = 1 << 9,
+	ComputeShaderInvocations        = 1 << 10,
 };
+RUSH_IMPLEMENT_FLAG_OPERATORS(GfxPipelineStatisticFlags, u32);
 
 struct GfxQueryPoolDesc
 {
-	GfxQuueryType type  = GfxQuueryType::Occlusion;
-	u32           count = 0;
+	GfxQuueryType             type               = GfxQuueryType::Occlusion;
+	u32                       count              = 0;
+	GfxPipelineStatisticFlags pipelineStatistics = GfxPipelineStatisticFlags::None; // for PipelineStatistics pools
 };
 
 enum class GfxQueryControlFlags : u8
@@ -1089,10 +1124,11 @@ RUSH_IMPLEMENT_FLAG_OPERATORS(GfxQueryControlFlags, u8);
 
 enum class GfxQueryResultFlags : u8
 {
-	None        = 0,
-	Value64Bit  = 0x01,
-	Wait        = 0x02,
-	Partial     = 0x08,
+	None             = 0,
+	Value64Bit       = 0x01,
+	Wait             = 0x02,
+	WithAvailability = 0x04, // each result is followed by a non-zero value if the query is available
+	Partial          = 0x08,
 };
 RUSH_IMPLEMENT_FLAG_OPERATORS(GfxQueryResultFlags, u8);
 
@@ -3,6 +3,7 @@
 #include "GfxCommon.h"
 #include "Platform.h"
 #include "UtilColor.h"
+#include "UtilFrameArena.h"
 #include "RushC.h"
 
 namespace Rush
@@ -12,6 +13,29 @@ struct GfxShaderSource;
 class GfxContext;
 class GfxDevice;
 
+// Statistics of a single render pass or a run of compute dispatches outside of render passes
+struct GfxPassStats
+{
+	const char* name      = nullptr; // innermost GPU zone at the start of the pass, if any
+	bool        isCompute = false;
+
+	u32 drawCalls        = 0;
+	u32 dispatches       = 0;
+	u32 vertices         = 0;
+	u32 triangles        = 0;
+	u32 pipelineBinds    = 0;
+	u32 descriptorWrites = 0;
+	u32 barriers         = 0;
+
+	// GPU pipeline statistics, only available when GfxConfig::pipelineStatistics is enabled
+	bool hasPipelineStatistics     = false;
+	u64  vertexShaderInvocations   = 0;
+	u64  clippingInvocations       = 0; // primitives that reached the clipping stage
+	u64  clippingPrimitives        = 0; // primitives output by clipping
+	u64  fragmentShaderInvocations = 0;
+	u64  computeShaderInvocations  = 0;
+};
+
 struct GfxStats
 {
 	u32    drawCalls        = 0;
@@ -19,6 +43,33 @@ struct GfxStats
 	u32    triangles        = 0;
 	double lastFrameGpuTime = 0.0; // in seconds
 
+	u32 dispatches              = 0;
+	u32 pipelineBinds           = 0;
+	u32 pipelineBindsElided     = 0; // pipeline state changes that resolved to the already bound pipeline
+	u32 descriptorUpdatesElided = 0; // technique changes that kept the bound descriptor set
+	u32 descriptorWrites        = 0;
+	u32 barriers                = 0;
+	u32 renderPassBegins        = 0;
+	u32 transientAllocations    = 0;
+	u32 deferredDestructions    = 0; // objects destroyed once the GPU finished using them
+	u64 bytesUploaded           = 0;
+
+	// Async compute GPU time of the most recently retired frame and the part of it that overlapped
+	// the graphics frame, in seconds. Only measured if the compute queue supports timestamps.
+	double lastFrameAsyncComputeTime    = 0.0;
+	double lastFrameAsyncComputeOverlap = 0.0;
+
+	// CPU time blocked on the GPU, in seconds
+	double frameLatencyWaitTime = 0.0; // waiting for frames in flight, see Gfx_WaitForFrameLatency()
+	double acquireWaitTime      = 0.0; // waiting for the next swap chain image
+
+	// Per-pass breakdown of the most recently retired frame, valid until the next Gfx_BeginFrame()
+	ArrayView<const GfxPassStats> passes;
+
+	// Cumulative, not cleared by Gfx_ResetStats()
+	u32 pipelines            = 0; // unique pipeline objects created
+	u32 pipelinePermutations = 0; // unique fixed function state combinations, including dynamic state
+
 	enum
 	{
 		MaxCustomTimers = 16
@@ -26,6 +77,23 @@ struct GfxStats
 	double customTimer[MaxCustomTimers] = {};
 };
 
+// Point in the submission stream of a queue, used to order work between graphics and async compute
+struct GfxQueueToken
+{
+	u64 handle = 0; // backend specific synchronization object
+	u64 value  = 0;
+
+	bool valid() const { return handle != 0; }
+};
+
+struct GfxGpuZone
+{
+	const char* name      = nullptr;
+	u32         depth     = 0;
+	double      beginTime = 0.0; // in seconds, same time base as Timer::global
+	double      endTime   = 0.0;
+};
+
 struct GfxMappedBuffer
 {
 	void*     data = nullptr;
@@ -40,6 +108,15 @@ struct GfxMappedTexture
 	GfxTexture handle;
 };
 
+enum class GfxPresentMode : u8
+{
+	Default,     // Fifo if present interval is non-zero, otherwise the lowest latency supported mode
+	Fifo,        // wait for vertical blank, always supported
+	FifoRelaxed, // wait for vertical blank, but present late frames immediately (may tear)
+	Mailbox,     // no tearing, latest frame replaces the one waiting for vertical blank
+	Immediate,   // no waiting (may tear)
+};
+
 struct GfxConfig
 {
 	GfxConfig() = default;
@@ -61,6 +138,19 @@ struct GfxConfig
 	bool debug            = false;
 	bool warp             = false;
 	bool minimizeLatency  = false;
+
+	// Preferred presentation mode, falls back to the closest supported one
+	GfxPresentMode presentMode = GfxPresentMode::Default;
+
+	// Maximum number of frames the CPU may record ahead of the GPU.
+	// 0 selects 1 frame if minimizeLatency is set, or 2 frames otherwise.
+	u32 maxFramesInFlight = 0;
+
+	// Wrap each pass in a pipeline statistics query, reported in GfxStats::passes.
+	// Requires GfxCapability::pipelineStatistics.
+	// Only one pipeline statistics query may be active at a time, so user queries of type
+	// GfxQuueryType::PipelineStatistics can't be used on graphics contexts while this is enabled.
+	bool pipelineStatistics = false;
 };
 
 struct GfxCapability
@@ -71,6 +161,7 @@ struct GfxCapability
 	bool        compute              = false;
 	bool        instancing           = false;
 	bool        drawIndirect         = false;
+	bool        drawIndirectCount    = false;
 	bool        dispatchIndirect     = false;
 	bool        shaderInt16          = false;
 	bool        shaderInt64          = false;
@@ -79,6 +170,7 @@ struct GfxCapability
 	bool        sampleLocations      = false;
 	bool        pushConstants        = false;
 	bool        descriptorIndexing   = false;
+	bool        pipelineStatistics   = false;
 
 	bool explicitVertexParameterAMD  = false;
 
@@ -164,6 +256,12 @@ void                 Gfx_BeginFrame();
 void                 Gfx_EndFrame();
 void                 Gfx_Present();
 void                 Gfx_SetPresentInterval(u32 interval);
+void                 Gfx_SetPresentMode(GfxPresentMode mode); // takes effect on next Gfx_BeginFrame()
+GfxPresentMode       Gfx_GetPresentMode();                    // mode that is actually used by the swap chain
+void                 Gfx_SetMaxFramesInFlight(u32 count);
+// Blocks until fewer than max frames in flight are queued on the GPU.
+// Call right before sampling input to minimize input latency. Otherwise it is called by Gfx_BeginFrame().
+void                 Gfx_WaitForFrameLatency();
 const GfxCapability& Gfx_GetCapability();
 void                 Gfx_Finish();
 
@@ -192,6 +290,7 @@ void                 Gfx_ResetQuery(GfxContext* ctx, GfxQueryPool pool, u32 inde
 void                 Gfx_BeginQuery(
                     GfxContext* ctx, GfxQueryPool pool, u32 index, GfxQueryControlFlags flags = GfxQueryControlFlags::None);
 void Gfx_EndQuery(GfxContext* ctx, GfxQueryPool pool, u32 index);
+void Gfx_WriteTimestamp(GfxContext* ctx, GfxQueryPool pool, u32 index);
 bool Gfx_GetQueryResults(
     GfxQueryPool pool, u32 index, u32 count, size_t dataSize, void* outData, u32 stride, GfxQueryResultFlags flags);
 #endif // RUSH_RENDER_SUPPORT_QUERY
@@ -201,6 +300,15 @@ GfxOwn<GfxAccelerationStructure> Gfx_CreateAccelerationStructure(const GfxAccele
 const u8*                        Gfx_GetRayTracingShaderHandle(GfxRayTracingPipelineArg h, GfxRayTracingShaderType type, u32 index);
 u64                              Gfx_GetAccelerationStructureHandle(GfxAccelerationStructureArg h);
 void                             Gfx_BuildAccelerationStructure(GfxContext* ctx, GfxAccelerationStructureArg h, GfxBufferArg instanceBuffer = InvalidResourceHandle());
+// Builds or updates several acceleration structures at once, sharing a single scratch allocation.
+// Bottom level structures in the batch are complete before top level structures are built.
+void                             Gfx_BuildAccelerationStructures(GfxContext* ctx, const GfxAccelerationStructureBuild* builds, u32 count);
+// Replaces structures built with AllowCompaction by compacted copies once their compacted size is available,
+// typically a few frames after the build. Handles remain valid, but device addresses change, so top level
+// structures that reference compacted ones must be rebuilt. Returns number of compacted structures.
+// Compacted structures may still be updated in place. A full rebuild reallocates the structure at its original size
+// (changing its device address again), after which it may be compacted again.
+u32                              Gfx_CompactAccelerationStructures(GfxContext* ctx, const GfxAccelerationStructure* handles, u32 count);
 void                             Gfx_SetAccelerationStructure(GfxContext* ctx, u32 idx, GfxAccelerationStructureArg h);
 void                             Gfx_TraceRays(GfxContext* ctx, GfxRayTracingPipelineArg pipeline, GfxBufferArg hitGroups, u32 width, u32 height = 1, u32 depth = 1);
 
@@ -268,8 +376,25 @@ inline u64 Gfx_GetBufferAddress(GfxBufferArg) { return 0; }
 GfxContext* Gfx_AcquireContext();
 void        Gfx_Release(GfxContext* rc);
 
+// Async compute context waits for all work previously recorded in ctx
 GfxContext* Gfx_BeginAsyncCompute(GfxContext* ctx);
+// Submits async compute work and makes subsequent work in parentContext wait for it
 void        Gfx_EndAsyncCompute(GfxContext* parentContext, GfxContext* asyncContext);
+// Submits async compute work without waiting for it. Work that consumes the results must wait on the returned
+// token, which lets the async work overlap with graphics work recorded in the meantime.
+GfxQueueToken Gfx_SubmitAsyncCompute(GfxContext* asyncContext);
+
+// Submits work recorded so far in a graphics context. Returned token is reached when this work completes.
+GfxQueueToken Gfx_SignalToken(GfxContext* ctx);
+// Work recorded in ctx after this call does not start until the token is reached.
+// On async compute contexts the wait applies to the entire context, so it should be added before recording work.
+void          Gfx_WaitForToken(GfxContext* ctx, GfxQueueToken token);
+
+// Queue family ownership transfer for resources that are written on one queue and accessed on another.
+// Must be recorded with identical arguments on the releasing context before it is submitted, and on the
+// acquiring context after it waits for the releasing submission.
+void Gfx_TransferOwnership(GfxContext* ctx, GfxBufferArg h, GfxContextType srcQueue, GfxContextType dstQueue);
+void Gfx_TransferOwnership(GfxContext* ctx, GfxTextureArg h, GfxContextType srcQueue, GfxContextType dstQueue);
 
 void Gfx_BeginPass(GfxContext* rc, const GfxPassDesc& desc);
 void Gfx_EndPass(GfxContext* rc);
@@ -295,6 +420,7 @@ void Gfx_FlushBarriers(GfxContext* rc);
 void Gfx_AddFullPipelineBarrier(GfxContext* rc);
 void Gfx_AddImageBarrier(GfxContext* rc, GfxTextureArg textureHandle, GfxResourceState desiredState,
     GfxSubresourceRange* subresourceRange = nullptr);
+void Gfx_AddBufferBarrier(GfxContext* rc, GfxBufferArg h, GfxResourceState srcState, GfxResourceState dstState);
 void Gfx_ResolveImage(GfxContext* rc, GfxTextureArg src, GfxTextureArg dst);
 
 void Gfx_Dispatch(GfxContext* rc, u32 sizeX, u32 sizeY, u32 sizeZ);
@@ -308,6 +434,9 @@ void Gfx_DrawIndexedInstanced(GfxContext* rc, u32 indexCount, u32 firstIndex, u3
     u32 instanceCount, u32 instanceOffset);
 
 void Gfx_DrawIndexedIndirect(GfxContext* rc, GfxBufferArg argsBuffer, size_t argsBufferOffset, u32 drawCount);
+// Draw count is read from countBuffer on the GPU and clamped to maxDrawCount. Requires GfxCapability::drawIndirectCount.
+void Gfx_DrawIndexedIndirectCount(GfxContext* rc, GfxBufferArg argsBuffer, size_t argsBufferOffset,
+    GfxBufferArg countBuffer, size_t countBufferOffset, u32 maxDrawCount);
 void Gfx_DispatchIndirect(GfxContext* rc, GfxBufferArg argsBuffer, size_t argsBufferOffset,
     const void* pushConstants = nullptr, u32 pushConstantsSize = 0);
 
@@ -319,6 +448,12 @@ void Gfx_PopMarker(GfxContext* rc);
 void Gfx_BeginTimer(GfxContext* rc, u32 timestampId);
 void Gfx_EndTimer(GfxContext* rc, u32 timestampId);
 
+// Hierarchical named GPU timing zones. Results are resolved once the frame is retired by the GPU,
+// which happens several frames later. Zone names are not copied and must outlive the frame.
+void                        Gfx_BeginGpuZone(GfxContext* rc, const char* name);
+void                        Gfx_EndGpuZone(GfxContext* rc);
+ArrayView<const GfxGpuZone> Gfx_GetGpuZones();
+
 using GfxScreenshotCallback = void (*)(const ColorRGBA8* pixels, Tuple2u size, void* userData);
 void Gfx_RequestScreenshot(GfxScreenshotCallback callback, void* userData = nullptr);
 
@@ -391,6 +526,14 @@ struct GfxTimerScope
 	u32         m_timestampId;
 };
 
+struct GfxGpuZoneScope
+{
+	GfxGpuZoneScope(GfxContext* rc, const char* name) : m_rc(rc) { Gfx_BeginGpuZone(m_rc, name); }
+	~GfxGpuZoneScope() { Gfx_EndGpuZone(m_rc); }
+
+	GfxContext* m_rc;
+};
+
 template <typename T> inline u32 Gfx_UpdateBufferT(GfxContext* rc, GfxBufferArg h, const T& data)
 {
 	Gfx_UpdateBuffer(rc, h, &data, sizeof(data));
@@ -416,11 +559,17 @@ inline void Gfx_AddImageBarrier(
     GfxContext* rc, GfxTextureArg textureHandle, GfxResourceState desiredState, GfxSubresourceRange* subresourceRange)
 {
 }
+inline void Gfx_AddBufferBarrier(GfxContext*, GfxBufferArg, GfxResourceState, GfxResourceState) {}
 #endif // RUSH_RENDER_SUPPORT_BARRIERS
 
 #ifndef RUSH_RENDER_SUPPORT_ASYNC_COMPUTE
 inline GfxContext* Gfx_BeginAsyncCompute(GfxContext*) { return nullptr; }
 inline void        Gfx_EndAsyncCompute(GfxContext*, GfxContext*){};
+inline GfxQueueToken Gfx_SubmitAsyncCompute(GfxContext*) { return {}; }
+inline GfxQueueToken Gfx_SignalToken(GfxContext*) { return {}; }
+inline void        Gfx_WaitForToken(GfxContext*, GfxQueueToken) {}
+inline void        Gfx_TransferOwnership(GfxContext*, GfxBufferArg, GfxContextType, GfxContextType) {}
+inline void        Gfx_TransferOwnership(GfxContext*, GfxTextureArg, GfxContextType, GfxContextType) {}
 #endif //RUSH_RENDER_SUPPORT_ASYNC_COMPUTE
 
 #ifndef RUSH_RENDER_SUPPORT_MESH_SHADER
@@ -436,6 +585,8 @@ inline GfxOwn<GfxAccelerationStructure> Gfx_CreateAccelerationStructure(const Gf
 inline const u8* Gfx_GetRayTracingShaderHandle(GfxRayTracingPipelineArg h, GfxRayTracingShaderType type, u32 index) { return {}; }
 inline u64  Gfx_GetAccelerationStructureHandle(GfxAccelerationStructureArg h) { return 0; }
 inline void Gfx_BuildAccelerationStructure(GfxContext* ctx, GfxAccelerationStructureArg h, GfxBufferArg instanceBuffer) {}
+inline void Gfx_BuildAccelerationStructures(GfxContext* ctx, const GfxAccelerationStructureBuild* builds, u32 count) {}
+inline u32  Gfx_CompactAccelerationStructures(GfxContext* ctx, const GfxAccelerationStructure* handles, u32 count) { return 0; }
 inline void Gfx_SetAccelerationStructure(GfxContext* ctx, u32 idx, GfxAccelerationStructureArg h) {}
 inline void Gfx_TraceRays(GfxContext* ctx, GfxRayTracingPipelineArg pipeline, GfxBufferArg hitGroups, u32 width, u32 height, u32 depth) {}
 inline void Gfx_Retain(GfxRayTracingPipeline h){};
@@ -443,15 +594,36 @@ inline void Gfx_Release(GfxRayTracingPipeline h){};
 inline void Gfx_Release(GfxAccelerationStructure h){};
 #endif // RUSH_RENDER_SUPPORT_RAY_TRACING
 
+#ifndef RUSH_RENDER_SUPPORT_QUERY
+inline GfxOwn<GfxQueryPool> Gfx_CreateQueryPool(const GfxQueryPoolDesc&) { return {}; }
+inline void Gfx_Retain(GfxQueryPool) {}
+inline void Gfx_Release(GfxQueryPool) {}
+inline void Gfx_ResetQuery(GfxContext*, GfxQueryPool, u32, u32) {}
+inline void Gfx_BeginQuery(GfxContext*, GfxQueryPool, u32, GfxQueryControlFlags = GfxQueryControlFlags::None) {}
+inline void Gfx_EndQuery(GfxContext*, GfxQueryPool, u32) {}
+inline void Gfx_WriteTimestamp(GfxContext*, GfxQueryPool, u32) {}
+inline bool Gfx_GetQueryResults(GfxQueryPool, u32, u32, size_t, void*, u32, GfxQueryResultFlags) { return false; }
+#endif // RUSH_RENDER_SUPPORT_QUERY
+
+#ifndef RUSH_RENDER_SUPPORT_GPU_ZONES
+inline void                        Gfx_BeginGpuZone(GfxContext*, const char*) {}
+inline void                        Gfx_EndGpuZone(GfxContext*) {}
+inline ArrayView<const GfxGpuZone> Gfx_GetGpuZones() { return {}; }
+#endif // RUSH_RENDER_SUPPORT_GPU_ZONES
+
 // Null render API implementation
 
 #if RUSH_RENDER_API == RUSH_RENDER_API_NULL
 inline GfxDevice* Gfx_CreateDevice(Window* window, const GfxConfig& cfg) { return nullptr; }
 inline void Gfx_Release(GfxDevice* dev) {}
-inline void Gfx_BeginFrame() {}
+inline void Gfx_BeginFrame() { FrameArena::resetFrameArenas(); }
 inline void Gfx_EndFrame() {}
 inline void Gfx_Present() {}
 inline void Gfx_SetPresentInterval(u32 interval) {}
+inline void Gfx_SetPresentMode(GfxPresentMode mode) {}
+inline GfxPresentMode Gfx_GetPresentMode() { return GfxPresentMode::Fifo; }
+inline void Gfx_SetMaxFramesInFlight(u32 count) {}
+inline void Gfx_WaitForFrameLatency() {}
 inline void Gfx_Finish() {}
 inline const GfxCapability& Gfx_GetCapability() { static const GfxCapability cap; return cap; }
 inline const GfxStats& Gfx_Stats() { static const GfxStats stats; return stats; }
@@ -527,6 +699,7 @@ inline void Gfx_DrawIndexed(GfxContext* rc, u32 indexCount, u32 firstIndex, u32
 inline void Gfx_DrawIndexed(GfxContext* rc, u32 indexCount, u32 firstIndex, u32 baseVertex, u32 vertexCount, const void* pushConstants, u32 pushConstantsSize) {}
 inline void Gfx_DrawIndexedInstanced(GfxContext* rc, u32 indexCount, u32 firstIndex, u32 baseVertex, u32 vertexCount, u32 instanceCount, u32 instanceOffset) {}
 inline void Gfx_DrawIndexedIndirect(GfxContext* rc, GfxBufferArg argsBuffer, size_t argsBufferOffset, u32 drawCount) {}
+inline void Gfx_DrawIndexedIndirectCount(GfxContext* rc, GfxBufferArg argsBuffer, size_t argsBufferOffset, GfxBufferArg countBuffer, size_t countBufferOffset, u32 maxDrawCount) {}
 inline void Gfx_DispatchIndirect(GfxContext* rc, GfxBufferArg argsBuffer, size_t argsBufferOffset, const void* pushConstants, u32 pushConstantsSize) {}
 inline void Gfx_PushMarker(GfxContext* rc, const char* marker) {}
 inline void Gfx_PopMarker(GfxContext* rc) {}
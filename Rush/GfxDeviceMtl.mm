@@ -348,6 +348,8 @@ void GfxDevice::beginFrame()
 
 void Gfx_BeginFrame()
 {
+	FrameArena::resetFrameArenas();
+
 	g_device->beginFrame();
 }
 
@@ -427,6 +429,7 @@ void Gfx_Present()
 				const u32 bytesPerRow = width * 4;
 				const u32 alignedBytesPerRow = (bytesPerRow + 0xFF) & ~0xFFu;
 				const size_t pixelCount = static_cast<size_t>(width) * height;
+				MemoryTagScope tagScope(MemoryTag::Staging);
 				DynamicArray<ColorRGBA8> pixels(pixelCount);
 				ImageView imageView;
 				imageView.data = src;
@@ -473,6 +476,28 @@ void Gfx_SetPresentInterval(u32 interval)
 	}
 }
 
+void Gfx_SetPresentMode(GfxPresentMode mode)
+{
+	static bool warningReported = false;
+	if (mode != GfxPresentMode::Default && mode != GfxPresentMode::Fifo && !warningReported)
+	{
+		Log::warning("Present modes other than FIFO are not implemented");
+		warningReported = true;
+	}
+}
+
+GfxPresentMode Gfx_GetPresentMode() { return GfxPresentMode::Fifo; }
+
+void Gfx_SetMaxFramesInFlight(u32 count)
+{
+	// Frame latency is controlled by the drawable pool of the Metal layer
+}
+
+void Gfx_WaitForFrameLatency()
+{
+	// Not implemented, nextDrawable blocks when all drawables are in use
+}
+
 void Gfx_RequestScreenshot(GfxScreenshotCallback callback, void* userData)
 {
 	g_device->m_pendingScreenshot.callback = callback;
@@ -1539,7 +1564,7 @@ static bool findOrAppendInstanceAccelerationStructure(
 	handles.push_back(handle);
 	outIndex = u32(handles.size() - 1);
 	GfxAccelerationStructure accelHandle(UntypedResourceHandle(
-	    static_cast<UntypedResourceHandle::IndexType>(handle)));
+	    static_cast<UntypedResourceHandle::ValueType>(handle)));
 	AccelerationStructureMTL& blas = g_device->m_resources.accelerationStructures[accelHandle];
 	[instances addObject:blas.native];
 	return true;
@@ -1587,7 +1612,7 @@ GfxOwn<GfxAccelerationStructure> Gfx_CreateAccelerationStructure(const GfxAccele
 u64 Gfx_GetAccelerationStructureHandle(GfxAccelerationStructureArg h)
 {
 	GfxAccelerationStructure handle = h;
-	return handle.valid() ? handle.index() : 0;
+	return handle.valid() ? handle.value() : 0;
 }
 
 void Gfx_BuildAccelerationStructure(GfxContext* ctx, GfxAccelerationStructureArg h, GfxBufferArg instanceBuffer)
@@ -1706,6 +1731,34 @@ void Gfx_BuildAccelerationStructure(GfxContext* ctx, GfxAccelerationStructureArg
 	}
 }
 
+void Gfx_BuildAccelerationStructures(GfxContext* ctx, const GfxAccelerationStructureBuild* builds, u32 count)
+{
+	// Structures are always fully rebuilt, bottom level first so that top level builds can reference them
+	for (u32 i = 0; i < count; ++i)
+	{
+		const AccelerationStructureMTL& accel = g_device->m_resources.accelerationStructures[builds[i].accelerationStructure];
+		if (accel.type == GfxAccelerationStructureType::BottomLevel)
+		{
+			Gfx_BuildAccelerationStructure(ctx, builds[i].accelerationStructure, builds[i].instanceBuffer);
+		}
+	}
+
+	for (u32 i = 0; i < count; ++i)
+	{
+		const AccelerationStructureMTL& accel = g_device->m_resources.accelerationStructures[builds[i].accelerationStructure];
+		if (accel.type == GfxAccelerationStructureType::TopLevel)
+		{
+			Gfx_BuildAccelerationStructure(ctx, builds[i].accelerationStructure, builds[i].instanceBuffer);
+		}
+	}
+}
+
+u32 Gfx_CompactAccelerationStructures(GfxContext* ctx, const GfxAccelerationStructure* handles, u32 count)
+{
+	// Not implemented
+	return 0;
+}
+
 void Gfx_Retain(GfxAccelerationStructure h)
 {
 	g_device->m_resources.accelerationStructures[h].addReference();
@@ -2530,6 +2583,13 @@ void Gfx_DrawIndexedIndirect(GfxContext* rc, GfxBufferArg argsBuffer, size_t arg
 	g_device->m_stats.drawCalls++;
 }
 
+void Gfx_DrawIndexedIndirectCount(GfxContext* rc, GfxBufferArg argsBuffer, size_t argsBufferOffset,
+	GfxBufferArg countBuffer, size_t countBufferOffset, u32 maxDrawCount)
+{
+	RUSH_ASSERT_MSG(Gfx_GetCapability().drawIndirectCount,
+	    "Indirect count draws are not supported on Metal, check GfxCapability::drawIndirectCount");
+}
+
 void Gfx_PushMarker(GfxContext* rc, const char* marker)
 {
 	NSString* str = @(marker);
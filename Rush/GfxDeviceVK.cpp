@@ -6,9 +6,10 @@
 #include "UtilString.h"
 #include "Window.h"
 #include "UtilImage.h"
+#include "UtilTimer.h"
 
 #include <algorithm>
-#include <variant>
+#include <mutex>
 
 #if defined(RUSH_PLATFORM_WINDOWS)
 #include <Windows.h> // only needed for GetModuleHandle()
@@ -31,8 +32,56 @@ class GfxContext;
 static GfxDevice*  g_device       = nullptr;
 static GfxContext* g_context      = nullptr;
 static VkDevice    g_vulkanDevice = VK_NULL_HANDLE;
+
+#if RUSH_MEMORY_TRACKING
+
+// Driver allocations are tracked by the Rush heap, tagged by allocation scope
+
+static MemoryTag getMemoryTag(VkSystemAllocationScope scope)
+{
+	switch (scope)
+	{
+	case VK_SYSTEM_ALLOCATION_SCOPE_COMMAND: return MemoryTag::VulkanCommand;
+	case VK_SYSTEM_ALLOCATION_SCOPE_OBJECT: return MemoryTag::VulkanObject;
+	case VK_SYSTEM_ALLOCATION_SCOPE_CACHE: return MemoryTag::VulkanCache;
+	case VK_SYSTEM_ALLOCATION_SCOPE_DEVICE: return MemoryTag::VulkanDevice;
+	default: return MemoryTag::VulkanInstance;
+	}
+}
+
+static VKAPI_ATTR void* VKAPI_CALL vulkanAllocate(
+    void*, size_t size, size_t alignment, VkSystemAllocationScope scope)
+{
+	return Memory_Allocate(size, alignment, getMemoryTag(scope));
+}
+
+static VKAPI_ATTR void* VKAPI_CALL vulkanReallocate(
+    void*, void* original, size_t size, size_t alignment, VkSystemAllocationScope scope)
+{
+	return Memory_Reallocate(original, size, alignment, getMemoryTag(scope));
+}
+
+static VKAPI_ATTR void VKAPI_CALL vulkanFree(void*, void* memory) { Memory_Free(memory); }
+
+static VkAllocationCallbacks g_trackedAllocationCallbacks = {
+    nullptr, vulkanAllocate, vulkanReallocate, vulkanFree, nullptr, nullptr};
+
+static VkAllocationCallbacks* g_allocationCallbacks = &g_trackedAllocationCallbacks;
+
+#else // RUSH_MEMORY_TRACKING
+
 static VkAllocationCallbacks* g_allocationCallbacks = nullptr;
 
+#endif // RUSH_MEMORY_TRACKING
+
+// Contexts may be released by the application after the device, or even during static destruction, so their pool is
+// not owned by the device and is intentionally never destroyed
+static PoolAllocator<GfxContext>& getContextAllocator()
+{
+	static PoolAllocator<GfxContext>* allocator = new PoolAllocator<GfxContext>;
+	return *allocator;
+}
+
 static PFN_vkDebugMarkerSetObjectTagEXT      vkDebugMarkerSetObjectTag         = VK_NULL_HANDLE;
 static PFN_vkDebugMarkerSetObjectNameEXT     vkDebugMarkerSetObjectName        = VK_NULL_HANDLE;
 static PFN_vkCmdDebugMarkerBeginEXT          vkCmdDebugMarkerBegin             = VK_NULL_HANDLE;
@@ -59,6 +108,11 @@ typedef struct VkPipelineShaderStageCreateInfoWaveLimitAMD
 	uint32_t*       cuEnableMask;
 } VkPipelineShaderStageCreateInfoWaveLimitAMD;
 
+struct TechniqueVK::WaveLimitsAMD
+{
+	VkPipelineShaderStageCreateInfoWaveLimitAMD stages[u32(GfxStage::count)];
+};
+
 typedef struct VkPhysicalDeviceWaveLimitPropertiesAMD
 {
 	VkStructureType sType;
@@ -367,6 +421,27 @@ static VkPrimitiveTopology convertPrimitiveType(GfxPrimitive primitiveType)
 	}
 }
 
+// Pipelines with dynamic primitive topology must still be created with a topology of the same class
+static GfxPrimitive getPrimitiveTopologyClass(GfxPrimitive primitiveType)
+{
+	switch (primitiveType)
+	{
+	default: return primitiveType;
+	case GfxPrimitive::LineStrip: return GfxPrimitive::LineList;
+	case GfxPrimitive::TriangleStrip: return GfxPrimitive::TriangleList;
+	}
+}
+
+static VkCullModeFlags convertCullMode(const GfxRasterizerDesc& desc)
+{
+	return desc.cullMode == GfxCullMode::None ? VK_CULL_MODE_NONE : VkCullModeFlags(desc.cullFace);
+}
+
+static VkFrontFace convertFrontFace(const GfxRasterizerDesc& desc)
+{
+	return desc.cullMode == GfxCullMode::CCW ? VK_FRONT_FACE_COUNTER_CLOCKWISE : VK_FRONT_FACE_CLOCKWISE;
+}
+
 static VkSampleCountFlagBits convertSampleCount(u32 samples)
 {
 	switch (samples)
@@ -653,6 +728,9 @@ GfxDevice::GfxDevice(Window* window, const GfxConfig& cfg)
 	m_nvMeshShaderFeatures.pNext = &m_physicalDeviceDescriptorIndexingFeatures;
 	m_physicalDeviceDescriptorIndexingFeatures.pNext = &m_bufferDeviceAddressFeatures;
 	m_bufferDeviceAddressFeatures.pNext = &m_shaderDrawParametersFeatures;
+	m_shaderDrawParametersFeatures.pNext = &m_dynamicRenderingFeatures;
+	m_dynamicRenderingFeatures.pNext = &m_extendedDynamicStateFeatures;
+	m_extendedDynamicStateFeatures.pNext = &m_timelineSemaphoreFeatures;
 
 	vkGetPhysicalDeviceFeatures2(m_physicalDevice, &m_physicalDeviceFeatures2);
 	RUSH_ASSERT(m_physicalDeviceFeatures2.features.shaderClipDistance);
@@ -762,6 +840,7 @@ GfxDevice::GfxDevice(Window* window, const GfxConfig& cfg)
 	m_supportedExtensions.KHR_deferred_host_operations = enableDeviceExtension(VK_KHR_DEFERRED_HOST_OPERATIONS_EXTENSION_NAME, false);
 	m_supportedExtensions.KHR_pipeline_library = enableDeviceExtension(VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME, false);
 	m_supportedExtensions.KHR_buffer_device_address = enableDeviceExtension(VK_KHR_BUFFER_DEVICE_ADDRESS_EXTENSION_NAME, false);
+	m_supportedExtensions.KHR_draw_indirect_count = enableDeviceExtension(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME, false);
 
 	if (enableDeviceExtension(VK_KHR_GET_MEMORY_REQUIREMENTS_2_EXTENSION_NAME, false))
 	{
@@ -786,6 +865,57 @@ GfxDevice::GfxDevice(Window* window, const GfxConfig& cfg)
 
 	m_supportedExtensions.KHR_maintenance1 = enableDeviceExtension(VK_KHR_MAINTENANCE1_EXTENSION_NAME, false);
 
+	// GPU timestamps can be correlated with CPU time if the host clock used by Timer is a calibrateable domain
+	if (vkGetPhysicalDeviceCalibrateableTimeDomainsEXT)
+	{
+#if defined(RUSH_PLATFORM_WINDOWS)
+		const VkTimeDomainEXT hostTimeDomain = VK_TIME_DOMAIN_QUERY_PERFORMANCE_COUNTER_EXT;
+#else
+		const VkTimeDomainEXT hostTimeDomain = VK_TIME_DOMAIN_CLOCK_MONOTONIC_EXT;
+#endif
+
+		u32 timeDomainCount = 0;
+		vkGetPhysicalDeviceCalibrateableTimeDomainsEXT(m_physicalDevice, &timeDomainCount, nullptr);
+		DynamicArray<VkTimeDomainEXT> timeDomains(timeDomainCount);
+		vkGetPhysicalDeviceCalibrateableTimeDomainsEXT(m_physicalDevice, &timeDomainCount, timeDomains.data());
+
+		bool hostDomainSupported   = false;
+		bool deviceDomainSupported = false;
+		for (VkTimeDomainEXT it : timeDomains)
+		{
+			hostDomainSupported |= it == hostTimeDomain;
+			deviceDomainSupported |= it == VK_TIME_DOMAIN_DEVICE_EXT;
+		}
+
+		if (hostDomainSupported && deviceDomainSupported)
+		{
+			m_supportedExtensions.EXT_calibrated_timestamps =
+			    enableDeviceExtension(VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME, false);
+			m_hostTimeDomain = hostTimeDomain;
+		}
+	}
+
+	if (m_dynamicRenderingFeatures.dynamicRendering)
+	{
+		m_supportedExtensions.KHR_dynamic_rendering = m_physicalDeviceProps.apiVersion >= VK_API_VERSION_1_3 ||
+		                                              enableDeviceExtension(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME, false);
+	}
+	m_dynamicRenderingFeatures.dynamicRendering = m_supportedExtensions.KHR_dynamic_rendering;
+
+	if (m_extendedDynamicStateFeatures.extendedDynamicState)
+	{
+		m_supportedExtensions.EXT_extended_dynamic_state =
+		    enableDeviceExtension(VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME, false);
+	}
+	m_extendedDynamicStateFeatures.extendedDynamicState = m_supportedExtensions.EXT_extended_dynamic_state;
+
+	if (m_timelineSemaphoreFeatures.timelineSemaphore)
+	{
+		m_supportedExtensions.KHR_timeline_semaphore = m_physicalDeviceProps.apiVersion >= VK_API_VERSION_1_2 ||
+		                                               enableDeviceExtension(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME, false);
+	}
+	m_timelineSemaphoreFeatures.timelineSemaphore = m_supportedExtensions.KHR_timeline_semaphore;
+
 	void* physicalDeviceProps2Next = nullptr;
 
 	if (m_supportedExtensions.KHR_ray_tracing)
@@ -869,6 +999,33 @@ GfxDevice::GfxDevice(Window* window, const GfxConfig& cfg)
 
 	volkLoadDevice(m_vulkanDevice);
 
+	if (m_supportedExtensions.KHR_dynamic_rendering && !vkCmdBeginRendering)
+	{
+		vkCmdBeginRendering = vkCmdBeginRenderingKHR;
+		vkCmdEndRendering   = vkCmdEndRenderingKHR;
+	}
+
+	if (m_supportedExtensions.EXT_extended_dynamic_state && !vkCmdSetPrimitiveTopology)
+	{
+		vkCmdSetPrimitiveTopology = vkCmdSetPrimitiveTopologyEXT;
+		vkCmdSetCullMode          = vkCmdSetCullModeEXT;
+		vkCmdSetFrontFace         = vkCmdSetFrontFaceEXT;
+		vkCmdSetDepthTestEnable   = vkCmdSetDepthTestEnableEXT;
+		vkCmdSetDepthWriteEnable  = vkCmdSetDepthWriteEnableEXT;
+		vkCmdSetDepthCompareOp    = vkCmdSetDepthCompareOpEXT;
+		vkCmdBindVertexBuffers2   = vkCmdBindVertexBuffers2EXT;
+	}
+
+	if (m_supportedExtensions.KHR_timeline_semaphore && !vkWaitSemaphores)
+	{
+		vkWaitSemaphores = vkWaitSemaphoresKHR;
+	}
+
+	if (m_supportedExtensions.KHR_draw_indirect_count && !vkCmdDrawIndexedIndirectCount)
+	{
+		vkCmdDrawIndexedIndirectCount = vkCmdDrawIndexedIndirectCountKHR;
+	}
+
 	if (debugMerkersAvailable)
 	{
 		vkDebugMarkerSetObjectTag =
@@ -903,6 +1060,29 @@ GfxDevice::GfxDevice(Window* window, const GfxConfig& cfg)
 		RUSH_ASSERT(m_transferQueue);
 	}
 
+	m_queueTimelines[u32(GfxContextType::Graphics)].queue = m_graphicsQueue;
+	m_queueTimelines[u32(GfxContextType::Compute)].queue  = m_computeQueue;
+	m_queueTimelines[u32(GfxContextType::Transfer)].queue = m_transferQueue;
+
+	if (m_supportedExtensions.KHR_timeline_semaphore)
+	{
+		for (QueueTimelineVK& timeline : m_queueTimelines)
+		{
+			if (!timeline.queue)
+				continue;
+
+			VkSemaphoreTypeCreateInfo semaphoreTypeCreateInfo = {VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO};
+			semaphoreTypeCreateInfo.semaphoreType             = VK_SEMAPHORE_TYPE_TIMELINE;
+			semaphoreTypeCreateInfo.initialValue              = 0;
+
+			VkSemaphoreCreateInfo semaphoreCreateInfo = {VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
+			semaphoreCreateInfo.pNext                 = &semaphoreTypeCreateInfo;
+
+			V(vkCreateSemaphore(m_vulkanDevice, &semaphoreCreateInfo, g_allocationCallbacks, &timeline.semaphore));
+			debugRegister(timeline.semaphore, "QueueTimeline");
+		}
+	}
+
 	// Memory types
 
 	memset(&m_deviceMemoryProps, 0, sizeof(m_deviceMemoryProps));
@@ -939,7 +1119,24 @@ GfxDevice::GfxDevice(Window* window, const GfxConfig& cfg)
 
 	// Swap chain
 
-	m_desiredSwapChainImageCount = cfg.minimizeLatency ? 1 : 2;
+	m_desiredPresentInterval = cfg.presentInterval;
+	m_desiredPresentMode     = cfg.presentMode;
+
+	m_maxFramesInFlight = cfg.maxFramesInFlight ? cfg.maxFramesInFlight : (cfg.minimizeLatency ? 1 : 2);
+	m_maxFramesInFlight = clamp<u32>(m_maxFramesInFlight, 1, MaxFramesInFlight);
+
+	if (!m_supportedExtensions.KHR_timeline_semaphore && cfg.maxFramesInFlight)
+	{
+		RUSH_LOG_WARNING("Frame latency limit requires timeline semaphores. Frames in flight are limited by swap chain image count.");
+	}
+
+	// Frame data (descriptor pools, timing pools, memory allocators) is created with the swap chain
+
+	m_pipelineStatisticsEnabled = m_cfg.pipelineStatistics && m_physicalDeviceFeatures2.features.pipelineStatisticsQuery;
+	if (m_cfg.pipelineStatistics && !m_pipelineStatisticsEnabled)
+	{
+		RUSH_LOG_WARNING("Pipeline statistics queries are not supported by this device");
+	}
 
 	createSwapChain();
 
@@ -976,24 +1173,11 @@ GfxDevice::GfxDevice(Window* window, const GfxConfig& cfg)
 	VkPipelineCacheCreateInfo pipelineCacheCreateInfo = {VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO};
 	V(vkCreatePipelineCache(m_vulkanDevice, &pipelineCacheCreateInfo, g_allocationCallbacks, &m_pipelineCache));
 
-	// Frame data (descriptor pools, timing pools, memory allocators)
-
-	for (FrameData& it : m_frameData)
-	{
-		VkQueryPoolCreateInfo timestampPoolCreateInfo = {VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO};
-		timestampPoolCreateInfo.queryCount =
-		    2 * (GfxStats::MaxCustomTimers + 1); // 2 slots per custom timer + 2 slots for total frame time
-		timestampPoolCreateInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
-
-		V(vkCreateQueryPool(m_vulkanDevice, &timestampPoolCreateInfo, g_allocationCallbacks, &it.timestampPool));
-		it.timestampPoolData.resize(timestampPoolCreateInfo.queryCount);
-		it.timestampSlotMap.resize(timestampPoolCreateInfo.queryCount);
-	}
-
 	m_transientLocalAllocator.init(m_memoryTypes.local, false);
 	m_transientHostAllocator.init(m_memoryTypes.host, true);
 
 	m_currentFrame = &m_frameData.back();
+	m_currentDestructionQueue.store(m_currentFrame->destructionQueue.get(), std::memory_order_release);
 
 	{
 		BlendStateVK defaultBlendState;
@@ -1027,6 +1211,7 @@ GfxDevice::GfxDevice(Window* window, const GfxConfig& cfg)
 	m_caps.compute                 = true;
 	m_caps.instancing              = true;
 	m_caps.drawIndirect            = true;
+	m_caps.drawIndirectCount       = m_supportedExtensions.KHR_draw_indirect_count;
 	m_caps.dispatchIndirect        = true;
 	m_caps.pushConstants           = true;
 	m_caps.shaderInt16             = !!m_physicalDeviceFeatures2.features.shaderInt16;
@@ -1034,6 +1219,8 @@ GfxDevice::GfxDevice(Window* window, const GfxConfig& cfg)
 	m_caps.asyncCompute            = m_computeQueueIndex != invalidIndex;
 	m_caps.constantBufferAlignment = u32(m_physicalDeviceProps.limits.minUniformBufferOffsetAlignment);
 
+	m_caps.pipelineStatistics = !!m_physicalDeviceFeatures2.features.pipelineStatisticsQuery;
+
 	m_caps.descriptorIndexing = 
 		!!m_physicalDeviceDescriptorIndexingFeatures.descriptorBindingVariableDescriptorCount &&
 		!!m_physicalDeviceDescriptorIndexingFeatures.shaderSampledImageArrayNonUniformIndexing;
@@ -1126,28 +1313,94 @@ static void extendDescriptorPool(GfxDevice::FrameData* frameData)
 
 struct TransientHostMemoryBlockVK : MemoryBlockVK {};
 
+// Objects are grouped by type and destroyed in batches, in dependency order.
+// Enqueue may be called from any thread, flush is only called by the thread that owns the device.
 struct DestructionQueueVK
 {
 	RUSH_DISALLOW_COPY_AND_ASSIGN(DestructionQueueVK);
 
 	DestructionQueueVK() = default;
-	~DestructionQueueVK() { RUSH_ASSERT(items.empty()); }
-
-	using Item = std::variant<VkPipeline, VkDeviceMemory, VkBuffer, VkImage, VkImageView, VkBufferView, VkSampler,
-	    VkAccelerationStructureKHR, VkQueryPool, VkSemaphore, TransientHostMemoryBlockVK, GfxContext*, DescriptorPoolVK*>;
+	~DestructionQueueVK() { RUSH_ASSERT(empty()); }
+
+	struct Items
+	{
+		DynamicArray<VkPipeline>                 pipelines;
+		DynamicArray<VkImageView>                imageViews;
+		DynamicArray<VkBufferView>               bufferViews;
+		DynamicArray<VkAccelerationStructureKHR> accelerationStructures;
+		DynamicArray<VkBuffer>                   buffers;
+		DynamicArray<VkImage>                    images;
+		DynamicArray<VkDeviceMemory>             memory;
+		DynamicArray<TransientHostMemoryBlockVK> transientHostBlocks;
+		DynamicArray<VkSampler>                  samplers;
+		DynamicArray<VkQueryPool>                queryPools;
+		DynamicArray<VkSemaphore>                semaphores;
+		DynamicArray<GfxContext*>                contexts;
+		DynamicArray<DescriptorPoolVK*>          descriptorPools;
+
+		// Keeps capacity, so that arrays are not reallocated every frame
+		void clear()
+		{
+			pipelines.clear();
+			imageViews.clear();
+			bufferViews.clear();
+			accelerationStructures.clear();
+			buffers.clear();
+			images.clear();
+			memory.clear();
+			transientHostBlocks.clear();
+			samplers.clear();
+			queryPools.clear();
+			semaphores.clear();
+			contexts.clear();
+			descriptorPools.clear();
+		}
+	};
 
-	DynamicArray<Item> items;
+	void push(VkPipeline x) { push(m_items.pipelines, x); }
+	void push(VkImageView x) { push(m_items.imageViews, x); }
+	void push(VkBufferView x) { push(m_items.bufferViews, x); }
+	void push(VkAccelerationStructureKHR x) { push(m_items.accelerationStructures, x); }
+	void push(VkBuffer x) { push(m_items.buffers, x); }
+	void push(VkImage x) { push(m_items.images, x); }
+	void push(VkDeviceMemory x) { push(m_items.memory, x); }
+	void push(const TransientHostMemoryBlockVK& x) { push(m_items.transientHostBlocks, x); }
+	void push(VkSampler x) { push(m_items.samplers, x); }
+	void push(VkQueryPool x) { push(m_items.queryPools, x); }
+	void push(VkSemaphore x) { push(m_items.semaphores, x); }
+	void push(GfxContext* x) { push(m_items.contexts, x); }
+	void push(DescriptorPoolVK* x) { push(m_items.descriptorPools, x); }
 
-	template <typename T> void push(T val)
+	bool empty() const
 	{
-		items.push(val);
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_count == 0;
 	}
 
-	void flush(GfxDevice* device);
+	// Returns number of destroyed objects
+	u32 flush(GfxDevice* device);
+
+private:
+	Items              m_items;
+	u32                m_count = 0;
+	mutable std::mutex m_mutex;
+
+	// Objects being destroyed by flush(), swapped with m_items so that both sets of arrays keep their capacity
+	Items m_batch;
+
+	template <typename T> void push(DynamicArray<T>& array, const T& x)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		array.push_back(x);
+		++m_count;
+	}
 };
 
 template <typename T> void enqueueDestroy(GfxDevice::FrameData* frame, T x) { frame->destructionQueue->push(x); }
-template <typename T> void enqueueDestroy(T x) { enqueueDestroy(g_device->m_currentFrame, x); }
+template <typename T> void enqueueDestroy(T x)
+{
+	g_device->m_currentDestructionQueue.load(std::memory_order_acquire)->push(x);
+}
 
 GfxDevice::~GfxDevice()
 {
@@ -1203,6 +1456,16 @@ GfxDevice::~GfxDevice()
 
 		vkDestroyQueryPool(m_vulkanDevice, it.timestampPool, g_allocationCallbacks);
 
+		if (it.statisticsPool)
+		{
+			vkDestroyQueryPool(m_vulkanDevice, it.statisticsPool, g_allocationCallbacks);
+		}
+
+		if (it.asyncComputeTimestampPool)
+		{
+			vkDestroyQueryPool(m_vulkanDevice, it.asyncComputeTimestampPool, g_allocationCallbacks);
+		}
+
 		if (it.presentCompleteSemaphore)
 		{
 			vkDestroySemaphore(m_vulkanDevice, it.presentCompleteSemaphore, g_allocationCallbacks);
@@ -1253,6 +1516,12 @@ GfxDevice::~GfxDevice()
 	}
 	m_semaphorePool.clear();
 
+	for (QueueTimelineVK& timeline : m_queueTimelines)
+	{
+		vkDestroySemaphore(m_vulkanDevice, timeline.semaphore, g_allocationCallbacks);
+		timeline.semaphore = VK_NULL_HANDLE;
+	}
+
 	vkDestroySurfaceKHR(m_vulkanInstance, m_swapChainSurface, g_allocationCallbacks);
 	vkDestroyDevice(m_vulkanDevice, g_allocationCallbacks);
 
@@ -1277,6 +1546,8 @@ VkPipeline GfxDevice::createPipeline(const PipelineInfoVK& info)
 {
 	RUSH_ASSERT(info.techniqueHandle.valid());
 
+	const bool useDynamicState = m_supportedExtensions.EXT_extended_dynamic_state;
+
 	PipelineKey key = {};
 	key.techniqueId = g_device->m_resources.techniques[info.techniqueHandle].getId();
 
@@ -1293,6 +1564,40 @@ VkPipeline GfxDevice::createPipeline(const PipelineInfoVK& info)
 		key.colorAttachmentCount = info.colorAttachmentCount;
 		key.colorSampleCount     = info.colorSampleCount;
 		key.depthSampleCount     = info.depthSampleCount;
+		key.depthStencilFormat   = info.depthStencilFormat;
+		for (u32 i = 0; i < info.colorAttachmentCount; ++i)
+		{
+			key.colorFormats[i] = info.colorFormats[i];
+		}
+
+		if (useDynamicState)
+		{
+			// Full key is tracked to report how many pipelines would exist without dynamic state
+			m_pipelinePermutations.insert(key);
+
+			// Topology, cull mode, depth state and vertex strides are set via dynamic state
+			const GfxRasterizerDesc& rasterizerDesc = m_resources.rasterizerStates[info.rasterizerStateHandle].desc;
+
+			key.depthStencilStateId = 0;
+			key.rasterizerStateId   = 0;
+			key.fillMode            = rasterizerDesc.fillMode;
+			key.depthBias           = rasterizerDesc.depthBias;
+			key.depthBiasSlopeScale = rasterizerDesc.depthBiasSlopeScale;
+			key.primitiveType       = getPrimitiveTopologyClass(info.primitiveType);
+			for (u32 i = 0; i < RUSH_COUNTOF(key.vertexBufferStride); ++i)
+			{
+				key.vertexBufferStride[i] = 0;
+			}
+		}
+	}
+	else if (useDynamicState)
+	{
+		m_pipelinePermutations.insert(key);
+	}
+
+	if (useDynamicState)
+	{
+		m_stats.pipelinePermutations = u32(m_pipelinePermutations.size());
 	}
 
 	auto existingPipeline = m_pipelines.find(key);
@@ -1423,10 +1728,8 @@ VkPipeline GfxDevice::createPipeline(const PipelineInfoVK& info)
 		rs.rasterizerDiscardEnable                = false;
 		rs.polygonMode = rasterizerDesc.fillMode == GfxFillMode::Solid ? VK_POLYGON_MODE_FILL : VK_POLYGON_MODE_LINE;
 
-		rs.cullMode = rasterizerDesc.cullMode == GfxCullMode::None ? VK_CULL_MODE_NONE
-		                                                           : VkCullModeFlagBits(rasterizerDesc.cullFace);
-		rs.frontFace =
-		    rasterizerDesc.cullMode == GfxCullMode::CCW ? VK_FRONT_FACE_COUNTER_CLOCKWISE : VK_FRONT_FACE_CLOCKWISE;
+		rs.cullMode  = convertCullMode(rasterizerDesc);
+		rs.frontFace = convertFrontFace(rasterizerDesc);
 
 		rs.depthBiasEnable         = rasterizerDesc.depthBias != 0;
 		rs.depthBiasConstantFactor = rasterizerDesc.depthBias;
@@ -1493,22 +1796,64 @@ VkPipeline GfxDevice::createPipeline(const PipelineInfoVK& info)
 		VkPipelineDynamicStateCreateInfo dyn = {VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO};
 		createInfo.pDynamicState             = &dyn;
 
-		StaticArray<VkDynamicState, 3> dynamicStates;
+		StaticArray<VkDynamicState, 10> dynamicStates;
 		dynamicStates.pushBack(VK_DYNAMIC_STATE_VIEWPORT);
 		dynamicStates.pushBack(VK_DYNAMIC_STATE_SCISSOR);
 		if (m_caps.sampleLocations)
 		{
 			dynamicStates.pushBack(VK_DYNAMIC_STATE_SAMPLE_LOCATIONS_EXT);
 		}
+		if (m_supportedExtensions.EXT_extended_dynamic_state)
+		{
+			dynamicStates.pushBack(VK_DYNAMIC_STATE_PRIMITIVE_TOPOLOGY);
+			dynamicStates.pushBack(VK_DYNAMIC_STATE_CULL_MODE);
+			dynamicStates.pushBack(VK_DYNAMIC_STATE_FRONT_FACE);
+			dynamicStates.pushBack(VK_DYNAMIC_STATE_DEPTH_TEST_ENABLE);
+			dynamicStates.pushBack(VK_DYNAMIC_STATE_DEPTH_WRITE_ENABLE);
+			dynamicStates.pushBack(VK_DYNAMIC_STATE_DEPTH_COMPARE_OP);
+			if (technique.vertexStreamCount)
+			{
+				dynamicStates.pushBack(VK_DYNAMIC_STATE_VERTEX_INPUT_BINDING_STRIDE);
+			}
+		}
 		dyn.dynamicStateCount = u32(dynamicStates.currentSize);
 		dyn.pDynamicStates    = dynamicStates.data;
 
 		// render pass
 
-		RUSH_ASSERT(info.renderPass);
+		VkPipelineRenderingCreateInfo renderingInfo = {VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO};
+		VkFormat colorAttachmentFormats[GfxPassDesc::MaxTargets] = {};
+
+		if (m_supportedExtensions.KHR_dynamic_rendering)
+		{
+			for (u32 i = 0; i < info.colorAttachmentCount; ++i)
+			{
+				colorAttachmentFormats[i] = convertFormat(info.colorFormats[i]);
+			}
+
+			renderingInfo.colorAttachmentCount    = info.colorAttachmentCount;
+			renderingInfo.pColorAttachmentFormats = colorAttachmentFormats;
+
+			const u32 depthStencilComponents = getGfxFormatComponent(info.depthStencilFormat);
+			if (depthStencilComponents & GfxFormatComponent_Depth)
+			{
+				renderingInfo.depthAttachmentFormat = convertFormat(info.depthStencilFormat);
+			}
+			if (depthStencilComponents & GfxFormatComponent_Stencil)
+			{
+				renderingInfo.stencilAttachmentFormat = convertFormat(info.depthStencilFormat);
+			}
+
+			renderingInfo.pNext = createInfo.pNext;
+			createInfo.pNext    = &renderingInfo;
+		}
+		else
+		{
+			RUSH_ASSERT(info.renderPass);
 
-		createInfo.renderPass = info.renderPass;
-		createInfo.subpass    = 0;
+			createInfo.renderPass = info.renderPass;
+			createInfo.subpass    = 0;
+		}
 
 		// setup done
 
@@ -1519,6 +1864,12 @@ VkPipeline GfxDevice::createPipeline(const PipelineInfoVK& info)
 
 	m_pipelines.insert(std::make_pair(key, pipeline));
 
+	m_stats.pipelines = u32(m_pipelines.size());
+	if (!useDynamicState)
+	{
+		m_stats.pipelinePermutations = m_stats.pipelines;
+	}
+
 	return pipeline;
 }
 
@@ -1774,28 +2125,56 @@ void GfxDevice::createSwapChain()
 		       m_availablePresentModes.end();
 	};
 
-	VkPresentModeKHR pendingPresentMode = VK_PRESENT_MODE_FIFO_KHR;
+	// Candidates in order of preference, FIFO is always supported and terminates every list
+	static const VkPresentModeKHR defaultVsyncModes[] = {VK_PRESENT_MODE_FIFO_KHR};
+	static const VkPresentModeKHR defaultNoVsyncModes[] = {VK_PRESENT_MODE_IMMEDIATE_KHR,
+	    VK_PRESENT_MODE_FIFO_RELAXED_KHR, VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_FIFO_KHR};
+	static const VkPresentModeKHR fifoRelaxedModes[] = {VK_PRESENT_MODE_FIFO_RELAXED_KHR, VK_PRESENT_MODE_FIFO_KHR};
+	static const VkPresentModeKHR mailboxModes[] = {
+	    VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_FIFO_KHR};
+	static const VkPresentModeKHR immediateModes[] = {VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_MAILBOX_KHR,
+	    VK_PRESENT_MODE_FIFO_RELAXED_KHR, VK_PRESENT_MODE_FIFO_KHR};
 
-	if (m_desiredPresentInterval == 0)
+	ArrayView<const VkPresentModeKHR> candidatePresentModes;
+	switch (m_desiredPresentMode)
 	{
-		if (presentModeSupported(VK_PRESENT_MODE_IMMEDIATE_KHR))
-		{
-			pendingPresentMode = VK_PRESENT_MODE_IMMEDIATE_KHR;
-		}
-		else if (presentModeSupported(VK_PRESENT_MODE_FIFO_RELAXED_KHR))
-		{
-			pendingPresentMode = VK_PRESENT_MODE_FIFO_RELAXED_KHR;
-		}
-		else if (presentModeSupported(VK_PRESENT_MODE_MAILBOX_KHR))
+	default:
+	case GfxPresentMode::Default:
+		if (m_desiredPresentInterval == 0)
+			candidatePresentModes = defaultNoVsyncModes;
+		else
+			candidatePresentModes = defaultVsyncModes;
+		break;
+	case GfxPresentMode::Fifo: candidatePresentModes = defaultVsyncModes; break;
+	case GfxPresentMode::FifoRelaxed: candidatePresentModes = fifoRelaxedModes; break;
+	case GfxPresentMode::Mailbox: candidatePresentModes = mailboxModes; break;
+	case GfxPresentMode::Immediate: candidatePresentModes = immediateModes; break;
+	}
+
+	VkPresentModeKHR pendingPresentMode = VK_PRESENT_MODE_FIFO_KHR;
+	for (VkPresentModeKHR mode : candidatePresentModes)
+	{
+		if (presentModeSupported(mode))
 		{
-			pendingPresentMode = VK_PRESENT_MODE_MAILBOX_KHR;
+			pendingPresentMode = mode;
+			break;
 		}
 	}
 
 	RUSH_ASSERT(presentModeSupported(pendingPresentMode));
 
-	// FIXME: clamp desiredSwapChainImageCount to surfCaps.maxImageCount when maxImageCount > 0.
-	u32 desiredSwapChainImageCount = max<u32>(m_desiredSwapChainImageCount, surfCaps.minImageCount);
+	// Mailbox needs a spare image to replace frames waiting for vertical blank
+	u32 desiredSwapChainImageCount = m_cfg.minimizeLatency ? 1 : 2;
+	if (pendingPresentMode == VK_PRESENT_MODE_MAILBOX_KHR)
+	{
+		desiredSwapChainImageCount = 3;
+	}
+
+	desiredSwapChainImageCount = max<u32>(desiredSwapChainImageCount, surfCaps.minImageCount);
+	if (surfCaps.maxImageCount)
+	{
+		desiredSwapChainImageCount = min<u32>(desiredSwapChainImageCount, surfCaps.maxImageCount);
+	}
 
 	auto enumeratedSurfaceFormats = enumerateSurfaceFormats(m_physicalDevice, m_swapChainSurface);
 
@@ -1848,9 +2227,24 @@ void GfxDevice::createSwapChain()
 	u32 swapChainImageCount = 0;
 	V(vkGetSwapchainImagesKHR(m_vulkanDevice, m_swapChain, &swapChainImageCount, nullptr));
 
-	RUSH_ASSERT(m_frameData.empty() || m_frameData.size() == swapChainImageCount);
+	// Frame data is indexed by swap chain image and only ever grows, as frames left over from a larger swap chain may
+	// still own resources in flight. Those are retired by beginFrame().
+	if (swapChainImageCount > m_frameData.size())
+	{
+		const size_t currentFrameIndex = m_currentFrame ? size_t(m_currentFrame - m_frameData.data()) : 0;
+		const size_t oldFrameCount     = m_frameData.size();
+
+		m_frameData.resize(swapChainImageCount);
+		for (size_t i = oldFrameCount; i < m_frameData.size(); ++i)
+		{
+			initFrameData(m_frameData[i]);
+		}
 
-	m_frameData.resize(swapChainImageCount);
+		if (m_currentFrame)
+		{
+			m_currentFrame = &m_frameData[currentFrameIndex];
+		}
+	}
 	for (auto& it : m_frameData)
 	{
 		if (it.presentCompleteSemaphore)
@@ -1896,6 +2290,7 @@ void GfxDevice::createSwapChain()
 	}
 
 	m_presentInterval      = m_desiredPresentInterval;
+	m_presentMode          = m_desiredPresentMode;
 	m_swapChainPresentMode = pendingPresentMode;
 
 	m_swapChainValid = true;
@@ -1903,16 +2298,76 @@ void GfxDevice::createSwapChain()
 
 GfxDevice::FrameData::FrameData() : destructionQueue(new DestructionQueueVK) {}
 
+void GfxDevice::initFrameData(FrameData& frame)
+{
+	VkQueryPoolCreateInfo timestampPoolCreateInfo = {VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO};
+	timestampPoolCreateInfo.queryCount            = TimestampPoolSize;
+	timestampPoolCreateInfo.queryType             = VK_QUERY_TYPE_TIMESTAMP;
+
+	V(vkCreateQueryPool(m_vulkanDevice, &timestampPoolCreateInfo, g_allocationCallbacks, &frame.timestampPool));
+	frame.timestampPoolData.resize(timestampPoolCreateInfo.queryCount);
+	frame.timestampSlotMap.resize(2 * (GfxStats::MaxCustomTimers + 1));
+	frame.gpuZones.reserve(MaxGpuZonesPerFrame);
+
+	if (m_pipelineStatisticsEnabled)
+	{
+		// Results are written in bit order, see resolvePassStats()
+		VkQueryPoolCreateInfo statisticsPoolCreateInfo = {VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO};
+		statisticsPoolCreateInfo.queryCount            = MaxPassStatsPerFrame;
+		statisticsPoolCreateInfo.queryType             = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+		statisticsPoolCreateInfo.pipelineStatistics =
+		    VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+		    VK_QUERY_PIPELINE_STATISTIC_CLIPPING_INVOCATIONS_BIT |
+		    VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+		    VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT |
+		    VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
+
+		V(vkCreateQueryPool(m_vulkanDevice, &statisticsPoolCreateInfo, g_allocationCallbacks, &frame.statisticsPool));
+	}
+	frame.passStats.reserve(MaxPassStatsPerFrame);
+	frame.passStatsQueries.reserve(MaxPassStatsPerFrame);
+
+	if (m_computeQueue && m_queueProps[m_computeQueueIndex].timestampValidBits)
+	{
+		VkQueryPoolCreateInfo asyncComputePoolCreateInfo = {VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO};
+		asyncComputePoolCreateInfo.queryCount            = 2 * MaxAsyncComputePerFrame;
+		asyncComputePoolCreateInfo.queryType             = VK_QUERY_TYPE_TIMESTAMP;
+
+		V(vkCreateQueryPool(
+		    m_vulkanDevice, &asyncComputePoolCreateInfo, g_allocationCallbacks, &frame.asyncComputeTimestampPool));
+		frame.asyncComputeTimestampData.reserve(asyncComputePoolCreateInfo.queryCount);
+	}
+}
+
 inline void recycleContext(GfxContext* context)
 {
 	GfxContext* temp = allocateContext(context->m_type, "Recycled");
 
+	// Recycled command buffer must not be reused until its last submission completes.
+	// Context continues with a fresh command buffer, so it must not wait for the submission either.
 	std::swap(context->m_commandBuffer, temp->m_commandBuffer);
 	std::swap(context->m_fence, temp->m_fence);
+	std::swap(context->m_lastSubmission, temp->m_lastSubmission);
 
 	enqueueDestroy(temp);
 }
 
+void GfxDevice::waitForFrameLatency()
+{
+	m_frameLatencyWaited = true;
+
+	if (m_presentedFrameCount < m_maxFramesInFlight)
+	{
+		return;
+	}
+
+	const InFlightFrame& frame = m_inFlightFrames[(m_presentedFrameCount - m_maxFramesInFlight) % MaxFramesInFlight];
+
+	const double waitStartTime = Timer::global.time();
+	waitForTimelineValues(frame.timelineValues);
+	m_stats.frameLatencyWaitTime += Timer::global.time() - waitStartTime;
+}
+
 void GfxDevice::beginFrame()
 {
 	if (!m_swapChainValid && m_window->isFocused())
@@ -1920,14 +2375,26 @@ void GfxDevice::beginFrame()
 		createSwapChain();
 	}
 
+	// Waiting before acquiring the next image keeps the CPU from running ahead even when
+	// acquisition does not block (e.g. mailbox or immediate present modes)
+	if (!m_frameLatencyWaited)
+	{
+		waitForFrameLatency();
+	}
+	m_frameLatencyWaited = false;
+
 	if (m_swapChainValid)
 	{
 		VkSemaphore presentCompleteSemaphore = allocSemaphore();
 
+		const double acquireStartTime = Timer::global.time();
+
 		u32      nextSwapChainIndex = ~0u;
 		VkResult result             = vkAcquireNextImageKHR(
             m_vulkanDevice, m_swapChain, UINT64_MAX, presentCompleteSemaphore, VK_NULL_HANDLE, &nextSwapChainIndex);
 
+		m_stats.acquireWaitTime += Timer::global.time() - acquireStartTime;
+
 		bool success = false;
 		switch (result)
 		{
@@ -1966,27 +2433,51 @@ void GfxDevice::beginFrame()
 		m_swapChainIndex = nextSwapChainIndex;
 	}
 
-	m_currentFrame             = &m_frameData[m_swapChainIndex];
+	m_currentFrame = &m_frameData[m_swapChainIndex];
+
+	retireFrame(*m_currentFrame);
+
 	m_currentFrame->frameIndex = g_device->m_frameCount;
 
-	if (m_currentFrame->lastGraphicsFence)
+	// Frames left over from a swap chain with more images are never current again
+	for (size_t i = m_swapChainImages.size(); i < m_frameData.size(); ++i)
+	{
+		retireFrame(m_frameData[i]);
+	}
+
+	m_currentDestructionQueue.store(m_currentFrame->destructionQueue.get(), std::memory_order_release);
+
+	m_transientLocalAllocator.reset();
+
+	extendDescriptorPool(m_currentFrame);
+}
+
+void GfxDevice::retireFrame(FrameData& frame)
+{
+	if (m_supportedExtensions.KHR_timeline_semaphore)
+	{
+		waitForTimelineValues(frame.retireTimelineValues);
+	}
+	else if (frame.lastGraphicsSubmission.fence)
 	{
-		V(vkWaitForFences(g_vulkanDevice, 1, &m_currentFrame->lastGraphicsFence, true, UINT64_MAX));
-		m_currentFrame->lastGraphicsFence = VK_NULL_HANDLE;
+		V(vkWaitForFences(g_vulkanDevice, 1, &frame.lastGraphicsSubmission.fence, true, UINT64_MAX));
 	}
+	frame.lastGraphicsSubmission = SubmissionVK();
 
-	m_currentFrame->destructionQueue->flush(this);
+	frame.destructionQueue->flush(this);
 
-	for (auto& it : m_currentFrame->descriptorPools)
+	for (auto& it : frame.descriptorPools)
 	{
 		it.reset();
-		m_currentFrame->availableDescriptorPools.push_back(std::move(it));
+		frame.availableDescriptorPools.push_back(std::move(it));
 	}
-	m_currentFrame->descriptorPools.clear();
-
-	m_transientLocalAllocator.reset();
+	frame.descriptorPools.clear();
 
-	extendDescriptorPool(m_currentFrame);
+	// Graphics submissions complete in order, so all earlier frames are retired as well
+	if (frame.frameIndex != ~0u)
+	{
+		m_retiredFrameCount = max(m_retiredFrameCount, frame.frameIndex + 1);
+	}
 }
 
 void GfxDevice::endFrame() 
@@ -2031,6 +2522,9 @@ void MemoryAllocatorVK::init(u32 memoryType, bool hostVisible)
 
 MemoryBlockVK MemoryAllocatorVK::alloc(u64 size, u64 alignment)
 {
+	// All allocators of this type are per-frame linear allocators
+	g_device->m_stats.transientAllocations++;
+
 	for (;;)
 	{
 		if (m_availableBlocks.empty())
@@ -2206,10 +2700,13 @@ GfxContext::GfxContext(GfxDevice* device, GfxContextType contextType)
 	memset(&m_pending.constantBufferOffsets, 0, sizeof(m_pending.constantBufferOffsets));
 	memset(&m_pending.vertexBufferStride, 0, sizeof(m_pending.vertexBufferStride));
 
-	VkFenceCreateInfo fenceCreateInfo = {VK_STRUCTURE_TYPE_FENCE_CREATE_INFO};
-	fenceCreateInfo.flags             = VK_FENCE_CREATE_SIGNALED_BIT;
-	vkCreateFence(m_vulkanDevice, &fenceCreateInfo, g_allocationCallbacks, &m_fence);
-	debugRegister(m_fence, "GfxContext::m_fence");
+	if (!m_device->m_supportedExtensions.KHR_timeline_semaphore)
+	{
+		VkFenceCreateInfo fenceCreateInfo = {VK_STRUCTURE_TYPE_FENCE_CREATE_INFO};
+		fenceCreateInfo.flags             = VK_FENCE_CREATE_SIGNALED_BIT;
+		vkCreateFence(m_vulkanDevice, &fenceCreateInfo, g_allocationCallbacks, &m_fence);
+		debugRegister(m_fence, "GfxContext::m_fence");
+	}
 
 	VkCommandBufferAllocateInfo allocateInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO};
 	allocateInfo.commandPool                 = commandPool;
@@ -2218,14 +2715,17 @@ GfxContext::GfxContext(GfxDevice* device, GfxContextType contextType)
 
 	V(vkAllocateCommandBuffers(m_vulkanDevice, &allocateInfo, &m_commandBuffer));
 
-	VkSemaphoreCreateInfo semaphoreCreateInfo = {VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
-	V(vkCreateSemaphore(m_vulkanDevice, &semaphoreCreateInfo, g_allocationCallbacks, &m_completionSemaphore));
-	debugRegister(m_fence, "GfxContext::m_completionSemaphore");
+	if (!m_device->m_supportedExtensions.KHR_timeline_semaphore)
+	{
+		VkSemaphoreCreateInfo semaphoreCreateInfo = {VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
+		V(vkCreateSemaphore(m_vulkanDevice, &semaphoreCreateInfo, g_allocationCallbacks, &m_completionSemaphore));
+		debugRegister(m_completionSemaphore, "GfxContext::m_completionSemaphore");
+	}
 }
 
 GfxContext::~GfxContext()
 {
-	V(vkWaitForFences(m_vulkanDevice, 1, &m_fence, true, UINT64_MAX));
+	waitForCompletion();
 
 	VkCommandPool commandPool = getCommandPoolByContextType(m_device, m_type);
 
@@ -2244,8 +2744,12 @@ void GfxContext::beginBuild()
 
 	m_lastUsedFrame = m_device->m_frameCount;
 
-	V(vkWaitForFences(m_vulkanDevice, 1, &m_fence, true, UINT64_MAX));
-	V(vkResetFences(m_vulkanDevice, 1, &m_fence));
+	waitForCompletion();
+
+	if (m_fence)
+	{
+		V(vkResetFences(m_vulkanDevice, 1, &m_fence));
+	}
 
 	VkCommandBufferBeginInfo beginInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
 	V(vkBeginCommandBuffer(m_commandBuffer, &beginInfo));
@@ -2254,11 +2758,16 @@ void GfxContext::beginBuild()
 	m_dirtyState         = 0xFFFFFFFF;
 	m_isRenderPassActive = false;
 
-	m_currentFrameBuffer          = VK_NULL_HANDLE;
+	m_currentDescriptorSet = VK_NULL_HANDLE;
+	m_currentBindPoint     = VK_PIPELINE_BIND_POINT_MAX_ENUM;
+	m_boundDescriptorSet   = BoundDescriptorSetInfo();
+	m_dynamicState         = DynamicStateVK();
+
 	m_currentRenderPass           = VK_NULL_HANDLE;
 	m_currentColorAttachmentCount = 0;
 
 	m_waitSemaphores.clear();
+	m_waitValues.clear();
 	m_waitDstStageMasks.clear();
 
 	m_useCompletionSemaphore = false;
@@ -2267,6 +2776,7 @@ void GfxContext::beginBuild()
 void GfxContext::endBuild()
 {
 	flushBarriers();
+	endPassStats();
 
 	RUSH_ASSERT(m_isActive);
 	m_isActive = false;
@@ -2281,10 +2791,37 @@ void GfxContext::addDependency(VkSemaphore waitSemaphore, VkPipelineStageFlags w
 	RUSH_ASSERT(waitSemaphore != VK_NULL_HANDLE);
 
 	m_waitSemaphores.push_back(waitSemaphore);
+	m_waitValues.push_back(0); // ignored for binary semaphores
 	m_waitDstStageMasks.push_back(waitDstStageMask);
 }
 
-void GfxContext::split()
+void GfxContext::addDependency(const SubmissionVK& submission, VkPipelineStageFlags waitDstStageMask)
+{
+	RUSH_ASSERT_MSG(submission.semaphore != VK_NULL_HANDLE,
+	    "Dependent submission must signal a semaphore (set m_useCompletionSemaphore before submitting).");
+
+	m_waitSemaphores.push_back(submission.semaphore);
+	m_waitValues.push_back(submission.value);
+	m_waitDstStageMasks.push_back(waitDstStageMask);
+}
+
+void GfxContext::waitForCompletion()
+{
+	if (m_fence)
+	{
+		V(vkWaitForFences(m_vulkanDevice, 1, &m_fence, true, UINT64_MAX));
+	}
+	else if (m_lastSubmission.value)
+	{
+		VkSemaphoreWaitInfo waitInfo = {VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO};
+		waitInfo.semaphoreCount      = 1;
+		waitInfo.pSemaphores         = &m_lastSubmission.semaphore;
+		waitInfo.pValues             = &m_lastSubmission.value;
+		V(vkWaitSemaphores(m_vulkanDevice, &waitInfo, UINT64_MAX));
+	}
+}
+
+SubmissionVK GfxContext::split()
 {
 	RUSH_ASSERT_MSG(m_type == GfxContextType::Graphics, "Splitting only implemented for graphics contexts.");
 
@@ -2292,9 +2829,13 @@ void GfxContext::split()
 
 	submit(m_device->m_graphicsQueue);
 
+	SubmissionVK submission = m_lastSubmission;
+
 	recycleContext(this);
 
 	beginBuild();
+
+	return submission;
 }
 
 void GfxContext::submit(VkQueue queue)
@@ -2314,125 +2855,167 @@ void GfxContext::submit(VkQueue queue)
 
 	submitInfo.waitSemaphoreCount   = (u32)m_waitSemaphores.size();
 	submitInfo.pWaitSemaphores      = m_waitSemaphores.data();
-	submitInfo.pSignalSemaphores    = &m_completionSemaphore;
-	submitInfo.signalSemaphoreCount = m_useCompletionSemaphore ? 1 : 0;
 	submitInfo.commandBufferCount   = 1;
 	submitInfo.pCommandBuffers      = &m_commandBuffer;
 	submitInfo.pWaitDstStageMask    = m_waitDstStageMasks.data();
 
-	V(vkQueueSubmit(queue, 1, &submitInfo, m_fence));
-}
+	m_lastSubmission = SubmissionVK();
 
-VkImageLayout GfxContext::addImageBarrier(VkImage image,
-	VkImageLayout currentLayout, VkImageLayout nextLayout,
-    VkImageSubresourceRange* subresourceRange, bool force)
-{
-	if (currentLayout == nextLayout && !force)
+	if (GfxDevice::QueueTimelineVK* timeline = m_device->getQueueTimeline(queue))
 	{
-		return nextLayout;
-	}
+		m_lastSubmission.semaphore = timeline->semaphore;
+		m_lastSubmission.value     = ++timeline->submittedValue;
 
-	for (const VkImageMemoryBarrier& imageBarrier : m_pendingBarriers.imageBarriers)
-	{
-		if (imageBarrier.image == image)
-		{
-			flushBarriers();
-		}
-	}
-
-	// TODO: track subresource states
-	// TODO: initialize default subresource range to cover entire image
-	// FIXME: default range only covers one mip/layer; callers without explicit range can miss subresources.
-	VkImageSubresourceRange defaultSubresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+		VkTimelineSemaphoreSubmitInfo timelineInfo = {VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO};
+		timelineInfo.waitSemaphoreValueCount       = (u32)m_waitValues.size();
+		timelineInfo.pWaitSemaphoreValues          = m_waitValues.data();
+		timelineInfo.signalSemaphoreValueCount     = 1;
+		timelineInfo.pSignalSemaphoreValues        = &m_lastSubmission.value;
 
-	VkImageMemoryBarrier barrierDesc = {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
-	barrierDesc.srcAccessMask        = 0;
-	barrierDesc.dstAccessMask        = 0;
-	barrierDesc.oldLayout            = currentLayout;
-	barrierDesc.newLayout            = nextLayout;
-	barrierDesc.srcQueueFamilyIndex  = VK_QUEUE_FAMILY_IGNORED;
-	barrierDesc.dstQueueFamilyIndex  = VK_QUEUE_FAMILY_IGNORED;
-	barrierDesc.subresourceRange     = subresourceRange ? *subresourceRange : defaultSubresourceRange;
-	barrierDesc.image                = image;
+		submitInfo.pNext                = &timelineInfo;
+		submitInfo.signalSemaphoreCount = 1;
+		submitInfo.pSignalSemaphores    = &timeline->semaphore;
 
-	// conservative default flags
-	VkPipelineStageFlagBits srcStageMask = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
-	VkPipelineStageFlagBits dstStageMask = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+		V(vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE));
+	}
+	else
+	{
+		m_lastSubmission.fence     = m_fence;
+		m_lastSubmission.semaphore = m_useCompletionSemaphore ? m_completionSemaphore : VK_NULL_HANDLE;
 
-	// current layout
+		submitInfo.signalSemaphoreCount = m_useCompletionSemaphore ? 1 : 0;
+		submitInfo.pSignalSemaphores    = &m_completionSemaphore;
 
-	// TODO: move layout->flags conversion into a function
+		V(vkQueueSubmit(queue, 1, &submitInfo, m_fence));
+	}
+}
 
-	switch (currentLayout)
+static void getImageLayoutSrcFlags(VkImageLayout layout, VkAccessFlags& accessMask, VkPipelineStageFlags& stageMask)
+{
+	switch (layout)
 	{
 	default: RUSH_LOG_ERROR("Unexpected layout"); break;
 	case VK_IMAGE_LAYOUT_UNDEFINED:
 		// nothing
 		break;
-	case VK_IMAGE_LAYOUT_PREINITIALIZED: barrierDesc.srcAccessMask |= VK_ACCESS_HOST_WRITE_BIT; break;
+	case VK_IMAGE_LAYOUT_PREINITIALIZED: accessMask |= VK_ACCESS_HOST_WRITE_BIT; break;
 	case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
-		barrierDesc.srcAccessMask |= VK_ACCESS_SHADER_READ_BIT;
-		srcStageMask =
-		    VkPipelineStageFlagBits(VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+		accessMask |= VK_ACCESS_SHADER_READ_BIT;
+		stageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
 		break;
 	case VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL:
-		barrierDesc.srcAccessMask |= VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-		srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		accessMask |= VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		stageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
 		break;
-	case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL: barrierDesc.srcAccessMask |= VK_ACCESS_TRANSFER_READ_BIT; break;
-	case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL: barrierDesc.srcAccessMask |= VK_ACCESS_TRANSFER_WRITE_BIT; break;
+	case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL: accessMask |= VK_ACCESS_TRANSFER_READ_BIT; break;
+	case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL: accessMask |= VK_ACCESS_TRANSFER_WRITE_BIT; break;
 	case VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL:
-		barrierDesc.srcAccessMask |=
-		    VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT;
-		srcStageMask = VkPipelineStageFlagBits(
-		    VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT);
+		accessMask |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT;
+		stageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
 		break;
 	case VK_IMAGE_LAYOUT_GENERAL:
-		barrierDesc.srcAccessMask |= VK_ACCESS_SHADER_WRITE_BIT;
-		srcStageMask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		accessMask |= VK_ACCESS_SHADER_WRITE_BIT;
+		stageMask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
 		break;
 	case VK_IMAGE_LAYOUT_PRESENT_SRC_KHR:
-		barrierDesc.srcAccessMask |= VK_ACCESS_MEMORY_READ_BIT;
-		srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		accessMask |= VK_ACCESS_MEMORY_READ_BIT;
+		stageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
 		break;
 	}
+}
 
-	switch (nextLayout)
+static void getImageLayoutDstFlags(VkImageLayout layout, VkAccessFlags& accessMask, VkPipelineStageFlags& stageMask)
+{
+	switch (layout)
 	{
 	default: RUSH_LOG_ERROR("Unexpected layout"); break;
 	case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
-		barrierDesc.dstAccessMask |= VK_ACCESS_SHADER_READ_BIT;
+		accessMask |= VK_ACCESS_SHADER_READ_BIT;
 		// TODO: vertex shader read?
-		dstStageMask =
-		    VkPipelineStageFlagBits(VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+		stageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
 		break;
 	case VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL:
-		barrierDesc.dstAccessMask |= VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-		dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		accessMask |= VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		stageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
 		break;
 	case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL:
-		barrierDesc.dstAccessMask |= VK_ACCESS_TRANSFER_READ_BIT;
-		dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+		accessMask |= VK_ACCESS_TRANSFER_READ_BIT;
+		stageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
 		break;
 	case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL:
-		barrierDesc.dstAccessMask |= VK_ACCESS_TRANSFER_WRITE_BIT;
-		dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+		accessMask |= VK_ACCESS_TRANSFER_WRITE_BIT;
+		stageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
 		break;
 	case VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL:
-		barrierDesc.dstAccessMask |=
-		    VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT;
-		dstStageMask = VkPipelineStageFlagBits(
-		    VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT);
+		accessMask |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT;
+		stageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
 		break;
 	case VK_IMAGE_LAYOUT_GENERAL:
-		barrierDesc.dstAccessMask |= VK_ACCESS_SHADER_WRITE_BIT;
-		dstStageMask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		// Storage images may be both read and written after the barrier
+		accessMask |= VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		stageMask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
 		break;
 	case VK_IMAGE_LAYOUT_PRESENT_SRC_KHR:
-		barrierDesc.dstAccessMask |= VK_ACCESS_MEMORY_READ_BIT;
-		dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		accessMask |= VK_ACCESS_MEMORY_READ_BIT;
+		stageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
 		break;
 	}
+}
+
+static bool isSubresourceRangeOverlapping(const VkImageSubresourceRange& a, const VkImageSubresourceRange& b)
+{
+	if (!(a.aspectMask & b.aspectMask))
+		return false;
+
+	const u32 aMipEnd   = a.levelCount == VK_REMAINING_MIP_LEVELS ? UINT32_MAX : a.baseMipLevel + a.levelCount;
+	const u32 bMipEnd   = b.levelCount == VK_REMAINING_MIP_LEVELS ? UINT32_MAX : b.baseMipLevel + b.levelCount;
+	const u32 aLayerEnd = a.layerCount == VK_REMAINING_ARRAY_LAYERS ? UINT32_MAX : a.baseArrayLayer + a.layerCount;
+	const u32 bLayerEnd = b.layerCount == VK_REMAINING_ARRAY_LAYERS ? UINT32_MAX : b.baseArrayLayer + b.layerCount;
+
+	return a.baseMipLevel < bMipEnd && b.baseMipLevel < aMipEnd && a.baseArrayLayer < bLayerEnd &&
+	       b.baseArrayLayer < aLayerEnd;
+}
+
+VkImageLayout GfxContext::addImageBarrier(VkImage image,
+	VkImageLayout currentLayout, VkImageLayout nextLayout,
+    const VkImageSubresourceRange* subresourceRange, bool force)
+{
+	if (currentLayout == nextLayout && !force)
+	{
+		return nextLayout;
+	}
+
+	// FIXME: default range only covers one mip/layer; callers without explicit range can miss subresources.
+	// Use addTextureBarrier() for tracked textures.
+	VkImageSubresourceRange defaultSubresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+
+	VkImageMemoryBarrier barrierDesc = {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
+	barrierDesc.srcAccessMask        = 0;
+	barrierDesc.dstAccessMask        = 0;
+	barrierDesc.oldLayout            = currentLayout;
+	barrierDesc.newLayout            = nextLayout;
+	barrierDesc.srcQueueFamilyIndex  = VK_QUEUE_FAMILY_IGNORED;
+	barrierDesc.dstQueueFamilyIndex  = VK_QUEUE_FAMILY_IGNORED;
+	barrierDesc.subresourceRange     = subresourceRange ? *subresourceRange : defaultSubresourceRange;
+	barrierDesc.image                = image;
+
+	// Transitions of the same subresources must not be merged into one batch
+	for (const VkImageMemoryBarrier& imageBarrier : m_pendingBarriers.imageBarriers)
+	{
+		if (imageBarrier.image == image &&
+		    isSubresourceRangeOverlapping(imageBarrier.subresourceRange, barrierDesc.subresourceRange))
+		{
+			flushBarriers();
+			break;
+		}
+	}
+
+	// conservative default flags
+	VkPipelineStageFlags srcStageMask = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+	VkPipelineStageFlags dstStageMask = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+
+	getImageLayoutSrcFlags(currentLayout, barrierDesc.srcAccessMask, srcStageMask);
+	getImageLayoutDstFlags(nextLayout, barrierDesc.dstAccessMask, dstStageMask);
 
 	if (m_type == GfxContextType::Transfer)
 	{
@@ -2447,6 +3030,96 @@ VkImageLayout GfxContext::addImageBarrier(VkImage image,
 	return nextLayout;
 }
 
+void GfxContext::addTextureBarrier(
+    TextureVK& texture, VkImageLayout nextLayout, const VkImageSubresourceRange* subresourceRange, bool isWrite)
+{
+	const u32 mipCount   = texture.desc.mips;
+	const u32 layerCount = texture.getArrayLayerCount();
+
+	VkImageSubresourceRange range = {texture.aspectFlags, 0, mipCount, 0, layerCount};
+	if (subresourceRange)
+	{
+		range = *subresourceRange;
+		if (range.levelCount == VK_REMAINING_MIP_LEVELS)
+			range.levelCount = mipCount - range.baseMipLevel;
+		if (range.layerCount == VK_REMAINING_ARRAY_LAYERS)
+			range.layerCount = layerCount - range.baseArrayLayer;
+	}
+
+	RUSH_ASSERT(range.baseMipLevel + range.levelCount <= mipCount);
+	RUSH_ASSERT(range.baseArrayLayer + range.layerCount <= layerCount);
+
+	const u32 mipEnd   = range.baseMipLevel + range.levelCount;
+	const u32 layerEnd = range.baseArrayLayer + range.layerCount;
+
+	ImageSubresourceStateVK* states = texture.subresourceStates.data();
+
+	// Barrier is only required on layout change or after an unsynchronized write.
+	// Read-after-read in the same layout does not need synchronization.
+	auto needsBarrier = [nextLayout](const ImageSubresourceStateVK& state) {
+		return state.layout != nextLayout || state.pendingWrite;
+	};
+
+	const ImageSubresourceStateVK firstState = states[range.baseArrayLayer * mipCount + range.baseMipLevel];
+
+	bool isUniform = true;
+	for (u32 layer = range.baseArrayLayer; layer < layerEnd && isUniform; ++layer)
+	{
+		for (u32 mip = range.baseMipLevel; mip < mipEnd; ++mip)
+		{
+			if (!(states[layer * mipCount + mip] == firstState))
+			{
+				isUniform = false;
+				break;
+			}
+		}
+	}
+
+	if (isUniform)
+	{
+		if (needsBarrier(firstState))
+		{
+			addImageBarrier(texture.image, firstState.layout, nextLayout, &range, true);
+		}
+	}
+	else
+	{
+		// Emit one barrier per run of mips that share the same state
+		for (u32 layer = range.baseArrayLayer; layer < layerEnd; ++layer)
+		{
+			u32 mip = range.baseMipLevel;
+			while (mip < mipEnd)
+			{
+				const ImageSubresourceStateVK state = states[layer * mipCount + mip];
+
+				u32 runEnd = mip + 1;
+				while (runEnd < mipEnd && states[layer * mipCount + runEnd] == state)
+				{
+					++runEnd;
+				}
+
+				if (needsBarrier(state))
+				{
+					VkImageSubresourceRange runRange = {range.aspectMask, mip, runEnd - mip, layer, 1};
+					addImageBarrier(texture.image, state.layout, nextLayout, &runRange, true);
+				}
+
+				mip = runEnd;
+			}
+		}
+	}
+
+	for (u32 layer = range.baseArrayLayer; layer < layerEnd; ++layer)
+	{
+		for (u32 mip = range.baseMipLevel; mip < mipEnd; ++mip)
+		{
+			ImageSubresourceStateVK& state = states[layer * mipCount + mip];
+			state.layout                   = nextLayout;
+			state.pendingWrite             = isWrite;
+		}
+	}
+}
+
 void GfxContext::addBufferBarrier(GfxBuffer h, VkAccessFlagBits srcAccess, VkAccessFlagBits dstAccess,
     VkPipelineStageFlagBits srcStage, VkPipelineStageFlagBits dstStage)
 {
@@ -2480,6 +3153,9 @@ void GfxContext::flushBarriers()
 	    u32(m_pendingBarriers.bufferBarriers.size()), m_pendingBarriers.bufferBarriers.data(),
 	    u32(m_pendingBarriers.imageBarriers.size()), m_pendingBarriers.imageBarriers.data());
 
+	m_device->m_stats.barriers +=
+	    u32(m_pendingBarriers.bufferBarriers.size() + m_pendingBarriers.imageBarriers.size());
+
 	m_pendingBarriers.imageBarriers.clear();
 	m_pendingBarriers.bufferBarriers.clear();
 
@@ -2491,6 +3167,9 @@ void GfxContext::beginRenderPass(const GfxPassDesc& desc)
 {
 	RUSH_ASSERT(m_type == GfxContextType::Graphics);
 	RUSH_ASSERT(!m_isRenderPassActive);
+
+	beginPassStats(false);
+	m_device->m_stats.renderPassBegins++;
 	RUSH_ASSERT(m_currentRenderPass == VK_NULL_HANDLE);
 
 	m_pendingClear.color   = desc.clearColors[0];
@@ -2512,28 +3191,42 @@ void GfxContext::beginRenderPass(const GfxPassDesc& desc)
 	m_currentRenderRect.extent.width  = UINT32_MAX;
 	m_currentRenderRect.extent.height = UINT32_MAX;
 
+	const bool useDynamicRendering = m_device->m_supportedExtensions.KHR_dynamic_rendering;
+
+	const bool discardColor      = !!(desc.flags & GfxPassFlags::DiscardColor);
+	const bool shouldClearColor  = !!(desc.flags & GfxPassFlags::ClearColor);
+	const bool clearDepthStencil = !!(desc.flags & GfxPassFlags::ClearDepthStencil);
+
+	VkRenderingAttachmentInfo colorAttachments[GfxPassDesc::MaxTargets] = {};
+	VkRenderingAttachmentInfo depthAttachment   = {VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO};
+	VkRenderingAttachmentInfo stencilAttachment = {VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO};
+
 	u32 depthSampleCount = 0;
 
+	m_currentDepthStencilFormat = GfxFormat_Unknown;
+
 	u32          clearValueCount = 0;
 	VkClearValue clearValues[1 + GfxPassDesc::MaxTargets];
 	if (desc.depth.valid())
 	{
 		TextureVK& texture                = m_device->m_resources.textures[desc.depth];
 		depthSampleCount                  = texture.desc.samples;
+		m_currentDepthStencilFormat       = texture.desc.format;
 		m_currentRenderRect.extent.width  = min(m_currentRenderRect.extent.width, texture.desc.width);
 		m_currentRenderRect.extent.height = min(m_currentRenderRect.extent.height, texture.desc.height);
 
-		// TODO: track subresource states
-		// TODO: initialize default subresource range to cover entire image
-		VkImageSubresourceRange subresourceRange = {texture.aspectFlags, 0, texture.desc.mips, 0, 1};
-
-		texture.currentLayout = addImageBarrier(
-		    texture.image, texture.currentLayout, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, &subresourceRange);
+		addTextureBarrier(texture, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, nullptr, true);
 		clearValues[clearValueCount] = m_pendingClear.getClearDepthStencil();
 		++clearValueCount;
-	}
 
-	const bool shouldClearColor = !!(desc.flags & GfxPassFlags::ClearColor);
+		depthAttachment.imageView   = texture.depthStencilImageView;
+		depthAttachment.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+		depthAttachment.loadOp      = clearDepthStencil ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_LOAD;
+		depthAttachment.storeOp     = VK_ATTACHMENT_STORE_OP_STORE;
+		depthAttachment.clearValue  = m_pendingClear.getClearDepthStencil();
+
+		stencilAttachment = depthAttachment;
+	}
 
 	u32 colorSampleCount = 0;
 
@@ -2546,14 +3239,33 @@ void GfxContext::beginRenderPass(const GfxPassDesc& desc)
 			colorSampleCount                  = texture.desc.samples;
 			m_currentRenderRect.extent.width  = min(m_currentRenderRect.extent.width, texture.desc.width);
 			m_currentRenderRect.extent.height = min(m_currentRenderRect.extent.height, texture.desc.height);
-			// FIXME: addImageBarrier defaults to a 1x1 subresource range; mip/array RTs need full range.
-			texture.currentLayout =
-			    addImageBarrier(texture.image, texture.currentLayout, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+			addTextureBarrier(texture, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, nullptr, true);
 			if (shouldClearColor)
 			{
 				clearValues[clearValueCount] = m_pendingClear.getClearColor();
 				++clearValueCount;
 			}
+
+			m_currentColorFormats[i] = texture.desc.format;
+
+			VkRenderingAttachmentInfo& attachment = colorAttachments[i];
+			attachment.sType       = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+			attachment.imageView   = texture.imageView;
+			attachment.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+			if (discardColor)
+			{
+				attachment.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+			}
+			else if (shouldClearColor)
+			{
+				attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+			}
+			else
+			{
+				attachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+			}
+			attachment.storeOp    = VK_ATTACHMENT_STORE_OP_STORE;
+			attachment.clearValue = m_pendingClear.getClearColor();
 		}
 		else
 		{
@@ -2570,23 +3282,53 @@ void GfxContext::beginRenderPass(const GfxPassDesc& desc)
 	if (depthSampleCount == 0)
 		depthSampleCount = 1;
 
-	VkRenderPassBeginInfo renderPassBeginInfo = {VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO};
-	renderPassBeginInfo.renderPass            = m_device->createRenderPass(desc);
-	renderPassBeginInfo.framebuffer           = m_device->createFrameBuffer(desc, renderPassBeginInfo.renderPass);
-	renderPassBeginInfo.renderArea            = m_currentRenderRect;
-	if (m_pendingClear.flags != GfxClearFlags::None)
+	const u32 colorAttachmentCount = desc.getColorTargetCount();
+
+	if (useDynamicRendering)
 	{
-		renderPassBeginInfo.clearValueCount = clearValueCount;
-		renderPassBeginInfo.pClearValues    = clearValues;
+		const u32 depthStencilComponents = getGfxFormatComponent(m_currentDepthStencilFormat);
+
+		VkRenderingInfo renderingInfo      = {VK_STRUCTURE_TYPE_RENDERING_INFO};
+		renderingInfo.renderArea           = m_currentRenderRect;
+		renderingInfo.layerCount           = 1;
+		renderingInfo.colorAttachmentCount = colorAttachmentCount;
+		renderingInfo.pColorAttachments    = colorAttachments;
+		if (depthStencilComponents & GfxFormatComponent_Depth)
+		{
+			renderingInfo.pDepthAttachment = &depthAttachment;
+		}
+		if (depthStencilComponents & GfxFormatComponent_Stencil)
+		{
+			renderingInfo.pStencilAttachment = &stencilAttachment;
+		}
+
+		flushBarriers();
+
+		vkCmdBeginRendering(m_commandBuffer, &renderingInfo);
+
+		m_currentRenderPass = VK_NULL_HANDLE;
 	}
+	else
+	{
+		VkRenderPassBeginInfo renderPassBeginInfo = {VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO};
+		renderPassBeginInfo.renderPass            = m_device->createRenderPass(desc);
+		renderPassBeginInfo.framebuffer = m_device->createFrameBuffer(desc, renderPassBeginInfo.renderPass);
+		renderPassBeginInfo.renderArea  = m_currentRenderRect;
+		if (m_pendingClear.flags != GfxClearFlags::None)
+		{
+			renderPassBeginInfo.clearValueCount = clearValueCount;
+			renderPassBeginInfo.pClearValues    = clearValues;
+		}
 
-	flushBarriers();
+		flushBarriers();
 
-	vkCmdBeginRenderPass(m_commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+		vkCmdBeginRenderPass(m_commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+		m_currentRenderPass = renderPassBeginInfo.renderPass;
+	}
 
 	m_currentRenderPassDesc       = desc;
-	m_currentRenderPass           = renderPassBeginInfo.renderPass;
-	m_currentColorAttachmentCount = desc.getColorTargetCount();
+	m_currentColorAttachmentCount = colorAttachmentCount;
 	m_currentColorSampleCount     = colorSampleCount;
 	m_currentDepthSampleCount     = depthSampleCount;
 
@@ -2599,9 +3341,91 @@ void GfxContext::beginRenderPass(const GfxPassDesc& desc)
 void GfxContext::endRenderPass()
 {
 	RUSH_ASSERT(m_isRenderPassActive);
-	vkCmdEndRenderPass(m_commandBuffer);
+	if (m_device->m_supportedExtensions.KHR_dynamic_rendering)
+	{
+		vkCmdEndRendering(m_commandBuffer);
+	}
+	else
+	{
+		vkCmdEndRenderPass(m_commandBuffer);
+	}
 	m_isRenderPassActive = false;
 	m_currentRenderPass  = VK_NULL_HANDLE;
+
+	endPassStats();
+}
+
+void GfxContext::beginPassStats(bool isCompute)
+{
+	RUSH_ASSERT(!m_isRenderPassActive);
+
+	if (m_activePassStats != ~0u)
+	{
+		endPassStats();
+	}
+
+	GfxDevice::FrameData* frame = m_device->m_currentFrame;
+	if (frame->passStats.size() == GfxDevice::MaxPassStatsPerFrame)
+	{
+		return;
+	}
+
+	GfxPassStats passStats;
+	passStats.isCompute = isCompute;
+	for (size_t i = m_device->m_gpuZoneStack.size(); i != 0; --i)
+	{
+		const u32 zoneIndex = m_device->m_gpuZoneStack[i - 1];
+		if (zoneIndex != ~0u)
+		{
+			passStats.name = frame->gpuZones[zoneIndex].name;
+			break;
+		}
+	}
+
+	// Statistics queries are only supported on graphics queues and are limited to one per pass
+	u32 query = ~0u;
+	if (frame->statisticsPool && m_type == GfxContextType::Graphics)
+	{
+		query = frame->statisticsQueryCount++;
+		vkCmdBeginQuery(m_commandBuffer, frame->statisticsPool, query, 0);
+	}
+
+	m_activePassStats = u32(frame->passStats.size());
+	m_passStatsBegin  = m_device->m_stats;
+
+	frame->passStats.push_back(passStats);
+	frame->passStatsQueries.push_back(query);
+}
+
+void GfxContext::endPassStats()
+{
+	if (m_activePassStats == ~0u)
+	{
+		return;
+	}
+
+	GfxDevice::FrameData* frame = m_device->m_currentFrame;
+
+	const u32 query = frame->passStatsQueries[m_activePassStats];
+	if (query != ~0u)
+	{
+		vkCmdEndQuery(m_commandBuffer, frame->statisticsPool, query);
+	}
+
+	// Counters may have been reset by Gfx_ResetStats() during the pass
+	const GfxStats& stats = m_device->m_stats;
+	auto            delta = [](u32 end, u32 begin) { return end >= begin ? end - begin : end; };
+
+	GfxPassStats& passStats    = frame->passStats[m_activePassStats];
+	passStats.drawCalls        = delta(stats.drawCalls, m_passStatsBegin.drawCalls);
+	passStats.dispatches       = delta(stats.dispatches, m_passStatsBegin.dispatches);
+	passStats.vertices         = delta(stats.vertices, m_passStatsBegin.vertices);
+	passStats.triangles        = delta(stats.triangles, m_passStatsBegin.triangles);
+	passStats.pipelineBinds    = delta(stats.pipelineBinds, m_passStatsBegin.pipelineBinds);
+	passStats.descriptorWrites = delta(stats.descriptorWrites, m_passStatsBegin.descriptorWrites);
+	passStats.barriers         = delta(stats.barriers, m_passStatsBegin.barriers);
+
+	m_activePassStats = ~0u;
 }
 
 void GfxContext::resolveImage(GfxTextureArg src, GfxTextureArg dst)
@@ -2622,11 +3446,11 @@ void GfxContext::resolveImage(GfxTextureArg src, GfxTextureArg dst)
 	VkImage       dstImage       = dstTexture.image;
 	VkImageLayout dstImageLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
 
-	VkImageSubresourceRange srcRange = {srcTexture.aspectFlags, 0, srcTexture.desc.mips, 0, 1};
-	VkImageSubresourceRange dstRange = {dstTexture.aspectFlags, 0, dstTexture.desc.mips, 0, 1};
+	VkImageSubresourceRange srcRange = {srcTexture.aspectFlags, 0, 1, 0, 1};
+	VkImageSubresourceRange dstRange = {dstTexture.aspectFlags, 0, 1, 0, 1};
 
-	srcTexture.currentLayout = addImageBarrier(srcTexture.image, srcTexture.currentLayout, srcImageLayout, &srcRange);
-	dstTexture.currentLayout = addImageBarrier(dstTexture.image, dstTexture.currentLayout, dstImageLayout, &dstRange);
+	addTextureBarrier(srcTexture, srcImageLayout, &srcRange);
+	addTextureBarrier(dstTexture, dstImageLayout, &dstRange, true);
 
 	flushBarriers();
 
@@ -2640,7 +3464,12 @@ static void updateDescriptorSet(GfxDevice* device, VkDevice vulkanDevice, VkDesc
 {
 	const u32 maxWriteDescriptorSetCount = 3 + desc.rwImages + desc.rwBuffers + desc.rwTypedBuffers + desc.accelerationStructures;
 
-	InlineDynamicArray<VkWriteDescriptorSet, 16> writeDescriptorSets(maxWriteDescriptorSetCount);
+	// Large descriptor sets spill into scratch memory instead of the general heap
+	FrameArena&     scratch = FrameArena::getThreadLocal();
+	FrameArenaScope scratchScope(scratch);
+
+	SmallVector<VkWriteDescriptorSet, 16> writeDescriptorSets(scratch);
+	writeDescriptorSets.resize(maxWriteDescriptorSetCount);
 
 	u32 writeDescriptorSetCount = 0;
 
@@ -2648,7 +3477,8 @@ static void updateDescriptorSet(GfxDevice* device, VkDevice vulkanDevice, VkDesc
 
 	u32 bindingIndex = 0;
 
-	InlineDynamicArray<VkDescriptorBufferInfo, 16> pendingConstantBufferInfo(desc.constantBuffers);
+	SmallVector<VkDescriptorBufferInfo, 16> pendingConstantBufferInfo(scratch);
+	pendingConstantBufferInfo.resize(desc.constantBuffers);
 
 	if (desc.constantBuffers)
 	{
@@ -2665,7 +3495,7 @@ static void updateDescriptorSet(GfxDevice* device, VkDevice vulkanDevice, VkDesc
 		writeDescriptorSet.descriptorType =
 		    useDynamicUniformBuffers ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
 		writeDescriptorSet.pImageInfo       = nullptr;
-		writeDescriptorSet.pBufferInfo      = pendingConstantBufferInfo.m_data;
+		writeDescriptorSet.pBufferInfo      = pendingConstantBufferInfo.data();
 		writeDescriptorSet.pTexelBufferView = nullptr;
 		bindingIndex += writeDescriptorSet.descriptorCount;
 
@@ -2689,8 +3519,9 @@ static void updateDescriptorSet(GfxDevice* device, VkDevice vulkanDevice, VkDesc
 
 	const u32 maxImageInfoCount = desc.samplers + desc.textures + desc.rwImages;
 
-	InlineDynamicArray<VkDescriptorImageInfo, 16> imageInfos(maxImageInfoCount);
-	u32                                           imageInfoCount = 0;
+	SmallVector<VkDescriptorImageInfo, 16> imageInfos(scratch);
+	u32                                    imageInfoCount = 0;
+	imageInfos.resize(maxImageInfoCount);
 
 	// Samplers
 
@@ -2830,14 +3661,15 @@ static void updateDescriptorSet(GfxDevice* device, VkDevice vulkanDevice, VkDesc
 
 	// Acceleration structures
 
-	InlineDynamicArray<VkAccelerationStructureKHR, 1> writeAccelStructures(desc.accelerationStructures);
+	SmallVector<VkAccelerationStructureKHR, 1> writeAccelStructures(scratch);
+	writeAccelStructures.resize(desc.accelerationStructures);
 	VkWriteDescriptorSetAccelerationStructureKHR writeDescriptorSetAccel;
 	if (desc.accelerationStructures)
 	{
 		writeDescriptorSetAccel.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET_ACCELERATION_STRUCTURE_KHR;
 		writeDescriptorSetAccel.pNext = nullptr;
 		writeDescriptorSetAccel.accelerationStructureCount = desc.accelerationStructures;
-		writeDescriptorSetAccel.pAccelerationStructures = writeAccelStructures.m_data;
+		writeDescriptorSetAccel.pAccelerationStructures = writeAccelStructures.data();
 
 		RUSH_ASSERT(writeDescriptorSetCount < maxWriteDescriptorSetCount);
 		VkWriteDescriptorSet& writeDescriptorSet = writeDescriptorSets[writeDescriptorSetCount++];
@@ -2862,7 +3694,9 @@ static void updateDescriptorSet(GfxDevice* device, VkDevice vulkanDevice, VkDesc
 		}
 	}
 
-	vkUpdateDescriptorSets(vulkanDevice, writeDescriptorSetCount, writeDescriptorSets.m_data, 0, nullptr);
+	vkUpdateDescriptorSets(vulkanDevice, writeDescriptorSetCount, writeDescriptorSets.data(), 0, nullptr);
+
+	device->m_stats.descriptorWrites += writeDescriptorSetCount;
 }
 
 void GfxContext::applyState()
@@ -2879,14 +3713,31 @@ void GfxContext::applyState()
 
 	const GfxShaderBindingDesc& bindingDesc = pipelineBase.bindings;
 	const GfxDescriptorSetDesc& descSet = pipelineBase.bindings.descriptorSets[0];
+
+	VkPipelineBindPoint pendingBindPoint = VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR;
+	if (m_pending.technique.valid())
+	{
+		const TechniqueVK& technique = m_device->m_resources.techniques[m_pending.technique];
+		pendingBindPoint = technique.cs.valid() ? VK_PIPELINE_BIND_POINT_COMPUTE : VK_PIPELINE_BIND_POINT_GRAPHICS;
+	}
+
 	if ((m_dirtyState & DirtyStateFlag_Technique) && bindingDesc.useDefaultDescriptorSet)
 	{
-		m_dirtyState |= DirtyStateFlag_Descriptors;
+		// Resources have not changed, so the bound set can be kept if it is compatible with the new layout
+		if ((m_dirtyState & DirtyStateFlag_Descriptors) == 0 &&
+		    isDefaultDescriptorSetCompatible(pipelineBase, pendingBindPoint))
+		{
+			m_device->m_stats.descriptorUpdatesElided++;
+		}
+		else
+		{
+			m_dirtyState |= DirtyStateFlag_Descriptors;
+		}
 	}
 
 	if (m_dirtyState & DirtyStateFlag_Pipeline)
 	{
-		m_currentBindPoint = VK_PIPELINE_BIND_POINT_MAX_ENUM;
+		VkPipeline pipeline = VK_NULL_HANDLE;
 
 		if (m_pending.technique.valid())
 		{
@@ -2902,22 +3753,40 @@ void GfxContext::applyState()
 				info.vertexBufferStride[i] = m_pending.vertexBufferStride[i];
 			}
 			info.renderPass = m_currentRenderPass;
+			info.depthStencilFormat = m_currentDepthStencilFormat;
+			for (u32 i = 0; i < m_currentColorAttachmentCount; ++i)
+			{
+				info.colorFormats[i] = m_currentColorFormats[i];
+			}
 			info.colorAttachmentCount = m_currentColorAttachmentCount;
 			info.colorSampleCount = m_currentColorSampleCount;
 			info.depthSampleCount = m_currentDepthSampleCount;
 
-			m_activePipeline = m_device->createPipeline(info);
-
-			const TechniqueVK& technique = m_device->m_resources.techniques[m_pending.technique];
-			m_currentBindPoint = technique.cs.valid() ? VK_PIPELINE_BIND_POINT_COMPUTE : VK_PIPELINE_BIND_POINT_GRAPHICS;
+			pipeline = m_device->createPipeline(info);
 		}
 		else if (m_pending.rayTracingPipeline.valid())
 		{
-			m_activePipeline = m_device->m_resources.rayTracingPipelines[m_pending.rayTracingPipeline].pipeline;
-			m_currentBindPoint = VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR;
+			pipeline = m_device->m_resources.rayTracingPipelines[m_pending.rayTracingPipeline].pipeline;
+		}
+
+		// Different states often resolve to the same pipeline, especially with extended dynamic state
+		if (pipeline != m_activePipeline || pendingBindPoint != m_currentBindPoint)
+		{
+			m_activePipeline   = pipeline;
+			m_currentBindPoint = pendingBindPoint;
+
+			vkCmdBindPipeline(m_commandBuffer, m_currentBindPoint, m_activePipeline);
+			m_device->m_stats.pipelineBinds++;
+		}
+		else
+		{
+			m_device->m_stats.pipelineBindsElided++;
 		}
 
-		vkCmdBindPipeline(m_commandBuffer, m_currentBindPoint, m_activePipeline);
+		if (m_currentBindPoint == VK_PIPELINE_BIND_POINT_GRAPHICS && m_device->m_supportedExtensions.EXT_extended_dynamic_state)
+		{
+			applyDynamicState();
+		}
 
 		m_dirtyState &= ~DirtyStateFlag_Pipeline;
 	}
@@ -2935,7 +3804,15 @@ void GfxContext::applyState()
 			validateBufferUse(buffer, true);
 
 			VkDeviceSize bufferOffset = buffer.info.offset + m_pending.vertexBufferOffsets[i];
-			vkCmdBindVertexBuffers(m_commandBuffer, i, 1, &buffer.info.buffer, &bufferOffset);
+			if (m_device->m_supportedExtensions.EXT_extended_dynamic_state)
+			{
+				VkDeviceSize bufferStride = m_pending.vertexBufferStride[i];
+				vkCmdBindVertexBuffers2(m_commandBuffer, i, 1, &buffer.info.buffer, &bufferOffset, nullptr, &bufferStride);
+			}
+			else
+			{
+				vkCmdBindVertexBuffers(m_commandBuffer, i, 1, &buffer.info.buffer, &bufferOffset);
+			}
 		}
 
 		m_dirtyState &= ~DirtyStateFlag_VertexBuffer;
@@ -3042,19 +3919,15 @@ void GfxContext::applyState()
 		for (u32 i = 0; i < descSet.textures; ++i)
 		{
 			RUSH_ASSERT(m_pending.textures[i].valid());
-			TextureVK&              texture          = m_device->m_resources.textures[m_pending.textures[i]];
-			VkImageSubresourceRange subresourceRange = {
-			    texture.aspectFlags, 0, texture.desc.mips, 0, 1}; // TODO: track subresource states
-			texture.currentLayout = addImageBarrier(
-			    texture.image, texture.currentLayout, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, &subresourceRange);
+			TextureVK& texture = m_device->m_resources.textures[m_pending.textures[i]];
+			addTextureBarrier(texture, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 		}
 
 		for (u32 i = 0; i < descSet.rwImages; ++i)
 		{
 			RUSH_ASSERT(m_pending.storageImages[i].valid());
 			TextureVK& texture = m_device->m_resources.textures[m_pending.storageImages[i]];
-			texture.currentLayout =
-			    addImageBarrier(texture.image, texture.currentLayout, VK_IMAGE_LAYOUT_GENERAL, nullptr, true);
+			addTextureBarrier(texture, VK_IMAGE_LAYOUT_GENERAL, nullptr, true);
 		}
 
 		updateDescriptorSet(m_device, m_vulkanDevice, m_currentDescriptorSet, descSet,
@@ -3075,11 +3948,101 @@ void GfxContext::applyState()
 
 		vkCmdBindDescriptorSets(m_commandBuffer, m_currentBindPoint, pipelineBase.pipelineLayout, first, count,
 		    &descriptorSets[first], dynamicOffsetCount, m_pending.constantBufferOffsets);
+
+		if (first == 0 && bindingDesc.useDefaultDescriptorSet)
+		{
+			m_boundDescriptorSet.layout    = pipelineBase.setLayouts[0];
+			m_boundDescriptorSet.bindPoint = m_currentBindPoint;
+			if (m_pending.technique.valid())
+			{
+				const TechniqueVK& technique = m_device->m_resources.techniques[m_pending.technique];
+				m_boundDescriptorSet.pushConstantStageFlags = technique.pushConstantStageFlags;
+				m_boundDescriptorSet.pushConstantsSize      = technique.pushConstantsSize;
+			}
+			else
+			{
+				m_boundDescriptorSet.pushConstantStageFlags = 0;
+				m_boundDescriptorSet.pushConstantsSize      = 0;
+			}
+		}
 	}
 
 	m_dirtyState = 0;
 }
 
+bool GfxContext::isDefaultDescriptorSetCompatible(
+    const PipelineBaseVK& pipelineBase, VkPipelineBindPoint bindPoint) const
+{
+	// Set layouts are cached by definition, so identical handles mean identically defined layouts.
+	// Pipeline layouts must also have identical push constant ranges to be compatible for set 0.
+	if (m_currentDescriptorSet == VK_NULL_HANDLE || m_boundDescriptorSet.layout != pipelineBase.setLayouts[0] ||
+	    m_boundDescriptorSet.bindPoint != bindPoint)
+	{
+		return false;
+	}
+
+	VkShaderStageFlags pushConstantStageFlags = 0;
+	u32                pushConstantsSize      = 0;
+	if (m_pending.technique.valid())
+	{
+		const TechniqueVK& technique = m_device->m_resources.techniques[m_pending.technique];
+		pushConstantStageFlags       = technique.pushConstantStageFlags;
+		pushConstantsSize            = technique.pushConstantsSize;
+	}
+
+	return m_boundDescriptorSet.pushConstantStageFlags == pushConstantStageFlags &&
+	       m_boundDescriptorSet.pushConstantsSize == pushConstantsSize;
+}
+
+void GfxContext::applyDynamicState()
+{
+	const GfxRasterizerDesc& rasterizerDesc = m_device->m_resources.rasterizerStates[m_pending.rasterizerState].desc;
+	const GfxDepthStencilDesc& depthStencilDesc = m_device->m_resources.depthStencilStates[m_pending.depthStencilState].desc;
+
+	const VkPrimitiveTopology primitiveTopology = convertPrimitiveType(m_pending.primitiveType);
+	const VkCullModeFlags     cullMode          = convertCullMode(rasterizerDesc);
+	const VkFrontFace         frontFace         = convertFrontFace(rasterizerDesc);
+	const VkCompareOp         depthCompareOp    = convertCompareFunc(depthStencilDesc.compareFunc);
+	const u8                  depthTestEnable   = depthStencilDesc.enable;
+	const u8                  depthWriteEnable  = depthStencilDesc.writeEnable;
+
+	if (m_dynamicState.primitiveTopology != primitiveTopology)
+	{
+		vkCmdSetPrimitiveTopology(m_commandBuffer, primitiveTopology);
+		m_dynamicState.primitiveTopology = primitiveTopology;
+	}
+
+	if (m_dynamicState.cullMode != cullMode)
+	{
+		vkCmdSetCullMode(m_commandBuffer, cullMode);
+		m_dynamicState.cullMode = cullMode;
+	}
+
+	if (m_dynamicState.frontFace != frontFace)
+	{
+		vkCmdSetFrontFace(m_commandBuffer, frontFace);
+		m_dynamicState.frontFace = frontFace;
+	}
+
+	if (m_dynamicState.depthTestEnable != depthTestEnable)
+	{
+		vkCmdSetDepthTestEnable(m_commandBuffer, depthTestEnable);
+		m_dynamicState.depthTestEnable = depthTestEnable;
+	}
+
+	if (m_dynamicState.depthWriteEnable != depthWriteEnable)
+	{
+		vkCmdSetDepthWriteEnable(m_commandBuffer, depthWriteEnable);
+		m_dynamicState.depthWriteEnable = depthWriteEnable;
+	}
+
+	if (m_dynamicState.depthCompareOp != depthCompareOp)
+	{
+		vkCmdSetDepthCompareOp(m_commandBuffer, depthCompareOp);
+		m_dynamicState.depthCompareOp = depthCompareOp;
+	}
+}
+
 static GfxContext* allocateContext(GfxContextType type, const char* name)
 {
 	GfxContext* result = nullptr;
@@ -3088,7 +4051,7 @@ static GfxContext* allocateContext(GfxContextType type, const char* name)
 
 	if (pool.empty())
 	{
-		result = new GfxContext(g_device, type);
+		result = getContextAllocator().create(g_device, type);
 		Gfx_Retain(result);
 	}
 	else
@@ -3128,18 +4091,22 @@ void Gfx_Release(GfxDevice* dev)
 	g_device = nullptr;
 }
 
-static void getQueryPoolResults(VkDevice device, VkQueryPool pool, u32 count, DynamicArray<u64>& output)
+// Reads back timestamps without waiting. Returns false if any of the queries is not yet available.
+static bool getQueryPoolResults(VkDevice device, VkQueryPool pool, u32 count, DynamicArray<u64>& output)
 {
+	output.resize(count * 2);
+	u32      stride = 2 * sizeof(*output.data());
+	VkResult res    = vkGetQueryPoolResults(device, pool, 0, count, count * stride, output.data(), stride,
+	    VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+
+	// Compact (value, availability) pairs into values
+	for (u32 i = 0; i < count; ++i)
+	{
+		output[i] = output[2 * i];
+	}
 	output.resize(count);
-	u32 stride = sizeof(*output.data());
-	vkGetQueryPoolResults(device,
-	    pool,
-	    0,
-	    (u32)output.size(),
-	    (u32)output.size() * stride,
-	    output.data(),
-	    stride,
-	    VK_QUERY_RESULT_64_BIT);
+
+	return res == VK_SUCCESS;
 }
 
 static GfxContext* getUploadContext()
@@ -3148,51 +4115,149 @@ static GfxContext* getUploadContext()
 	{
 		GfxContextType contextType = g_device->m_transferQueue ? GfxContextType::Transfer : GfxContextType::Graphics;
 
-		g_device->m_currentUploadContext = allocateContext(contextType, "Upload");
-		g_device->m_currentUploadContext->beginBuild();
+		g_device->m_currentUploadContext = allocateContext(contextType, "Upload");
+		g_device->m_currentUploadContext->beginBuild();
+	}
+	return g_device->m_currentUploadContext;
+}
+
+void GfxDevice::flushUploadContext(GfxContext* dependentContext, bool waitForCompletion)
+{
+	if (!m_currentUploadContext)
+		return;
+
+	m_currentUploadContext->endBuild();
+	m_currentUploadContext->m_useCompletionSemaphore = dependentContext != nullptr;
+
+	VkQueue queue = g_device->m_transferQueue ? g_device->m_transferQueue : g_device->m_graphicsQueue;
+
+	m_currentUploadContext->submit(queue);
+
+	if (dependentContext)
+	{
+		dependentContext->addDependency(m_currentUploadContext->m_lastSubmission, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+	}
+
+	enqueueDestroy(m_currentUploadContext);
+	m_currentUploadContext = nullptr;
+
+	if (waitForCompletion)
+	{
+		V(vkQueueWaitIdle(queue));
+	}
+}
+
+static void writeTimestamp(GfxContext* context, u32 slotIndex, VkPipelineStageFlagBits stageFlags)
+{
+	g_device->m_currentFrame->timestampSlotMap[slotIndex] = u16(g_device->m_currentFrame->timestampIssuedCount);
+	vkCmdWriteTimestamp(context->m_commandBuffer,
+	    stageFlags,
+	    g_device->m_currentFrame->timestampPool,
+	    g_device->m_currentFrame->timestampIssuedCount++);
+}
+
+void GfxDevice::resolveGpuZones(const FrameData& frame)
+{
+	m_resolvedGpuZones.clear();
+
+	if (frame.gpuZones.empty())
+	{
+		return;
+	}
+
+	const double secondsPerTick = 1e-9 * double(m_physicalDeviceProps.limits.timestampPeriod);
+
+	// Find a pair of matching GPU and CPU times to convert GPU ticks into Timer::global time base
+
+	u64    referenceTicks = 0;
+	double referenceTime  = 0.0;
+
+	if (m_supportedExtensions.EXT_calibrated_timestamps)
+	{
+		VkCalibratedTimestampInfoEXT timestampInfos[2] = {
+		    {VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT}, {VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT}};
+		timestampInfos[0].timeDomain = VK_TIME_DOMAIN_DEVICE_EXT;
+		timestampInfos[1].timeDomain = m_hostTimeDomain;
+
+		u64 timestamps[2] = {};
+		u64 maxDeviation  = 0;
+		V(vkGetCalibratedTimestampsEXT(m_vulkanDevice, 2, timestampInfos, timestamps, &maxDeviation));
+
+		referenceTicks = timestamps[0];
+		referenceTime  = Timer::global.timeFromSystemTicks(timestamps[1]);
+	}
+	else
+	{
+		// Approximate: assume GPU started the frame when it was submitted
+		const u32 frameBeginSlot = frame.timestampSlotMap[2 * GfxStats::MaxCustomTimers];
+		referenceTicks           = frame.timestampPoolData[frameBeginSlot];
+		referenceTime            = frame.submitTime;
+	}
+
+	auto ticksToTime = [&](u64 ticks) { return referenceTime + double(s64(ticks - referenceTicks)) * secondsPerTick; };
+
+	for (const GpuZoneVK& zone : frame.gpuZones)
+	{
+		if (zone.endQuery == ~0u)
+		{
+			continue;
+		}
+
+		GfxGpuZone result;
+		result.name      = zone.name;
+		result.depth     = zone.depth;
+		result.beginTime = ticksToTime(frame.timestampPoolData[zone.beginQuery]);
+		result.endTime   = ticksToTime(frame.timestampPoolData[zone.endQuery]);
+
+		m_resolvedGpuZones.push_back(result);
 	}
-	return g_device->m_currentUploadContext;
 }
 
-void GfxDevice::flushUploadContext(GfxContext* dependentContext, bool waitForCompletion)
+void GfxDevice::resolvePassStats(const FrameData& frame)
 {
-	if (!m_currentUploadContext)
-		return;
+	m_resolvedPassStats.clear();
 
-	m_currentUploadContext->endBuild();
+	static constexpr u32 StatisticCount = 5;
+	const u32            queryCount     = frame.statisticsQueryCount;
 
-	if (dependentContext)
+	// Each query is followed by its availability, so missing results do not block or overwrite valid ones
+	if (queryCount)
 	{
-		m_currentUploadContext->m_useCompletionSemaphore = true;
-		dependentContext->addDependency(
-		    m_currentUploadContext->m_completionSemaphore, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+		const u32 stride = (StatisticCount + 1) * sizeof(u64);
+		m_statisticsQueryData.resize(queryCount * (StatisticCount + 1));
+		vkGetQueryPoolResults(m_vulkanDevice, frame.statisticsPool, 0, queryCount, queryCount * stride,
+		    m_statisticsQueryData.data(), stride, VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
 	}
 
-	VkQueue queue = g_device->m_transferQueue ? g_device->m_transferQueue : g_device->m_graphicsQueue;
-
-	m_currentUploadContext->submit(queue);
+	for (u32 i = 0; i < frame.passStats.size(); ++i)
+	{
+		GfxPassStats result = frame.passStats[i];
 
-	enqueueDestroy(m_currentUploadContext);
-	m_currentUploadContext = nullptr;
+		const u32 query = frame.passStatsQueries[i];
+		if (query != ~0u)
+		{
+			const u64* data = &m_statisticsQueryData[query * (StatisticCount + 1)];
+			if (data[StatisticCount])
+			{
+				result.hasPipelineStatistics     = true;
+				result.vertexShaderInvocations   = data[0];
+				result.clippingInvocations       = data[1];
+				result.clippingPrimitives        = data[2];
+				result.fragmentShaderInvocations = data[3];
+				result.computeShaderInvocations  = data[4];
+			}
+		}
 
-	if (waitForCompletion)
-	{
-		V(vkQueueWaitIdle(queue));
+		m_resolvedPassStats.push_back(result);
 	}
 }
 
-static void writeTimestamp(GfxContext* context, u32 slotIndex, VkPipelineStageFlagBits stageFlags)
-{
-	g_device->m_currentFrame->timestampSlotMap[slotIndex] = u16(g_device->m_currentFrame->timestampIssuedCount);
-	vkCmdWriteTimestamp(context->m_commandBuffer,
-	    stageFlags,
-	    g_device->m_currentFrame->timestampPool,
-	    g_device->m_currentFrame->timestampIssuedCount++);
-}
-
 void Gfx_BeginFrame()
 {
-	if (!g_device->m_resizeEvents.empty() || g_device->m_desiredPresentInterval != g_device->m_presentInterval)
+	FrameArena::resetFrameArenas();
+
+	if (!g_device->m_resizeEvents.empty() || g_device->m_desiredPresentInterval != g_device->m_presentInterval ||
+	    g_device->m_desiredPresentMode != g_device->m_presentMode)
 	{
 		g_device->createSwapChain();
 		g_device->m_resizeEvents.clear();
@@ -3219,12 +4284,14 @@ void Gfx_BeginFrame()
 
 	static constexpr u16 InvalidTimestampSlotIndex = 0xFFFF;
 
-	if (g_device->m_currentFrame->timestampIssuedCount)
+	// Frame fence has been waited on at this point, so results should normally be available.
+	// Never block on them though: if some are missing, keep the previous timings rather than reading garbage.
+	if (g_device->m_currentFrame->timestampIssuedCount &&
+	    getQueryPoolResults(g_vulkanDevice,
+	        g_device->m_currentFrame->timestampPool,
+	        g_device->m_currentFrame->timestampIssuedCount,
+	        g_device->m_currentFrame->timestampPoolData))
 	{
-		getQueryPoolResults(g_vulkanDevice,
-		    g_device->m_currentFrame->timestampPool,
-		    g_device->m_currentFrame->timestampIssuedCount,
-		    g_device->m_currentFrame->timestampPoolData);
 
 		double nanoSecondsPerTick = g_device->m_physicalDeviceProps.limits.timestampPeriod;
 		double secondsPerTick     = 1e-9 * nanoSecondsPerTick;
@@ -3254,12 +4321,62 @@ void Gfx_BeginFrame()
 		                     g_device->m_currentFrame->timestampPoolData[frameBeginSlot];
 		g_device->m_stats.lastFrameGpuTime = timestampDelta * secondsPerTick;
 
-		g_device->m_currentFrame->timestampIssuedCount = 0;
+		// Compute and graphics queues are assumed to share the device time domain
+		GfxDevice::FrameData& frame = *g_device->m_currentFrame;
+		if (frame.asyncComputeTimestampCount &&
+		    getQueryPoolResults(
+		        g_vulkanDevice, frame.asyncComputeTimestampPool, frame.asyncComputeTimestampCount, frame.asyncComputeTimestampData))
+		{
+			const u64 frameBegin = frame.timestampPoolData[frameBeginSlot];
+			const u64 frameEnd   = frame.timestampPoolData[frameEndSlot];
+
+			u64 asyncTicks   = 0;
+			u64 overlapTicks = 0;
+			for (u32 i = 0; i + 1 < frame.asyncComputeTimestampCount; i += 2)
+			{
+				const u64 begin = frame.asyncComputeTimestampData[i];
+				const u64 end   = frame.asyncComputeTimestampData[i + 1];
+				asyncTicks += end - begin;
+
+				const u64 overlapBegin = max(begin, frameBegin);
+				const u64 overlapEnd   = min(end, frameEnd);
+				if (overlapEnd > overlapBegin)
+				{
+					overlapTicks += overlapEnd - overlapBegin;
+				}
+			}
+
+			g_device->m_stats.lastFrameAsyncComputeTime    = asyncTicks * secondsPerTick;
+			g_device->m_stats.lastFrameAsyncComputeOverlap = overlapTicks * secondsPerTick;
+		}
+
+		g_device->resolveGpuZones(*g_device->m_currentFrame);
+	}
+	else
+	{
+		g_device->m_resolvedGpuZones.clear();
 	}
 
-	vkCmdResetQueryPool(g_context->m_commandBuffer,
-		g_device->m_currentFrame->timestampPool,
-		0, u32(g_device->m_currentFrame->timestampPoolData.size()));
+	g_device->m_currentFrame->timestampIssuedCount       = 0;
+	g_device->m_currentFrame->asyncComputeTimestampCount = 0;
+
+	g_device->m_currentFrame->gpuZones.clear();
+	g_device->m_gpuZoneStack.clear();
+
+	g_device->resolvePassStats(*g_device->m_currentFrame);
+	g_device->m_stats.passes = g_device->m_resolvedPassStats;
+
+	g_device->m_currentFrame->passStats.clear();
+	g_device->m_currentFrame->passStatsQueries.clear();
+	g_device->m_currentFrame->statisticsQueryCount = 0;
+
+	vkCmdResetQueryPool(g_context->m_commandBuffer, g_device->m_currentFrame->timestampPool, 0, GfxDevice::TimestampPoolSize);
+
+	if (g_device->m_currentFrame->statisticsPool)
+	{
+		vkCmdResetQueryPool(g_context->m_commandBuffer, g_device->m_currentFrame->statisticsPool, 0,
+		    GfxDevice::MaxPassStatsPerFrame);
+	}
 
 	for (u16& it : g_device->m_currentFrame->timestampSlotMap)
 	{
@@ -3338,14 +4455,14 @@ void GfxDevice::captureScreenshot()
 void Gfx_EndFrame()
 {
 	RUSH_ASSERT(!g_context->m_isRenderPassActive);
+	RUSH_ASSERT_MSG(g_device->m_gpuZoneStack.empty(), "All GPU zones must be closed before the end of the frame");
 
 	writeTimestamp(g_context, 2 * GfxStats::MaxCustomTimers + 1, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
 
 	TextureVK& backBufferTexture =
 	    g_device->m_resources.textures[g_device->m_swapChainTextures[g_device->m_swapChainIndex].get()];
 
-	backBufferTexture.currentLayout = g_context->addImageBarrier(
-	    backBufferTexture.image, backBufferTexture.currentLayout, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+	g_context->addTextureBarrier(backBufferTexture, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
 
 	g_context->endBuild();
 
@@ -3373,9 +4490,24 @@ void Gfx_Present()
 		}
 	}
 
+	g_device->m_currentFrame->submitTime = Timer::global.time();
+
 	g_context->submit(g_device->m_graphicsQueue);
 
-	g_device->m_currentFrame->lastGraphicsFence = g_context->m_fence;
+	GfxDevice::FrameData* currentFrame = g_device->m_currentFrame;
+	currentFrame->lastGraphicsSubmission = g_context->m_lastSubmission;
+	for (u32 i = 0; i < RUSH_COUNTOF(currentFrame->retireTimelineValues); ++i)
+	{
+		currentFrame->retireTimelineValues[i] = g_device->m_queueTimelines[i].submittedValue;
+	}
+
+	GfxDevice::InFlightFrame& inFlightFrame =
+	    g_device->m_inFlightFrames[g_device->m_presentedFrameCount % GfxDevice::MaxFramesInFlight];
+	for (u32 i = 0; i < RUSH_COUNTOF(inFlightFrame.timelineValues); ++i)
+	{
+		inFlightFrame.timelineValues[i] = g_device->m_queueTimelines[i].submittedValue;
+	}
+	g_device->m_presentedFrameCount++;
 
 	if (g_device->m_pendingScreenshotCallback)
 	{
@@ -3400,7 +4532,7 @@ void Gfx_Present()
 	if (g_device->m_pendingScreenshot.active)
 	{
 		GfxDevice::PendingScreenshot& pending = g_device->m_pendingScreenshot;
-		V(vkWaitForFences(g_vulkanDevice, 1, &pending.context->m_fence, true, UINT64_MAX));
+		pending.context->waitForCompletion();
 
 		if (g_device->m_pendingScreenshotCallback && pending.mapped)
 		{
@@ -3410,6 +4542,7 @@ void Gfx_Present()
 			{
 				const u8* src = reinterpret_cast<const u8*>(pending.mapped);
 				const size_t pixelCount = static_cast<size_t>(pending.size.x) * pending.size.y;
+				MemoryTagScope tagScope(MemoryTag::Staging);
 				DynamicArray<ColorRGBA8> pixels(pixelCount);
 				ImageView imageView;
 				imageView.data = src;
@@ -3454,6 +4587,26 @@ void Gfx_Present()
 
 void Gfx_SetPresentInterval(u32 interval) { g_device->m_desiredPresentInterval = interval; }
 
+void Gfx_SetPresentMode(GfxPresentMode mode) { g_device->m_desiredPresentMode = mode; }
+
+GfxPresentMode Gfx_GetPresentMode()
+{
+	switch (g_device->m_swapChainPresentMode)
+	{
+	case VK_PRESENT_MODE_IMMEDIATE_KHR: return GfxPresentMode::Immediate;
+	case VK_PRESENT_MODE_MAILBOX_KHR: return GfxPresentMode::Mailbox;
+	case VK_PRESENT_MODE_FIFO_RELAXED_KHR: return GfxPresentMode::FifoRelaxed;
+	default: return GfxPresentMode::Fifo;
+	}
+}
+
+void Gfx_SetMaxFramesInFlight(u32 count)
+{
+	g_device->m_maxFramesInFlight = clamp<u32>(count, 1, GfxDevice::MaxFramesInFlight);
+}
+
+void Gfx_WaitForFrameLatency() { g_device->waitForFrameLatency(); }
+
 void Gfx_Finish()
 {
 	g_device->flushUploadContext(g_context);
@@ -3468,7 +4621,21 @@ void Gfx_Finish()
 
 const GfxStats& Gfx_Stats() { return g_device->m_stats; }
 
-void Gfx_ResetStats() { g_device->m_stats = GfxStats(); }
+void Gfx_ResetStats()
+{
+	GfxStats& stats = g_device->m_stats;
+
+	const u32 pipelines            = stats.pipelines;
+	const u32 pipelinePermutations = stats.pipelinePermutations;
+
+	const ArrayView<const GfxPassStats> passes = stats.passes;
+
+	stats = GfxStats();
+
+	stats.pipelines            = pipelines;
+	stats.pipelinePermutations = pipelinePermutations;
+	stats.passes               = passes;
+}
 
 // vertex format
 
@@ -3539,28 +4706,74 @@ static ShaderVK createShader(VkDevice device, const GfxShaderSource& code)
 {
 	ShaderVK result;
 
-	result.entry = code.entry;
+	result.entry = StringId(code.entry);
 	result.module = createShaderModule(device, code);
 
 	return result;
 }
 
-// vertex shader
-
-GfxOwn<GfxVertexShader> Gfx_CreateVertexShader(const GfxShaderSource& code)
+template <typename HandleType>
+static GfxOwn<HandleType> createSharedShader(const GfxShaderSource& code, GfxStage stage)
 {
 	RUSH_ASSERT(code.type == GfxShaderSourceType_SPV);
 
-	ShaderVK res = createShader(g_vulkanDevice, code);
+	if (code.empty())
+	{
+		return InvalidResourceHandle();
+	}
+
+	const StringId entry(code.entry);
+	const u64      entryHash = entry.hash();
+
+	u64 cacheKey = hashFnv1a64(code.data(), code.size());
+	cacheKey     = hashFnv1a64(&entryHash, sizeof(entryHash), cacheKey);
+	cacheKey     = hashFnv1a64(&stage, sizeof(stage), cacheKey);
 
-	if (res.module)
+	// FNV-1 differs from FNV-1a in operation order and width, so a collision of both is very unlikely
+	const u32 codeHash = hashFnv1(code.data(), code.size());
+	const u32 codeSize = u32(code.size());
+
+	auto it = g_device->m_shaderCache.find(cacheKey);
+	if (it != g_device->m_shaderCache.end())
 	{
-		return retainResourceT<GfxVertexShader>(g_device->m_resources.shaders, res);
+		const ShaderVK& cached = g_device->m_resources.shaders[it->second];
+		if (cached.entry == entry && cached.codeHash == codeHash && cached.codeSize == codeSize)
+		{
+			HandleType handle(it->second);
+			Gfx_Retain(handle);
+			return GfxDevice::makeOwn(handle);
+		}
+
+		// Hash collision: create a separate module that is not shared
+		cacheKey = 0;
 	}
-	else
+
+	ShaderVK res = createShader(g_vulkanDevice, code);
+
+	if (!res.module)
 	{
 		return InvalidResourceHandle();
 	}
+
+	res.cacheKey = cacheKey;
+	res.codeHash = codeHash;
+	res.codeSize = codeSize;
+
+	GfxOwn<HandleType> result = retainResourceT<HandleType>(g_device->m_resources.shaders, res);
+
+	if (cacheKey)
+	{
+		g_device->m_shaderCache.insert(std::make_pair(cacheKey, UntypedResourceHandle(result.get().value())));
+	}
+
+	return result;
+}
+
+// vertex shader
+
+GfxOwn<GfxVertexShader> Gfx_CreateVertexShader(const GfxShaderSource& code)
+{
+	return createSharedShader<GfxVertexShader>(code, GfxStage::Vertex);
 }
 
 void Gfx_Release(GfxVertexShader h) { releaseResource(g_device->m_resources.shaders, h); }
@@ -3569,18 +4782,7 @@ void Gfx_Release(GfxVertexShader h) { releaseResource(g_device->m_resources.shad
 
 GfxOwn<GfxPixelShader> Gfx_CreatePixelShader(const GfxShaderSource& code)
 {
-	RUSH_ASSERT(code.type == GfxShaderSourceType_SPV);
-
-	ShaderVK res = createShader(g_vulkanDevice, code);
-
-	if (res.module)
-	{
-		return retainResourceT<GfxPixelShader>(g_device->m_resources.shaders, res);
-	}
-	else
-	{
-		return InvalidResourceHandle();
-	}
+	return createSharedShader<GfxPixelShader>(code, GfxStage::Pixel);
 }
 
 void Gfx_Release(GfxPixelShader h) { releaseResource(g_device->m_resources.shaders, h); }
@@ -3589,18 +4791,7 @@ void Gfx_Release(GfxPixelShader h) { releaseResource(g_device->m_resources.shade
 
 GfxOwn<GfxGeometryShader> Gfx_CreateGeometryShader(const GfxShaderSource& code)
 {
-	RUSH_ASSERT(code.type == GfxShaderSourceType_SPV);
-
-	ShaderVK res = createShader(g_vulkanDevice, code);
-
-	if (res.module)
-	{
-		return retainResourceT<GfxGeometryShader>(g_device->m_resources.shaders, res);
-	}
-	else
-	{
-		return InvalidResourceHandle();
-	}
+	return createSharedShader<GfxGeometryShader>(code, GfxStage::Geometry);
 }
 
 void Gfx_Release(GfxGeometryShader h) { releaseResource(g_device->m_resources.shaders, h); }
@@ -3609,18 +4800,7 @@ void Gfx_Release(GfxGeometryShader h) { releaseResource(g_device->m_resources.sh
 
 GfxOwn<GfxComputeShader> Gfx_CreateComputeShader(const GfxShaderSource& code)
 {
-	RUSH_ASSERT(code.type == GfxShaderSourceType_SPV);
-
-	ShaderVK res = createShader(g_vulkanDevice, code);
-
-	if (res.module)
-	{
-		return retainResourceT<GfxComputeShader>(g_device->m_resources.shaders, res);
-	}
-	else
-	{
-		return InvalidResourceHandle();
-	}
+	return createSharedShader<GfxComputeShader>(code, GfxStage::Compute);
 }
 
 void Gfx_Release(GfxComputeShader h) { releaseResource(g_device->m_resources.shaders, h); }
@@ -3629,21 +4809,10 @@ void Gfx_Release(GfxComputeShader h) { releaseResource(g_device->m_resources.sha
 
 GfxOwn<GfxMeshShader> Gfx_CreateMeshShader(const GfxShaderSource& code)
 {
-	RUSH_ASSERT(code.type == GfxShaderSourceType_SPV);
-
-	ShaderVK res = createShader(g_vulkanDevice, code);
-
-	if (res.module)
-	{
-		return retainResourceT<GfxMeshShader>(g_device->m_resources.shaders, res);
-	}
-	else
-	{
-		return InvalidResourceHandle();
-	}
+	return createSharedShader<GfxMeshShader>(code, GfxStage::Mesh);
 }
 
-void Gfx_Retain(GfxMeshShader h) { g_device->m_resources.shaders[h.index()].addReference(); }
+void Gfx_Retain(GfxMeshShader h) { g_device->m_resources.shaders[h].addReference(); }
 
 void Gfx_Release(GfxMeshShader h) { releaseResource(g_device->m_resources.shaders, h); }
 
@@ -3816,6 +4985,47 @@ void GfxDevice::freeSemaphore(VkSemaphore x)
 	m_semaphorePool.push(x);
 }
 
+GfxDevice::QueueTimelineVK* GfxDevice::getQueueTimeline(VkQueue queue)
+{
+	if (!m_supportedExtensions.KHR_timeline_semaphore)
+		return nullptr;
+
+	for (QueueTimelineVK& timeline : m_queueTimelines)
+	{
+		if (timeline.queue == queue)
+			return &timeline;
+	}
+
+	RUSH_LOG_ERROR("Queue timeline not found");
+	return nullptr;
+}
+
+void GfxDevice::waitForTimelineValues(const u64* values)
+{
+	VkSemaphore semaphores[u32(GfxContextType::count)];
+	u64         semaphoreValues[u32(GfxContextType::count)];
+	u32         count = 0;
+
+	for (u32 i = 0; i < u32(GfxContextType::count); ++i)
+	{
+		if (values[i] && m_queueTimelines[i].semaphore)
+		{
+			semaphores[count]      = m_queueTimelines[i].semaphore;
+			semaphoreValues[count] = values[i];
+			++count;
+		}
+	}
+
+	if (count == 0)
+		return;
+
+	VkSemaphoreWaitInfo waitInfo = {VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO};
+	waitInfo.semaphoreCount      = count;
+	waitInfo.pSemaphores         = semaphores;
+	waitInfo.pValues             = semaphoreValues;
+	V(vkWaitSemaphores(m_vulkanDevice, &waitInfo, UINT64_MAX));
+}
+
 DescriptorSetLayoutArray GfxDevice::createDescriptorSetLayouts(
     const GfxShaderBindingDesc& desc, u32 resourceStageFlags)
 {
@@ -3862,7 +5072,7 @@ GfxOwn<GfxDescriptorSet> Gfx_CreateDescriptorSet(const GfxDescriptorSetDesc& des
 	res.layout = g_device->createDescriptorSetLayout(desc, convertStageFlags(desc.stageFlags), false);
 
 	// TODO: cache pools and reuse them for different sets
-	res.pool = new DescriptorPoolVK(g_vulkanDevice, makeDescriptorPoolDesc(desc), 1);
+	res.pool = g_device->m_descriptorPoolAllocator.create(g_vulkanDevice, makeDescriptorPoolDesc(desc), 1);
 
 	return retainResource(g_device->m_resources.descriptorSets, res);
 }
@@ -3892,7 +5102,7 @@ void Gfx_UpdateDescriptorSet(GfxDescriptorSetArg d,
 		enqueueDestroy(ds.pool);
 		const GfxDescriptorSetDesc& desc = ds.desc;
 
-		ds.pool = new DescriptorPoolVK(g_vulkanDevice, makeDescriptorPoolDesc(desc), 1);
+		ds.pool = g_device->m_descriptorPoolAllocator.create(g_vulkanDevice, makeDescriptorPoolDesc(desc), 1);
 	}
 
 
@@ -3918,7 +5128,7 @@ void Gfx_UpdateDescriptorSet(GfxDescriptorSetArg d,
 		enqueueDestroy(ds.pool);
 		const GfxDescriptorSetDesc& desc = ds.desc;
 
-		ds.pool = new DescriptorPoolVK(g_vulkanDevice, makeDescriptorPoolDesc(desc), 1);
+		ds.pool = g_device->m_descriptorPoolAllocator.create(g_vulkanDevice, makeDescriptorPoolDesc(desc), 1);
 
 		allocInfo.descriptorPool = ds.pool->m_descriptorPool;
 		allocResult              = vkAllocateDescriptorSets(ds.pool->m_vulkanDevice, &allocInfo, &ds.native);
@@ -3950,23 +5160,29 @@ GfxOwn<GfxTechnique> Gfx_CreateTechnique(const GfxTechniqueDesc& desc)
 
 	if (g_device->m_supportedExtensions.AMD_wave_limits)
 	{
-		res.waveLimits = new VkPipelineShaderStageCreateInfoWaveLimitAMD[u32(GfxStage::count)];
+		res.waveLimits = g_device->m_waveLimitsAllocator.create();
 		for (u32 i = 0; i < u32(GfxStage::count); ++i)
 		{
-			res.waveLimits[i].sType      = VK_STRUCTURE_TYPE_WAVE_LIMIT_AMD;
-			res.waveLimits[i].wavesPerCu = 1.0;
+			res.waveLimits->stages[i].sType      = VK_STRUCTURE_TYPE_WAVE_LIMIT_AMD;
+			res.waveLimits->stages[i].pNext      = nullptr;
+			res.waveLimits->stages[i].wavesPerCu = 1.0;
 		}
-		res.waveLimits[u32(GfxStage::Pixel)].wavesPerCu   = desc.psWaveLimit;
-		res.waveLimits[u32(GfxStage::Vertex)].wavesPerCu  = desc.vsWaveLimit;
-		res.waveLimits[u32(GfxStage::Compute)].wavesPerCu = desc.csWaveLimit;
+		res.waveLimits->stages[u32(GfxStage::Pixel)].wavesPerCu   = desc.psWaveLimit;
+		res.waveLimits->stages[u32(GfxStage::Vertex)].wavesPerCu  = desc.vsWaveLimit;
+		res.waveLimits->stages[u32(GfxStage::Compute)].wavesPerCu = desc.csWaveLimit;
 	}
 
 	if (desc.specializationData)
 	{
-		// todo: batch all allocations into one
+		const size_t entriesOffset =
+		    size_t(alignCeiling(u64(sizeof(VkSpecializationInfo)), u64(alignof(VkSpecializationMapEntry))));
+		const size_t entriesSize   = sizeof(VkSpecializationMapEntry) * desc.specializationConstantCount;
+		const size_t dataOffset    = entriesOffset + entriesSize;
 
-		size_t specializationEntriesSize = sizeof(VkSpecializationMapEntry) * desc.specializationConstantCount;
-		VkSpecializationMapEntry* specializationEntriesCopy = (VkSpecializationMapEntry*)allocateBytes(specializationEntriesSize);
+		u8* specializationMemory = static_cast<u8*>(allocateBytes(dataOffset + desc.specializationDataSize));
+
+		VkSpecializationMapEntry* specializationEntriesCopy =
+		    reinterpret_cast<VkSpecializationMapEntry*>(specializationMemory + entriesOffset);
 		for (u32 i = 0; i < desc.specializationConstantCount; ++i)
 		{
 			specializationEntriesCopy[i].constantID = desc.specializationConstants[i].id;
@@ -3974,10 +5190,10 @@ GfxOwn<GfxTechnique> Gfx_CreateTechnique(const GfxTechniqueDesc& desc)
 			specializationEntriesCopy[i].size = size_t(desc.specializationConstants[i].size);
 		}
 
-		void* specializationDataCopy = allocateBytes(desc.specializationDataSize);
+		void* specializationDataCopy = specializationMemory + dataOffset;
 		memcpy(specializationDataCopy, desc.specializationData, desc.specializationDataSize);
 
-		res.specializationInfo = (VkSpecializationInfo*)allocateBytes(sizeof(VkSpecializationInfo));
+		res.specializationInfo = reinterpret_cast<VkSpecializationInfo*>(specializationMemory);
 
 		res.specializationInfo->mapEntryCount = desc.specializationConstantCount;
 		res.specializationInfo->pMapEntries   = specializationEntriesCopy;
@@ -3995,8 +5211,8 @@ GfxOwn<GfxTechnique> Gfx_CreateTechnique(const GfxTechniqueDesc& desc)
 
 		if (g_device->m_supportedExtensions.AMD_wave_limits && desc.csWaveLimit != 1.0f)
 		{
-			res.waveLimits[u32(GfxStage::Compute)].pNext = stageInfo.pNext;
-			stageInfo.pNext                              = &res.waveLimits[u32(GfxStage::Compute)];
+			res.waveLimits->stages[u32(GfxStage::Compute)].pNext = stageInfo.pNext;
+			stageInfo.pNext = &res.waveLimits->stages[u32(GfxStage::Compute)];
 		}
 
 		res.shaderStages.push_back(stageInfo);
@@ -4026,8 +5242,8 @@ GfxOwn<GfxTechnique> Gfx_CreateTechnique(const GfxTechniqueDesc& desc)
 
 			if (g_device->m_supportedExtensions.AMD_wave_limits && desc.vsWaveLimit != 1.0f)
 			{
-				res.waveLimits[u32(GfxStage::Vertex)].pNext = stageInfo.pNext;
-				stageInfo.pNext                             = &res.waveLimits[u32(GfxStage::Vertex)];
+				res.waveLimits->stages[u32(GfxStage::Vertex)].pNext = stageInfo.pNext;
+				stageInfo.pNext = &res.waveLimits->stages[u32(GfxStage::Vertex)];
 			}
 
 			res.shaderStages.push_back(stageInfo);
@@ -4056,8 +5272,8 @@ GfxOwn<GfxTechnique> Gfx_CreateTechnique(const GfxTechniqueDesc& desc)
 
 			if (g_device->m_supportedExtensions.AMD_wave_limits && desc.psWaveLimit != 1.0f)
 			{
-				res.waveLimits[u32(GfxStage::Pixel)].pNext = stageInfo.pNext;
-				stageInfo.pNext                            = &res.waveLimits[u32(GfxStage::Pixel)];
+				res.waveLimits->stages[u32(GfxStage::Pixel)].pNext = stageInfo.pNext;
+				stageInfo.pNext = &res.waveLimits->stages[u32(GfxStage::Pixel)];
 			}
 
 			res.shaderStages.push_back(stageInfo);
@@ -4135,14 +5351,9 @@ void TechniqueVK::destroy()
 	ps.reset();
 	cs.reset();
 
-	if (specializationInfo)
-	{
-		deallocateBytes(const_cast<void*>(specializationInfo->pData));
-		deallocateBytes(const_cast<VkSpecializationMapEntry*>(specializationInfo->pMapEntries));
-		deallocateBytes(specializationInfo);
-	}
+	deallocateBytes(specializationInfo);
 
-	delete[] waveLimits;
+	g_device->m_waveLimitsAllocator.destroy(waveLimits);
 
 	// TODO: queue-up destruction
 	vkDestroyPipelineLayout(g_vulkanDevice, pipelineLayout, g_allocationCallbacks);
@@ -4220,8 +5431,7 @@ TextureVK TextureVK::create(const GfxTextureDesc& desc, const GfxTextureData* da
 	RUSH_ASSERT(desc.usage != GfxUsageFlags::None);
 
 	TextureVK res;
-	res.desc          = desc;
-	res.currentLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	res.desc = desc;
 
 	VkImageCreateInfo imageCreateInfo = {VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO};
 
@@ -4307,7 +5517,7 @@ TextureVK TextureVK::create(const GfxTextureDesc& desc, const GfxTextureData* da
 		imageCreateInfo.usage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
 	}
 
-	imageCreateInfo.initialLayout = res.currentLayout;
+	imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 
 	V(vkCreateImage(g_vulkanDevice, &imageCreateInfo, g_allocationCallbacks, &res.image));
 	if (g_device->m_cfg.debug && desc.debugName)
@@ -4331,6 +5541,7 @@ TextureVK TextureVK::create(const GfxTextureDesc& desc, const GfxTextureData* da
 	V(vkBindImageMemory(g_vulkanDevice, res.image, res.memory, 0));
 
 	res.aspectFlags = aspectFlagsFromFormat(desc.format);
+	res.initSubresourceStates(imageCreateInfo.arrayLayers, imageCreateInfo.initialLayout);
 
 	VkImageViewCreateInfo imageViewCreateInfo = {VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO};
 
@@ -4354,10 +5565,7 @@ TextureVK TextureVK::create(const GfxTextureDesc& desc, const GfxTextureData* da
 	{
 		GfxContext* uploadContext = getUploadContext();
 
-		VkImageSubresourceRange subresourceRange = {
-		    VK_IMAGE_ASPECT_COLOR_BIT, 0, desc.mips, 0, imageCreateInfo.arrayLayers};
-		uploadContext->addImageBarrier(
-		    res.image, res.currentLayout, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &subresourceRange);
+		uploadContext->addTextureBarrier(res, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, nullptr, true);
 		uploadContext->flushBarriers();
 
 		const size_t bitsPerPixel   = getBitsPerPixel(desc.format);
@@ -4379,6 +5587,7 @@ TextureVK TextureVK::create(const GfxTextureDesc& desc, const GfxTextureData* da
 		}
 
 		MemoryBlockVK stagingBlock = g_device->m_transientHostAllocator.alloc(stagingBufferSize, 16);
+		g_device->m_stats.bytesUploaded += stagingBufferSize;
 
 		size_t stagingImageOffset = stagingBlock.offset;
 		u8*    stagingImagePixels = (u8*)stagingBlock.mappedBuffer;
@@ -4415,10 +5624,7 @@ TextureVK TextureVK::create(const GfxTextureDesc& desc, const GfxTextureData* da
 			stagingImageOffset += alignedLevelSize;
 		}
 
-		res.currentLayout = uploadContext->addImageBarrier(res.image,
-			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-			&subresourceRange);
+		uploadContext->addTextureBarrier(res, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 	}
 
 	return res;
@@ -4438,7 +5644,7 @@ TextureVK TextureVK::create(const GfxTextureDesc& desc, VkImage image, VkImageLa
 	res.image     = image;
 	res.ownsImage = false;
 
-	res.currentLayout = initialLayout;
+	res.initSubresourceStates(1, initialLayout);
 
 	u32 aspectFlags = aspectFlagsFromFormat(desc.format); // TODO: calculate from usage instead of just format
 
@@ -4474,6 +5680,15 @@ const GfxTextureDesc& Gfx_GetTextureDesc(GfxTextureArg h)
 	}
 }
 
+void TextureVK::initSubresourceStates(u32 arrayLayerCount, VkImageLayout layout)
+{
+	ImageSubresourceStateVK state;
+	state.layout = layout;
+
+	subresourceStates.clear();
+	subresourceStates.resize(desc.mips * arrayLayerCount, state);
+}
+
 void TextureVK::destroy()
 {
 	RUSH_ASSERT(m_refs == 0);
@@ -4519,6 +5734,14 @@ void Gfx_Release(GfxBlendState h) { releaseResource(g_device->m_resources.blendS
 // sampler state
 GfxOwn<GfxSampler> Gfx_CreateSamplerState(const GfxSamplerDesc& desc)
 {
+	// Identical samplers are shared to stay well below maxSamplerAllocationCount
+	auto it = g_device->m_samplerCache.find(GfxDevice::SamplerKey{desc});
+	if (it != g_device->m_samplerCache.end())
+	{
+		Gfx_Retain(it->second);
+		return GfxDevice::makeOwn(it->second);
+	}
+
 	SamplerVK res;
 
 	res.desc = desc;
@@ -4542,12 +5765,17 @@ GfxOwn<GfxSampler> Gfx_CreateSamplerState(const GfxSamplerDesc& desc)
 
 	V(vkCreateSampler(g_vulkanDevice, &samplerCreateInfo, g_allocationCallbacks, &res.native));
 
-	return retainResource(g_device->m_resources.samplers, res);
+	GfxOwn<GfxSampler> result = retainResource(g_device->m_resources.samplers, res);
+
+	g_device->m_samplerCache.insert(std::make_pair(GfxDevice::SamplerKey{desc}, result.get()));
+
+	return result;
 }
 
 void SamplerVK::destroy()
 {
 	RUSH_ASSERT(m_refs == 0);
+	g_device->m_samplerCache.erase(GfxDevice::SamplerKey{desc});
 	enqueueDestroy(native);
 }
 
@@ -4679,6 +5907,7 @@ static BufferVK createBuffer(const GfxBufferDesc& desc, const void* data)
 	if (data)
 	{
 		MemoryBlockVK stagingBlock = g_device->m_transientHostAllocator.alloc(bufferCreateInfo.size, 16);
+		g_device->m_stats.bytesUploaded += bufferCreateInfo.size;
 
 		memcpy(stagingBlock.mappedBuffer, data, bufferCreateInfo.size);
 
@@ -4800,6 +6029,8 @@ void Gfx_AddFullPipelineBarrier(GfxContext* ctx)
 
 	vkCmdPipelineBarrier(ctx->m_commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
 	    0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+	g_device->m_stats.barriers++;
 }
 
 void Gfx_vkExecutionBarrier(GfxContext* ctx, VkPipelineStageFlagBits srcStage, VkPipelineStageFlagBits dstStage)
@@ -4998,6 +6229,8 @@ void* Gfx_BeginUpdateBuffer(GfxContext* rc, GfxBufferArg h, u32 size)
 	RUSH_ASSERT(block.buffer);
 	RUSH_ASSERT(block.mappedBuffer);
 
+	g_device->m_stats.bytesUploaded += size;
+
 	VkBufferCopy region = {};
 	region.srcOffset    = block.offset;
 	region.dstOffset    = buffer.info.offset;
@@ -5054,43 +6287,220 @@ GfxContext* Gfx_BeginAsyncCompute(GfxContext* parentContext)
 #if 0
 	if (vkGetFenceStatus(g_vulkanDevice, asyncContext->m_fence) == VK_NOT_READY)
 	{
-		RUSH_LOG_ERROR("Allocated async compute context is still in used by GPU. This is likely a bug in command buffer management implementation.");
+		RUSH_LOG_ERROR("Allocated async compute context is still in used by GPU. This is likely a bug in command buffer management implementation.");
+	}
+#endif
+
+	asyncContext->beginBuild();
+
+	GfxDevice::FrameData* frame = g_device->m_currentFrame;
+	if (frame->asyncComputeTimestampPool && frame->asyncComputeTimestampCount < 2 * GfxDevice::MaxAsyncComputePerFrame)
+	{
+		const u32 query = frame->asyncComputeTimestampCount;
+		frame->asyncComputeTimestampCount += 2;
+
+		vkCmdResetQueryPool(asyncContext->m_commandBuffer, frame->asyncComputeTimestampPool, query, 2);
+		vkCmdWriteTimestamp(asyncContext->m_commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+		    frame->asyncComputeTimestampPool, query);
+
+		asyncContext->m_asyncComputeTimestampQuery = query;
+	}
+
+	// Compute queue must wait using a compute-capable stage mask.
+	Gfx_WaitForToken(asyncContext, Gfx_SignalToken(parentContext));
+
+	return asyncContext;
+}
+
+GfxQueueToken Gfx_SubmitAsyncCompute(GfxContext* asyncContext)
+{
+	RUSH_ASSERT(asyncContext->m_type == GfxContextType::Compute);
+
+	if (asyncContext->m_asyncComputeTimestampQuery != ~0u)
+	{
+		vkCmdWriteTimestamp(asyncContext->m_commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+		    g_device->m_currentFrame->asyncComputeTimestampPool, asyncContext->m_asyncComputeTimestampQuery + 1);
+		asyncContext->m_asyncComputeTimestampQuery = ~0u;
+	}
+
+	asyncContext->m_useCompletionSemaphore = true;
+	asyncContext->endBuild();
+
+	asyncContext->submit(g_device->m_computeQueue);
+
+	GfxQueueToken token;
+	token.handle = u64(asyncContext->m_lastSubmission.semaphore);
+	token.value  = asyncContext->m_lastSubmission.value;
+
+	enqueueDestroy(asyncContext);
+
+	return token;
+}
+
+void Gfx_EndAsyncCompute(GfxContext* parentContext, GfxContext* asyncContext)
+{
+	RUSH_ASSERT_MSG(parentContext->m_type == GfxContextType::Graphics,
+	    "Waiting for async compute is only implemented on graphics contexts.");
+
+	Gfx_WaitForToken(parentContext, Gfx_SubmitAsyncCompute(asyncContext));
+}
+
+GfxQueueToken Gfx_SignalToken(GfxContext* ctx)
+{
+	RUSH_ASSERT_MSG(ctx->m_type == GfxContextType::Graphics, "Signaling tokens is only implemented on graphics contexts.");
+
+	ctx->m_useCompletionSemaphore = true;
+	const SubmissionVK submission = ctx->split();
+
+	// Without timeline semaphores the token refers to a binary semaphore, which may only be waited on once
+	GfxQueueToken token;
+	token.handle = u64(submission.semaphore);
+	token.value  = submission.value;
+
+	return token;
+}
+
+void Gfx_WaitForToken(GfxContext* ctx, GfxQueueToken token)
+{
+	if (!token.valid())
+	{
+		return;
+	}
+
+	SubmissionVK submission;
+	submission.semaphore = VkSemaphore(token.handle);
+	submission.value     = token.value;
+
+	if (ctx->m_type == GfxContextType::Graphics)
+	{
+		// Only work recorded after this point waits, earlier work may overlap with the signaling queue
+		ctx->split();
+
+		// Consumers may be indirect draws or vertex shaders, not just compute
+		ctx->addDependency(submission, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+	}
+	else
+	{
+		ctx->addDependency(submission, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+	}
+}
+
+u32 GfxDevice::getQueueFamilyIndex(GfxContextType type) const
+{
+	u32 result = m_graphicsQueueIndex;
+
+	switch (type)
+	{
+	default:
+	case GfxContextType::Graphics: break;
+	case GfxContextType::Compute: result = m_computeQueueIndex; break;
+	case GfxContextType::Transfer:
+		// Transfer contexts run on the graphics queue when there is no dedicated transfer queue
+		if (m_transferQueue)
+		{
+			result = m_transferQueueIndex;
+		}
+		break;
+	}
+
+	RUSH_ASSERT_MSG(result != 0xFFFFFFFF, "Queue of the requested context type was not created");
+
+	return result;
+}
+
+static bool getOwnershipTransferFlags(GfxContext* ctx, GfxContextType srcQueue, GfxContextType dstQueue,
+    u32& srcFamily, u32& dstFamily, VkAccessFlags& srcAccess, VkAccessFlags& dstAccess)
+{
+	RUSH_ASSERT_MSG(ctx->m_type == srcQueue || ctx->m_type == dstQueue,
+	    "Ownership transfer must be recorded on the releasing or the acquiring context");
+
+	srcFamily = g_device->getQueueFamilyIndex(srcQueue);
+	dstFamily = g_device->getQueueFamilyIndex(dstQueue);
+
+	// Semaphore wait alone is sufficient within a queue family
+	if (srcFamily == dstFamily)
+	{
+		return false;
 	}
-#endif
 
-	asyncContext->beginBuild();
+	const bool isRelease = ctx->m_type == srcQueue;
 
-	// Compute queue must wait using a compute-capable stage mask.
-	asyncContext->addDependency(parentContext->m_completionSemaphore, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+	srcAccess = isRelease ? VkAccessFlags(VK_ACCESS_MEMORY_WRITE_BIT) : 0;
+	dstAccess = isRelease ? 0 : VkAccessFlags(VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT);
 
-	parentContext->m_useCompletionSemaphore = true;
-	parentContext->split();
+	// Release is ordered after all prior work, acquire before all subsequent work
+	ctx->m_pendingBarriers.srcStageMask |= isRelease ? VK_PIPELINE_STAGE_ALL_COMMANDS_BIT : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+	ctx->m_pendingBarriers.dstStageMask |= isRelease ? VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT : VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
 
-	return asyncContext;
+	return true;
 }
 
-void Gfx_EndAsyncCompute(GfxContext* parentContext, GfxContext* asyncContext)
+void Gfx_TransferOwnership(GfxContext* ctx, GfxBufferArg h, GfxContextType srcQueue, GfxContextType dstQueue)
 {
-	RUSH_ASSERT_MSG(parentContext->m_type == GfxContextType::Graphics,
-	    "Waiting for async compute is only implemented on graphics contexts.");
+	u32           srcFamily, dstFamily;
+	VkAccessFlags srcAccess, dstAccess;
+	if (!getOwnershipTransferFlags(ctx, srcQueue, dstQueue, srcFamily, dstFamily, srcAccess, dstAccess))
+	{
+		return;
+	}
 
-	asyncContext->m_useCompletionSemaphore = true;
-	asyncContext->endBuild();
+	const BufferVK& buffer = g_device->m_resources.buffers[h];
 
-	asyncContext->submit(g_device->m_computeQueue);
+	VkBufferMemoryBarrier barrierDesc = {VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER};
+	barrierDesc.srcAccessMask         = srcAccess;
+	barrierDesc.dstAccessMask         = dstAccess;
+	barrierDesc.srcQueueFamilyIndex   = srcFamily;
+	barrierDesc.dstQueueFamilyIndex   = dstFamily;
+	barrierDesc.buffer                = buffer.info.buffer;
+	barrierDesc.offset                = buffer.info.offset;
+	barrierDesc.size                  = buffer.info.range;
 
-	parentContext->split();
+	ctx->m_pendingBarriers.bufferBarriers.push_back(barrierDesc);
+}
+
+void Gfx_TransferOwnership(GfxContext* ctx, GfxTextureArg h, GfxContextType srcQueue, GfxContextType dstQueue)
+{
+	u32           srcFamily, dstFamily;
+	VkAccessFlags srcAccess, dstAccess;
+	if (!getOwnershipTransferFlags(ctx, srcQueue, dstQueue, srcFamily, dstFamily, srcAccess, dstAccess))
+	{
+		return;
+	}
 
-	parentContext->addDependency(asyncContext->m_completionSemaphore, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+	const TextureVK& texture = g_device->m_resources.textures[h];
 
-	enqueueDestroy(asyncContext);
+	// Layouts are preserved, each subresource is transferred in its current layout
+	const u32 arrayLayerCount = texture.getArrayLayerCount();
+	for (u32 layer = 0; layer < arrayLayerCount; ++layer)
+	{
+		for (u32 mip = 0; mip < texture.desc.mips; ++mip)
+		{
+			const VkImageLayout layout = texture.subresourceStates[layer * texture.desc.mips + mip].layout;
+			if (layout == VK_IMAGE_LAYOUT_UNDEFINED)
+			{
+				continue;
+			}
+
+			VkImageMemoryBarrier barrierDesc = {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
+			barrierDesc.srcAccessMask        = srcAccess;
+			barrierDesc.dstAccessMask        = dstAccess;
+			barrierDesc.oldLayout            = layout;
+			barrierDesc.newLayout            = layout;
+			barrierDesc.srcQueueFamilyIndex  = srcFamily;
+			barrierDesc.dstQueueFamilyIndex  = dstFamily;
+			barrierDesc.image                = texture.image;
+			barrierDesc.subresourceRange     = {texture.aspectFlags, mip, 1, layer, 1};
+
+			ctx->m_pendingBarriers.imageBarriers.push_back(barrierDesc);
+		}
+	}
 }
 
 GfxContext* Gfx_AcquireContext()
 {
 	if (g_context == nullptr)
 	{
-		g_context         = new GfxContext(g_device, GfxContextType::Graphics);
+		g_context         = getContextAllocator().create(g_device, GfxContextType::Graphics);
 		g_context->m_refs = 1;
 		g_context->setName("Immediate");
 	}
@@ -5113,7 +6523,7 @@ void Gfx_Release(GfxContext* rc)
 		g_context = nullptr;
 	}
 
-	delete rc;
+	getContextAllocator().destroy(rc);
 }
 
 void Gfx_Clear(GfxContext* rc, ColorRGBA8 color, GfxClearFlags clearFlags, float depth, u32 stencil)
@@ -5348,18 +6758,83 @@ void Gfx_AddImageBarrier(
 
 	VkImageLayout desiredLayout = convertImageLayout(desiredState);
 
-	VkImageSubresourceRange subresourceRangeVk = {
-	    aspectFlagsFromFormat(texture.desc.format), 0, texture.desc.mips, 0, getTextureArrayLayerCount(texture.desc)};
+	const bool isWrite = desiredLayout == VK_IMAGE_LAYOUT_GENERAL;
 
 	if (subresourceRange)
 	{
-		// FIXME: support explicit subresource ranges.
-		RUSH_LOG_ERROR("Gfx_AddImageBarrier with subresource range is not implemented");
-		return;
+		// Zero level or layer count covers all remaining subresources
+		VkImageSubresourceRange subresourceRangeVk;
+		subresourceRangeVk.aspectMask     = VkImageAspectFlags(subresourceRange->aspectMask);
+		subresourceRangeVk.baseMipLevel   = subresourceRange->baseMipLevel;
+		subresourceRangeVk.levelCount =
+		    subresourceRange->levelCount ? subresourceRange->levelCount : VK_REMAINING_MIP_LEVELS;
+		subresourceRangeVk.baseArrayLayer = subresourceRange->baseArrayLayer;
+		subresourceRangeVk.layerCount =
+		    subresourceRange->layerCount ? subresourceRange->layerCount : VK_REMAINING_ARRAY_LAYERS;
+
+		rc->addTextureBarrier(texture, desiredLayout, &subresourceRangeVk, isWrite);
+	}
+	else
+	{
+		rc->addTextureBarrier(texture, desiredLayout, nullptr, isWrite);
+	}
+}
+
+static void getBufferStateFlags(GfxResourceState state, VkAccessFlags& accessMask, VkPipelineStageFlags& stageMask)
+{
+	const VkPipelineStageFlags shaderStages = VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+	                                          VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT |
+	                                          VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+	switch (state)
+	{
+	default:
+		RUSH_LOG_ERROR("Unexpected buffer state");
+		accessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+		stageMask  = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+		break;
+	case GfxResourceState_Undefined:
+		accessMask = 0;
+		stageMask  = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+		break;
+	case GfxResourceState_General:
+		accessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		stageMask  = shaderStages;
+		break;
+	case GfxResourceState_ShaderRead:
+		accessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_INDEX_READ_BIT |
+		             VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+		stageMask = shaderStages | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT;
+		break;
+	case GfxResourceState_TransferSrc:
+		accessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		stageMask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
+		break;
+	case GfxResourceState_TransferDst:
+		accessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		stageMask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
+		break;
+	}
+}
+
+void Gfx_AddBufferBarrier(GfxContext* rc, GfxBufferArg h, GfxResourceState srcState, GfxResourceState dstState)
+{
+	VkAccessFlags        srcAccess = 0;
+	VkAccessFlags        dstAccess = 0;
+	VkPipelineStageFlags srcStage  = 0;
+	VkPipelineStageFlags dstStage  = 0;
+
+	getBufferStateFlags(srcState, srcAccess, srcStage);
+	getBufferStateFlags(dstState, dstAccess, dstStage);
+
+	if (rc->m_type == GfxContextType::Transfer)
+	{
+		srcStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+		dstStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
 	}
 
-	texture.currentLayout =
-	    rc->addImageBarrier(texture.image, texture.currentLayout, desiredLayout, &subresourceRangeVk);
+	rc->addBufferBarrier(h, VkAccessFlagBits(srcAccess), VkAccessFlagBits(dstAccess),
+	    VkPipelineStageFlagBits(srcStage), VkPipelineStageFlagBits(dstStage));
 }
 
 void Gfx_BeginPass(GfxContext* rc, const GfxPassDesc& desc)
@@ -5403,6 +6878,11 @@ void Gfx_Dispatch(GfxContext* rc, u32 sizeX, u32 sizeY, u32 sizeZ)
 
 void Gfx_Dispatch(GfxContext* rc, u32 sizeX, u32 sizeY, u32 sizeZ, const void* pushConstants, u32 pushConstantsSize)
 {
+	if (rc->m_activePassStats == ~0u)
+	{
+		rc->beginPassStats(true);
+	}
+
 	rc->applyState();
 
 	if (pushConstants)
@@ -5417,11 +6897,18 @@ void Gfx_Dispatch(GfxContext* rc, u32 sizeX, u32 sizeY, u32 sizeZ, const void* p
 	rc->flushBarriers();
 
 	vkCmdDispatch(rc->m_commandBuffer, sizeX, sizeY, sizeZ);
+
+	g_device->m_stats.dispatches++;
 }
 
 void Gfx_DispatchIndirect(
     GfxContext* rc, GfxBufferArg argsBuffer, size_t argsBufferOffset, const void* pushConstants, u32 pushConstantsSize)
 {
+	if (rc->m_activePassStats == ~0u)
+	{
+		rc->beginPassStats(true);
+	}
+
 	rc->applyState();
 
 	if (pushConstants)
@@ -5439,6 +6926,8 @@ void Gfx_DispatchIndirect(
 
 	// TODO: insert buffer barrier (VK_ACCESS_INDIRECT_COMMAND_READ_BIT)
 	vkCmdDispatchIndirect(rc->m_commandBuffer, buffer.info.buffer, buffer.info.offset + argsBufferOffset);
+
+	g_device->m_stats.dispatches++;
 }
 
 inline u32 computeTriangleCount(GfxPrimitive primitiveType, u32 vertexCount)
@@ -5524,6 +7013,25 @@ void Gfx_DrawIndexedIndirect(GfxContext* rc, GfxBufferArg argsBuffer, size_t arg
 	g_device->m_stats.drawCalls++;
 }
 
+void Gfx_DrawIndexedIndirectCount(GfxContext* rc, GfxBufferArg argsBuffer, size_t argsBufferOffset,
+    GfxBufferArg countBuffer, size_t countBufferOffset, u32 maxDrawCount)
+{
+	RUSH_ASSERT(rc->m_isRenderPassActive);
+	RUSH_ASSERT_MSG(g_device->m_caps.drawIndirectCount, "Indirect count draws are not supported by this device");
+
+	rc->applyState();
+
+	const auto& args  = g_device->m_resources.buffers[argsBuffer];
+	const auto& count = g_device->m_resources.buffers[countBuffer];
+
+	rc->flushBarriers();
+
+	vkCmdDrawIndexedIndirectCount(rc->m_commandBuffer, args.info.buffer, args.info.offset + argsBufferOffset,
+	    count.info.buffer, count.info.offset + countBufferOffset, maxDrawCount, args.desc.stride);
+
+	g_device->m_stats.drawCalls++;
+}
+
 void Gfx_DrawMesh(GfxContext* rc, u32 taskCount, u32 firstTask, const void* pushConstants, u32 pushConstantsSize)
 {
 	RUSH_ASSERT(rc->m_isRenderPassActive);
@@ -5575,6 +7083,50 @@ void Gfx_BeginTimer(GfxContext* rc, u32 timestampId)
 	writeTimestamp(g_context, timestampId * 2, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
 }
 
+void Gfx_BeginGpuZone(GfxContext* rc, const char* name)
+{
+	GfxDevice::FrameData* frame = g_device->m_currentFrame;
+
+	if (frame->gpuZones.size() == GfxDevice::MaxGpuZonesPerFrame)
+	{
+		// Out of timestamp queries, zone is dropped
+		g_device->m_gpuZoneStack.push_back(~0u);
+		return;
+	}
+
+	GfxDevice::GpuZoneVK zone;
+	zone.name       = name;
+	zone.depth      = u32(g_device->m_gpuZoneStack.size());
+	zone.beginQuery = frame->timestampIssuedCount++;
+
+	vkCmdWriteTimestamp(rc->m_commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, frame->timestampPool, zone.beginQuery);
+
+	g_device->m_gpuZoneStack.push_back(u32(frame->gpuZones.size()));
+	frame->gpuZones.push_back(zone);
+}
+
+void Gfx_EndGpuZone(GfxContext* rc)
+{
+	RUSH_ASSERT_MSG(!g_device->m_gpuZoneStack.empty(), "Gfx_EndGpuZone called without matching Gfx_BeginGpuZone");
+
+	GfxDevice::FrameData* frame = g_device->m_currentFrame;
+
+	const u32 zoneIndex = g_device->m_gpuZoneStack.back();
+	g_device->m_gpuZoneStack.pop_back();
+
+	if (zoneIndex == ~0u)
+	{
+		return;
+	}
+
+	GfxDevice::GpuZoneVK& zone = frame->gpuZones[zoneIndex];
+	zone.endQuery              = frame->timestampIssuedCount++;
+
+	vkCmdWriteTimestamp(rc->m_commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, frame->timestampPool, zone.endQuery);
+}
+
+ArrayView<const GfxGpuZone> Gfx_GetGpuZones() { return g_device->m_resolvedGpuZones; }
+
 void Gfx_EndTimer(GfxContext* rc, u32 timestampId)
 {
 	RUSH_ASSERT(timestampId < GfxStats::MaxCustomTimers);
@@ -5612,6 +7164,10 @@ void Gfx_Retain(GfxBuffer h) { g_device->m_resources.buffers[h].addReference();
 void ShaderVK::destroy()
 {
 	RUSH_ASSERT(m_refs == 0);
+	if (cacheKey)
+	{
+		g_device->m_shaderCache.erase(cacheKey);
+	}
 	// TODO: queue-up destruction
 	vkDestroyShaderModule(g_vulkanDevice, module, g_allocationCallbacks);
 }
@@ -5648,48 +7204,97 @@ void BufferVK::destroy()
 const GfxCapability& Gfx_GetCapability() { return g_device->m_caps; }
 
 
-void DestructionQueueVK::flush(GfxDevice* device)
+u32 DestructionQueueVK::flush(GfxDevice* device)
 {
-	struct DestructionDispatcher
+	RUSH_ASSERT(device != nullptr);
+
+	VkDevice vulkanDevice = device->m_vulkanDevice;
+	RUSH_ASSERT(vulkanDevice != VK_NULL_HANDLE);
+
+	// Objects may be enqueued while the batch is being destroyed, e.g. by worker threads
+	Items& batch      = m_batch;
+	u32    batchCount = 0;
 	{
-		GfxDevice* device;
-		VkDevice   vulkanDevice;
-		DestructionDispatcher(GfxDevice* in_device) : device(in_device), vulkanDevice(in_device->m_vulkanDevice) 
-		{
-			RUSH_ASSERT(device != nullptr);
-			RUSH_ASSERT(vulkanDevice != VK_NULL_HANDLE);
-		}
+		std::lock_guard<std::mutex> lock(m_mutex);
+		std::swap(batch, m_items);
+		std::swap(batchCount, m_count);
+	}
 
-		// Vulkan objects
-		void operator()(VkPipeline x) { vkDestroyPipeline(vulkanDevice, x, g_allocationCallbacks); };
-		void operator()(VkSampler x) { vkDestroySampler(vulkanDevice, x, g_allocationCallbacks); };
-		void operator()(VkDeviceMemory x) { vkFreeMemory(vulkanDevice, x, g_allocationCallbacks); };
-		void operator()(VkBuffer x) { vkDestroyBuffer(vulkanDevice, x, g_allocationCallbacks); };
-		void operator()(VkImage x) { vkDestroyImage(vulkanDevice, x, g_allocationCallbacks); };
-		void operator()(VkImageView x) { vkDestroyImageView(vulkanDevice, x, g_allocationCallbacks); };
-		void operator()(VkBufferView x) { vkDestroyBufferView(vulkanDevice, x, g_allocationCallbacks); };
-		void operator()(VkSemaphore x) { vkDestroySemaphore(vulkanDevice, x, g_allocationCallbacks); };
-		void operator()(VkAccelerationStructureKHR x)
-		{
-			vkDestroyAccelerationStructureKHR(vulkanDevice, x, g_allocationCallbacks);
-		};
-		void operator()(VkQueryPool x) { vkDestroyQueryPool(vulkanDevice, x, g_allocationCallbacks); };
+	if (batchCount == 0)
+	{
+		return 0;
+	}
 
-		// Custom objects
-		void operator()(GfxContext* x) { device->m_freeContexts[u32(x->m_type)].push_back(x); };
-		void operator()(DescriptorPoolVK* x) { delete x; };
-		void operator()(TransientHostMemoryBlockVK& x)
-		{
-			x.offset = 0;
-			device->m_transientHostAllocator.addBlock(x);
-		};
-	} dispatcher(device);
+	// Users of buffers, images and memory are destroyed first
+
+	for (VkPipeline x : batch.pipelines)
+	{
+		vkDestroyPipeline(vulkanDevice, x, g_allocationCallbacks);
+	}
+	for (VkImageView x : batch.imageViews)
+	{
+		vkDestroyImageView(vulkanDevice, x, g_allocationCallbacks);
+	}
+	for (VkBufferView x : batch.bufferViews)
+	{
+		vkDestroyBufferView(vulkanDevice, x, g_allocationCallbacks);
+	}
+	for (VkAccelerationStructureKHR x : batch.accelerationStructures)
+	{
+		vkDestroyAccelerationStructureKHR(vulkanDevice, x, g_allocationCallbacks);
+	}
+
+	// Buffers and images, followed by the memory they were bound to
+
+	for (VkBuffer x : batch.buffers)
+	{
+		vkDestroyBuffer(vulkanDevice, x, g_allocationCallbacks);
+	}
+	for (VkImage x : batch.images)
+	{
+		vkDestroyImage(vulkanDevice, x, g_allocationCallbacks);
+	}
+	for (VkDeviceMemory x : batch.memory)
+	{
+		vkFreeMemory(vulkanDevice, x, g_allocationCallbacks);
+	}
+	for (TransientHostMemoryBlockVK& x : batch.transientHostBlocks)
+	{
+		x.offset = 0;
+		device->m_transientHostAllocator.addBlock(x);
+	}
+
+	// Independent objects
+
+	for (VkSampler x : batch.samplers)
+	{
+		vkDestroySampler(vulkanDevice, x, g_allocationCallbacks);
+	}
+	for (VkQueryPool x : batch.queryPools)
+	{
+		vkDestroyQueryPool(vulkanDevice, x, g_allocationCallbacks);
+	}
+	for (VkSemaphore x : batch.semaphores)
+	{
+		vkDestroySemaphore(vulkanDevice, x, g_allocationCallbacks);
+	}
+
+	// Custom objects
 
-	for (DestructionQueueVK::Item& item : items)
+	for (GfxContext* x : batch.contexts)
+	{
+		device->m_freeContexts[u32(x->m_type)].push_back(x);
+	}
+	for (DescriptorPoolVK* x : batch.descriptorPools)
 	{
-		std::visit(dispatcher, item);
+		device->m_descriptorPoolAllocator.destroy(x);
 	}
-	items.clear();
+
+	batch.clear();
+
+	device->m_stats.deferredDestructions += batchCount;
+
+	return batchCount;
 }
 
 const char* toString(VkResult value)
@@ -5810,7 +7415,7 @@ GfxOwn<GfxRayTracingPipeline> Gfx_CreateRayTracingPipeline(const GfxRayTracingPi
 	pipelineLayoutCreateInfo.setLayoutCount             = u32(result.setLayouts.size());
 	pipelineLayoutCreateInfo.pSetLayouts                = result.setLayouts.data;
 
-	V(vkCreatePipelineLayout(g_vulkanDevice, &pipelineLayoutCreateInfo, nullptr, &result.pipelineLayout));
+	V(vkCreatePipelineLayout(g_vulkanDevice, &pipelineLayoutCreateInfo, g_allocationCallbacks, &result.pipelineLayout));
 
 	// ray tracing pipeline
 
@@ -5977,10 +7582,49 @@ static VkAccelerationStructureBuildSizesInfoKHR getBuildSizeInfo(
 	return sizeInfo;
 }
 
+static VkBuildAccelerationStructureFlagsKHR convertAccelerationStructureBuildFlags(GfxAccelerationStructureBuildFlags flags)
+{
+	VkBuildAccelerationStructureFlagsKHR result = 0;
+
+	if (!!(flags & GfxAccelerationStructureBuildFlags::AllowUpdate))
+		result |= VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_UPDATE_BIT_KHR;
+	if (!!(flags & GfxAccelerationStructureBuildFlags::AllowCompaction))
+		result |= VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_COMPACTION_BIT_KHR;
+	if (!!(flags & GfxAccelerationStructureBuildFlags::FastTrace))
+		result |= VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR;
+	if (!!(flags & GfxAccelerationStructureBuildFlags::FastBuild))
+		result |= VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_BUILD_BIT_KHR;
+	if (!!(flags & GfxAccelerationStructureBuildFlags::LowMemory))
+		result |= VK_BUILD_ACCELERATION_STRUCTURE_LOW_MEMORY_BIT_KHR;
+
+	return result;
+}
+
+static VkAccelerationStructureKHR createAccelerationStructureNative(
+    VkAccelerationStructureCreateInfoKHR& createInfo, BufferVK& buffer, u64 size, u64& deviceAddress)
+{
+	GfxBufferDesc bufferDesc(GfxBufferFlags::RayTracing, (u32)size, 1);
+	buffer = createBuffer(bufferDesc, nullptr);
+
+	createInfo.buffer = buffer.info.buffer;
+	createInfo.offset = buffer.info.offset;
+	createInfo.size   = buffer.info.range;
+
+	VkAccelerationStructureKHR result = VK_NULL_HANDLE;
+	V(vkCreateAccelerationStructureKHR(g_vulkanDevice, &createInfo, g_allocationCallbacks, &result));
+
+	VkAccelerationStructureDeviceAddressInfoKHR deviceAddressInfo = { VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_DEVICE_ADDRESS_INFO_KHR };
+	deviceAddressInfo.accelerationStructure = result;
+	deviceAddress = vkGetAccelerationStructureDeviceAddressKHR(g_vulkanDevice, &deviceAddressInfo);
+
+	return result;
+}
+
 GfxOwn<GfxAccelerationStructure> Gfx_CreateAccelerationStructure(const GfxAccelerationStructureDesc& desc)
 {
 	AccelerationStructureVK result;
-	result.type = desc.type;
+	result.type  = desc.type;
+	result.flags = desc.flags;
 
 	if (desc.type == GfxAccelerationStructureType::BottomLevel)
 	{
@@ -6072,25 +7716,28 @@ GfxOwn<GfxAccelerationStructure> Gfx_CreateAccelerationStructure(const GfxAccele
 	result.buildInfo.geometryCount = u32(result.nativeGeometries.size());
 	result.buildInfo.pGeometries   = result.nativeGeometries.data();
 
-	result.buildInfo.flags         = VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR;
+	result.buildInfo.flags         = convertAccelerationStructureBuildFlags(desc.flags);
 	result.buildInfo.mode          = VK_BUILD_ACCELERATION_STRUCTURE_MODE_BUILD_KHR;
 
 	result.buildSize = getBuildSizeInfo(VK_ACCELERATION_STRUCTURE_BUILD_TYPE_DEVICE_KHR, &result.buildInfo, result.primitiveCounts.data());
 
-	GfxBufferDesc bufferDesc(GfxBufferFlags::RayTracing, (u32)result.buildSize.accelerationStructureSize, 1);
-	result.buffer = createBuffer(bufferDesc, nullptr);
+	result.createInfo.type = result.buildInfo.type;
 
-	result.createInfo.buffer = result.buffer.info.buffer;
-	result.createInfo.offset = result.buffer.info.offset;
-	result.createInfo.size   = result.buffer.info.range;
+	result.native = createAccelerationStructureNative(
+	    result.createInfo, result.buffer, result.buildSize.accelerationStructureSize, result.deviceAddress);
 
-	result.createInfo.type = result.buildInfo.type;
+	if (desc.type == GfxAccelerationStructureType::BottomLevel &&
+	    !!(desc.flags & GfxAccelerationStructureBuildFlags::AllowCompaction))
+	{
+		VkQueryPoolCreateInfo queryPoolCreateInfo = {VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO};
+		queryPoolCreateInfo.queryType             = VK_QUERY_TYPE_ACCELERATION_STRUCTURE_COMPACTED_SIZE_KHR;
+		queryPoolCreateInfo.queryCount            = 1;
 
-	V(vkCreateAccelerationStructureKHR(g_vulkanDevice, &result.createInfo, g_allocationCallbacks, &result.native));
+		V(vkCreateQueryPool(g_vulkanDevice, &queryPoolCreateInfo, g_allocationCallbacks, &result.compactedSizeQuery));
 
-	VkAccelerationStructureDeviceAddressInfoKHR deviceAddressInfo = { VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_DEVICE_ADDRESS_INFO_KHR };
-	deviceAddressInfo.accelerationStructure = result.native;
-	result.deviceAddress = vkGetAccelerationStructureDeviceAddressKHR(g_vulkanDevice, &deviceAddressInfo);
+		// Queries must be reset before first use
+		vkCmdResetQueryPool(getUploadContext()->m_commandBuffer, result.compactedSizeQuery, 0, 1);
+	}
 
 	return retainResource(g_device->m_resources.accelerationStructures, result);
 }
@@ -6103,45 +7750,217 @@ u64 Gfx_GetAccelerationStructureHandle(GfxAccelerationStructureArg h)
 
 void Gfx_BuildAccelerationStructure(GfxContext* ctx, GfxAccelerationStructureArg h, GfxBufferArg instanceBuffer)
 {
-	// TODO: batch acceleration structure builds / updates
+	GfxAccelerationStructureBuild build;
+	build.accelerationStructure = h;
+	build.instanceBuffer        = instanceBuffer;
 
-	AccelerationStructureVK& accel = g_device->m_resources.accelerationStructures[h];
+	Gfx_BuildAccelerationStructures(ctx, &build, 1);
+}
 
-	VkAccelerationStructureBuildGeometryInfoKHR buildInfo = accel.buildInfo;
+static void addAccelerationStructureBarrier(GfxContext* ctx)
+{
+	VkMemoryBarrier barrier = {VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+	barrier.srcAccessMask   = VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR;
+	barrier.dstAccessMask   = VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR | VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR;
 
-	RUSH_ASSERT(accel.native != VK_NULL_HANDLE);
+	vkCmdPipelineBarrier(ctx->m_commandBuffer, VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR,
+	    VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR, 0, 1, &barrier, 0, nullptr, 0, nullptr);
 
-	VkDescriptorBufferInfo instanceBufferInfo = {};
+	g_device->m_stats.barriers++;
+}
 
-	if (accel.type == GfxAccelerationStructureType::TopLevel && instanceBuffer.valid())
+void Gfx_BuildAccelerationStructures(GfxContext* ctx, const GfxAccelerationStructureBuild* builds, u32 count)
+{
+	if (count == 0)
 	{
-		instanceBufferInfo = g_device->m_resources.buffers[instanceBuffer].info;
+		return;
 	}
 
-	if (accel.type == GfxAccelerationStructureType::TopLevel)
+	ctx->flushBarriers();
+
+	const u64 scratchAlignment =
+	    max<u64>(256, g_device->m_accelerationStructureProps.minAccelerationStructureScratchOffsetAlignment);
+
+	DynamicArray<VkAccelerationStructureBuildGeometryInfoKHR>     buildInfos;
+	DynamicArray<const VkAccelerationStructureBuildRangeInfoKHR*> rangeInfos;
+	DynamicArray<u64>                                             scratchOffsets;
+	DynamicArray<VkAccelerationStructureKHR>                      compactedSizeStructures;
+	DynamicArray<VkQueryPool>                                     compactedSizeQueries;
+
+	buildInfos.reserve(count);
+	rangeInfos.reserve(count);
+	scratchOffsets.reserve(count);
+
+	// Builds within one command may not depend on each other, so bottom level structures are built first
+	const GfxAccelerationStructureType buildOrder[] = {
+	    GfxAccelerationStructureType::BottomLevel, GfxAccelerationStructureType::TopLevel};
+
+	bool previousGroupBuilt = false;
+
+	for (GfxAccelerationStructureType groupType : buildOrder)
 	{
-		RUSH_ASSERT(accel.nativeGeometries.size() == 1);
+		buildInfos.clear();
+		rangeInfos.clear();
+		scratchOffsets.clear();
+
+		u64 scratchSize = 0;
+
+		for (u32 i = 0; i < count; ++i)
+		{
+			AccelerationStructureVK& accel = g_device->m_resources.accelerationStructures[builds[i].accelerationStructure];
+			if (accel.type != groupType)
+			{
+				continue;
+			}
+
+			RUSH_ASSERT(accel.native != VK_NULL_HANDLE);
+			RUSH_ASSERT(!accel.rangeInfos.empty());
+
+			const bool isUpdate = builds[i].update && accel.built;
+			RUSH_ASSERT_MSG(!isUpdate || !!(accel.flags & GfxAccelerationStructureBuildFlags::AllowUpdate),
+			    "Acceleration structure update requires GfxAccelerationStructureBuildFlags::AllowUpdate");
+
+			if (accel.type == GfxAccelerationStructureType::TopLevel)
+			{
+				RUSH_ASSERT(accel.nativeGeometries.size() == 1);
 
-		BufferVK& instanceBufferVK = g_device->m_resources.buffers[instanceBuffer];
+				BufferVK& instanceBufferVK = g_device->m_resources.buffers[builds[i].instanceBuffer];
 
-		VkAccelerationStructureGeometryInstancesDataKHR& instances = accel.nativeGeometries[0].geometry.instances;
-		instances.arrayOfPointers = VK_FALSE;
-		instances.data.deviceAddress = instanceBufferVK.deviceAddress;
+				VkAccelerationStructureGeometryInstancesDataKHR& instances = accel.nativeGeometries[0].geometry.instances;
+				instances.arrayOfPointers    = VK_FALSE;
+				instances.data.deviceAddress = instanceBufferVK.deviceAddress;
+			}
+
+			if (accel.compacted && !isUpdate)
+			{
+				// Compacted storage only fits updates, full builds need the original size
+				enqueueDestroy(accel.native);
+				accel.buffer.destroy();
+
+				accel.native = createAccelerationStructureNative(
+				    accel.createInfo, accel.buffer, accel.buildSize.accelerationStructureSize, accel.deviceAddress);
+				accel.compacted = false;
+			}
+
+			VkAccelerationStructureBuildGeometryInfoKHR buildInfo = accel.buildInfo;
+			buildInfo.pGeometries              = accel.nativeGeometries.data();
+			buildInfo.mode = isUpdate ? VK_BUILD_ACCELERATION_STRUCTURE_MODE_UPDATE_KHR : VK_BUILD_ACCELERATION_STRUCTURE_MODE_BUILD_KHR;
+			buildInfo.srcAccelerationStructure = isUpdate ? accel.native : VK_NULL_HANDLE;
+			buildInfo.dstAccelerationStructure = accel.native;
+
+			buildInfos.push_back(buildInfo);
+			rangeInfos.push_back(accel.rangeInfos.data());
+			scratchOffsets.push_back(scratchSize);
+
+			const u64 buildScratchSize = isUpdate ? accel.buildSize.updateScratchSize : accel.buildSize.buildScratchSize;
+			scratchSize += alignCeiling(buildScratchSize, scratchAlignment);
+
+			accel.built = true;
+
+			if (accel.compactedSizeQuery && !isUpdate)
+			{
+				compactedSizeStructures.push_back(accel.native);
+				compactedSizeQueries.push_back(accel.compactedSizeQuery);
+				accel.compactedSizePending = true;
+				accel.compactedSizeFrame   = g_device->m_frameCount;
+			}
+		}
+
+		if (buildInfos.empty())
+		{
+			continue;
+		}
+
+		if (previousGroupBuilt)
+		{
+			addAccelerationStructureBarrier(ctx);
+		}
+
+		// Scratch memory for the whole group comes from a single transient allocation
+		MemoryBlockVK scratchBlock = g_device->m_transientLocalAllocator.alloc(scratchSize, scratchAlignment);
+		for (size_t i = 0; i < buildInfos.size(); ++i)
+		{
+			buildInfos[i].scratchData.deviceAddress = scratchBlock.deviceAddress + scratchOffsets[i];
+		}
+
+		vkCmdBuildAccelerationStructuresKHR(ctx->m_commandBuffer, u32(buildInfos.size()), buildInfos.data(), rangeInfos.data());
+
+		previousGroupBuilt = true;
+	}
+
+	if (!compactedSizeStructures.empty())
+	{
+		addAccelerationStructureBarrier(ctx);
+
+		for (size_t i = 0; i < compactedSizeStructures.size(); ++i)
+		{
+			vkCmdResetQueryPool(ctx->m_commandBuffer, compactedSizeQueries[i], 0, 1);
+			vkCmdWriteAccelerationStructuresPropertiesKHR(ctx->m_commandBuffer, 1, &compactedSizeStructures[i],
+			    VK_QUERY_TYPE_ACCELERATION_STRUCTURE_COMPACTED_SIZE_KHR, compactedSizeQueries[i], 0);
+		}
 	}
+}
 
-	buildInfo.srcAccelerationStructure = VK_NULL_HANDLE;
-	buildInfo.dstAccelerationStructure = accel.native;
+u32 Gfx_CompactAccelerationStructures(GfxContext* ctx, const GfxAccelerationStructure* handles, u32 count)
+{
+	u32 compactedCount = 0;
+
+	for (u32 i = 0; i < count; ++i)
+	{
+		AccelerationStructureVK& accel = g_device->m_resources.accelerationStructures[handles[i]];
+		// Until the frame of the build is retired, the query may still hold the result of a previous build
+		if (!accel.compactedSizePending || accel.compactedSizeFrame >= g_device->m_retiredFrameCount)
+		{
+			continue;
+		}
+
+		u64      compactedSize = 0;
+		VkResult result        = vkGetQueryPoolResults(g_vulkanDevice, accel.compactedSizeQuery, 0, 1,
+            sizeof(compactedSize), &compactedSize, sizeof(compactedSize), VK_QUERY_RESULT_64_BIT);
+		if (result != VK_SUCCESS)
+		{
+			continue;
+		}
+
+		accel.compactedSizePending = false;
+
+		if (compactedSize == 0 || compactedSize >= accel.createInfo.size)
+		{
+			continue;
+		}
+
+		VkAccelerationStructureCreateInfoKHR createInfo = accel.createInfo;
 
-	const u32          scratchAlignment = 256; // TODO: what should the alignment be?
-	MemoryAllocatorVK& scratchAllocator = g_device->m_transientLocalAllocator;
-	MemoryBlockVK      scratchBlock     = scratchAllocator.alloc(accel.buildSize.buildScratchSize, scratchAlignment);
+		BufferVK                   buffer;
+		u64                        deviceAddress = 0;
+		VkAccelerationStructureKHR native = createAccelerationStructureNative(createInfo, buffer, compactedSize, deviceAddress);
 
-	buildInfo.scratchData.deviceAddress = scratchBlock.deviceAddress;
+		VkCopyAccelerationStructureInfoKHR copyInfo = {VK_STRUCTURE_TYPE_COPY_ACCELERATION_STRUCTURE_INFO_KHR};
+		copyInfo.src                                = accel.native;
+		copyInfo.dst                                = native;
+		copyInfo.mode                               = VK_COPY_ACCELERATION_STRUCTURE_MODE_COMPACT_KHR;
 
-	RUSH_ASSERT(!accel.rangeInfos.empty());
-	const VkAccelerationStructureBuildRangeInfoKHR* rangeInfos[1] = { accel.rangeInfos.data() };
+		vkCmdCopyAccelerationStructureKHR(ctx->m_commandBuffer, &copyInfo);
 
-	vkCmdBuildAccelerationStructuresKHR(ctx->m_commandBuffer, 1, &buildInfo, rangeInfos);
+		// Original is released once the GPU is done with the copy
+		enqueueDestroy(accel.native);
+		accel.buffer.destroy();
+
+		accel.native        = native;
+		accel.buffer        = std::move(buffer);
+		accel.createInfo    = createInfo;
+		accel.deviceAddress = deviceAddress;
+		accel.compacted     = true;
+
+		++compactedCount;
+	}
+
+	if (compactedCount)
+	{
+		addAccelerationStructureBarrier(ctx);
+	}
+
+	return compactedCount;
 }
 
 void Gfx_Retain(GfxAccelerationStructure h) { g_device->m_resources.accelerationStructures[h].addReference(); }
@@ -6261,6 +8080,12 @@ void AccelerationStructureVK::destroy()
 		native = VK_NULL_HANDLE;
 	}
 
+	if (compactedSizeQuery != VK_NULL_HANDLE)
+	{
+		enqueueDestroy(compactedSizeQuery);
+		compactedSizeQuery = VK_NULL_HANDLE;
+	}
+
 	buffer.destroy();
 }
 
@@ -6286,6 +8111,11 @@ static QueryPoolVK createQueryPool(const GfxQueryPoolDesc& desc)
 	{
 	case GfxQuueryType::Occlusion: info.queryType = VK_QUERY_TYPE_OCCLUSION; break;
 	case GfxQuueryType::Timestamp: info.queryType = VK_QUERY_TYPE_TIMESTAMP; break;
+	case GfxQuueryType::PipelineStatistics:
+		RUSH_ASSERT_MSG(g_device->m_caps.pipelineStatistics, "Pipeline statistics queries are not supported");
+		info.queryType          = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+		info.pipelineStatistics = VkQueryPipelineStatisticFlags(desc.pipelineStatistics);
+		break;
 	default: RUSH_LOG_ERROR("Unexpected query type"); break;
 	}
 
@@ -6309,7 +8139,14 @@ void Gfx_ResetQuery(GfxContext* ctx, GfxQueryPool pool, u32 index, u32 count)
 
 void Gfx_BeginQuery(GfxContext* ctx, GfxQueryPool pool, u32 index, GfxQueryControlFlags flags)
 {
-	vkCmdBeginQuery(ctx->m_commandBuffer, g_device->m_resources.queryPools[pool].native, index, VkQueryControlFlags(flags));
+	const QueryPoolVK& queryPool = g_device->m_resources.queryPools[pool];
+
+	// Pass statistics queries would overlap with this one, see GfxConfig::pipelineStatistics
+	RUSH_ASSERT_MSG(queryPool.desc.type != GfxQuueryType::PipelineStatistics || ctx->m_type != GfxContextType::Graphics ||
+	                    !g_device->m_pipelineStatisticsEnabled,
+	    "Pipeline statistics queries can't be used together with GfxConfig::pipelineStatistics");
+
+	vkCmdBeginQuery(ctx->m_commandBuffer, queryPool.native, index, VkQueryControlFlags(flags));
 }
 
 void Gfx_EndQuery(GfxContext* ctx, GfxQueryPool pool, u32 index)
@@ -6317,11 +8154,19 @@ void Gfx_EndQuery(GfxContext* ctx, GfxQueryPool pool, u32 index)
 	vkCmdEndQuery(ctx->m_commandBuffer, g_device->m_resources.queryPools[pool].native, index);
 }
 
+void Gfx_WriteTimestamp(GfxContext* ctx, GfxQueryPool pool, u32 index)
+{
+	RUSH_ASSERT(g_device->m_resources.queryPools[pool].desc.type == GfxQuueryType::Timestamp);
+	vkCmdWriteTimestamp(ctx->m_commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+	    g_device->m_resources.queryPools[pool].native, index);
+}
+
 bool Gfx_GetQueryResults(
     GfxQueryPool pool, u32 index, u32 count, size_t dataSize, void* outData, u32 stride, GfxQueryResultFlags flags)
 {
 	VkResult res = vkGetQueryPoolResults(g_vulkanDevice, g_device->m_resources.queryPools[pool].native, index, count, dataSize,
 	    outData, VkDeviceSize(stride), VkQueryResultFlags(flags));
+	// VK_NOT_READY is expected when polling without Wait; with WithAvailability, available results are still written
 	return res == VK_SUCCESS;
 }
 
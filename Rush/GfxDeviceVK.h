@@ -12,9 +12,12 @@
 #include "UtilArray.h"
 #include "UtilHash.h"
 #include "UtilMemory.h"
+#include "UtilPoolAllocator.h"
 #include "UtilString.h"
 
+#include <atomic>
 #include <unordered_map>
+#include <unordered_set>
 
 #include <volk.h>
 
@@ -40,8 +43,13 @@ union MemoryTraitsVK {
 
 struct ShaderVK : GfxResourceBase
 {
-	VkShaderModule module = VK_NULL_HANDLE;
-	String         entry;
+	VkShaderModule module   = VK_NULL_HANDLE;
+	StringId       entry;
+	u64            cacheKey = 0; // key in GfxDevice::m_shaderCache, 0 if the module is not shared
+
+	// Independent hash and size of the SPIR-V, used to detect cache key collisions
+	u32 codeHash = 0;
+	u32 codeSize = 0;
 
 	struct InputMapping
 	{
@@ -85,9 +93,12 @@ struct TechniqueVK : PipelineBaseVK
 	u32 instanceDataStream = 0xFFFFFFFF;
 	u32 vertexStreamCount  = 0;
 
+	// Map entries and data are stored in the same allocation, right after the info structure
 	VkSpecializationInfo* specializationInfo = nullptr;
 
-	VkPipelineShaderStageCreateInfoWaveLimitAMD* waveLimits = nullptr;
+	struct WaveLimitsAMD; // per-stage VkPipelineShaderStageCreateInfoWaveLimitAMD
+
+	WaveLimitsAMD* waveLimits = nullptr; // allocated from GfxDevice::m_waveLimitsAllocator
 
 	void destroy();
 };
@@ -139,6 +150,17 @@ struct BlendStateVK : GfxResourceBase
 	void destroy(){};
 };
 
+struct ImageSubresourceStateVK
+{
+	VkImageLayout layout       = VK_IMAGE_LAYOUT_UNDEFINED;
+	bool          pendingWrite = false; // write not yet made visible by a barrier
+
+	bool operator==(const ImageSubresourceStateVK& other) const
+	{
+		return layout == other.layout && pendingWrite == other.pendingWrite;
+	}
+};
+
 struct TextureVK : GfxResourceBase
 {
 	GfxTextureDesc desc;
@@ -150,13 +172,18 @@ struct TextureVK : GfxResourceBase
 	VkImage image     = VK_NULL_HANDLE;
 	bool    ownsImage = false;
 
-	VkImageView   imageView             = VK_NULL_HANDLE;
-	VkImageView   depthStencilImageView = VK_NULL_HANDLE;
-	VkImageLayout currentLayout         = VK_IMAGE_LAYOUT_UNDEFINED;
+	VkImageView imageView             = VK_NULL_HANDLE;
+	VkImageView depthStencilImageView = VK_NULL_HANDLE;
+
+	// Indexed by arrayLayer * desc.mips + mipLevel
+	DynamicArray<ImageSubresourceStateVK> subresourceStates;
 
 	static TextureVK create(const GfxTextureDesc& desc, const GfxTextureData* data, u32 count, const void* pixels);
 	static TextureVK create(const GfxTextureDesc& desc, VkImage image, VkImageLayout initialLayout);
 
+	void initSubresourceStates(u32 arrayLayerCount, VkImageLayout layout);
+	u32  getArrayLayerCount() const { return u32(subresourceStates.size()) / desc.mips; }
+
 	void destroy();
 };
 
@@ -217,6 +244,16 @@ struct AccelerationStructureVK : GfxResourceBase
 
 	u32 instanceCount = 0;
 
+	GfxAccelerationStructureBuildFlags flags = GfxAccelerationStructureBuildFlags::None;
+
+	bool built = false;
+
+	// Only created for bottom level structures that allow compaction
+	VkQueryPool compactedSizeQuery   = VK_NULL_HANDLE;
+	bool        compactedSizePending = false;
+	u32         compactedSizeFrame   = 0; // frame of the last full build, its query result is valid once retired
+	bool        compacted            = false; // storage is smaller than required for a full build
+
 	BufferVK buffer;
 
 	void destroy();
@@ -244,12 +281,24 @@ struct PipelineInfoVK
 	GfxBlendState        blendStateHandle;
 	u32                  vertexBufferStride[MaxVertexStreams];
 	u32                  instanceBufferStride;
-	VkRenderPass         renderPass;
+	VkRenderPass         renderPass; // only used when dynamic rendering is not supported
+	GfxFormat            colorFormats[GfxPassDesc::MaxTargets];
+	GfxFormat            depthStencilFormat;
 	u32                  colorAttachmentCount;
 	u32                  colorSampleCount;
 	u32                  depthSampleCount;
 };
 
+// Identifies a queue submission that can be waited on or used as a cross-queue dependency.
+// With timeline semaphores, `semaphore` is the queue timeline and `value` the signaled value.
+// Otherwise `semaphore` is the binary completion semaphore (if any) and `fence` guards the submission.
+struct SubmissionVK
+{
+	VkFence     fence     = VK_NULL_HANDLE;
+	VkSemaphore semaphore = VK_NULL_HANDLE;
+	u64         value     = 0;
+};
+
 struct MemoryBlockVK
 {
 	VkDeviceMemory memory       = VK_NULL_HANDLE;
@@ -403,17 +452,34 @@ public:
 		u32          colorSampleCount;
 		u32          depthSampleCount;
 		GfxPrimitive primitiveType;
+		GfxFormat    colorFormats[GfxPassDesc::MaxTargets];
+		GfxFormat    depthStencilFormat;
+
+		// Static subset of the rasterizer state, used instead of rasterizerStateId with extended dynamic state
+		GfxFillMode  fillMode;
+		float        depthBias;
+		float        depthBiasSlopeScale;
 
 		bool operator==(const PipelineKey& other) const
 		{
 			if (techniqueId != other.techniqueId || blendStateId != other.blendStateId ||
 			    depthStencilStateId != other.depthStencilStateId || rasterizerStateId != other.rasterizerStateId ||
 			    primitiveType != other.primitiveType || colorAttachmentCount != other.colorAttachmentCount ||
-				colorSampleCount != other.colorSampleCount || depthSampleCount != other.depthSampleCount)
+				colorSampleCount != other.colorSampleCount || depthSampleCount != other.depthSampleCount ||
+				depthStencilFormat != other.depthStencilFormat || fillMode != other.fillMode ||
+				depthBias != other.depthBias || depthBiasSlopeScale != other.depthBiasSlopeScale)
 			{
 				return false;
 			}
 
+			for (u32 i = 0; i < colorAttachmentCount; ++i)
+			{
+				if (colorFormats[i] != other.colorFormats[i])
+				{
+					return false;
+				}
+			}
+
 			for (u32 i = 0; i < RUSH_COUNTOF(vertexBufferStride); ++i)
 			{
 				if (vertexBufferStride[i] != other.vertexBufferStride[i])
@@ -429,7 +495,42 @@ public:
 		{
 			size_t operator()(const PipelineKey& k) const
 			{
-				return (k.techniqueId) ^ (k.blendStateId << 16) ^ ((u32)k.primitiveType << 24);
+				return (k.techniqueId) ^ (k.blendStateId << 16) ^ ((u32)k.primitiveType << 24) ^
+				       ((u32)k.colorFormats[0] << 8) ^ ((u32)k.depthStencilFormat << 12);
+			}
+		};
+	};
+
+	struct SamplerKey
+	{
+		GfxSamplerDesc desc;
+
+		bool operator==(const SamplerKey& other) const
+		{
+			return desc.filterMin == other.desc.filterMin
+				&& desc.filterMag == other.desc.filterMag
+				&& desc.filterMip == other.desc.filterMip
+				&& desc.wrapU == other.desc.wrapU
+				&& desc.wrapV == other.desc.wrapV
+				&& desc.wrapW == other.desc.wrapW
+				&& desc.compareFunc == other.desc.compareFunc
+				&& desc.compareEnable == other.desc.compareEnable
+				&& desc.anisotropy == other.desc.anisotropy
+				&& desc.mipLodBias == other.desc.mipLodBias;
+		}
+
+		struct Hash
+		{
+			size_t operator()(const SamplerKey& k) const
+			{
+				// Hash members individually, as the descriptor contains padding
+				u8 filterAndWrap[] = {u8(k.desc.filterMin), u8(k.desc.filterMag), u8(k.desc.filterMip),
+				    u8(k.desc.wrapU), u8(k.desc.wrapV), u8(k.desc.wrapW), u8(k.desc.compareFunc),
+				    u8(k.desc.compareEnable)};
+				u64 result = hashFnv1a64(filterAndWrap, sizeof(filterAndWrap));
+				result = hashFnv1a64(&k.desc.anisotropy, sizeof(k.desc.anisotropy), result);
+				result = hashFnv1a64(&k.desc.mipLodBias, sizeof(k.desc.mipLodBias), result);
+				return size_t(result);
 			}
 		};
 	};
@@ -472,6 +573,9 @@ public:
 	VkPhysicalDeviceMeshShaderFeaturesNV m_nvMeshShaderFeatures = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MESH_SHADER_FEATURES_NV };
 	VkPhysicalDeviceBufferDeviceAddressFeatures m_bufferDeviceAddressFeatures = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_BUFFER_DEVICE_ADDRESS_FEATURES };
 	VkPhysicalDeviceShaderDrawParametersFeatures m_shaderDrawParametersFeatures = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_DRAW_PARAMETERS_FEATURES };
+	VkPhysicalDeviceDynamicRenderingFeatures m_dynamicRenderingFeatures = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES };
+	VkPhysicalDeviceTimelineSemaphoreFeatures m_timelineSemaphoreFeatures = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES };
+	VkPhysicalDeviceExtendedDynamicStateFeaturesEXT m_extendedDynamicStateFeatures = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_FEATURES_EXT };
 	VkPhysicalDeviceMemoryProperties m_deviceMemoryProps = {};
 	VkPhysicalDeviceAccelerationStructurePropertiesKHR m_accelerationStructureProps = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ACCELERATION_STRUCTURE_PROPERTIES_KHR };
 	VkPhysicalDeviceRayTracingPipelinePropertiesKHR m_rayTracingPipelineProps = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_RAY_TRACING_PIPELINE_PROPERTIES_KHR };
@@ -492,10 +596,16 @@ public:
 	VkPipelineCache m_pipelineCache = VK_NULL_HANDLE;
 
 	std::unordered_map<PipelineKey, VkPipeline, PipelineKey::Hash>          m_pipelines;
+	std::unordered_set<PipelineKey, PipelineKey::Hash>                      m_pipelinePermutations;
 	std::unordered_map<RenderPassKey, VkRenderPass, RenderPassKey::Hash>    m_renderPasses;
 	std::unordered_map<FrameBufferKey, VkFramebuffer, FrameBufferKey::Hash> m_frameBuffers;
 	std::unordered_map<DescriptorSetLayoutKey, VkDescriptorSetLayout, DescriptorSetLayoutKey::Hash> m_descriptorSetLayouts;
 
+	// Identical shaders and samplers share a single reference counted resource.
+	// Entries are removed when the last reference is released.
+	std::unordered_map<u64, UntypedResourceHandle>                  m_shaderCache; // hash of SPIR-V, entry and stage
+	std::unordered_map<SamplerKey, GfxSampler, SamplerKey::Hash>    m_samplerCache;
+
 	DynamicArray<VkPhysicalDevice>        m_physicalDevices;
 	DynamicArray<VkQueueFamilyProperties> m_queueProps;
 
@@ -511,6 +621,19 @@ public:
 	VkSemaphore               allocSemaphore();
 	void                      freeSemaphore(VkSemaphore x);
 
+	struct QueueTimelineVK
+	{
+		VkQueue     queue          = VK_NULL_HANDLE;
+		VkSemaphore semaphore      = VK_NULL_HANDLE;
+		u64         submittedValue = 0;
+	};
+
+	// One timeline semaphore per queue, indexed by GfxContextType
+	QueueTimelineVK  m_queueTimelines[u32(GfxContextType::count)];
+	QueueTimelineVK* getQueueTimeline(VkQueue queue);
+	u32              getQueueFamilyIndex(GfxContextType type) const;
+	void             waitForTimelineValues(const u64* values);
+
 	// swap chain
 
 	VkSwapchainKHR        m_swapChain                   = VK_NULL_HANDLE;
@@ -550,6 +673,23 @@ public:
 	template <typename HandleType>
 	static GfxOwn<HandleType> makeOwn(HandleType h) { return GfxOwn<HandleType>(h); }
 
+	static constexpr u32 MaxGpuZonesPerFrame = 1024;
+	static constexpr u32 TimestampPoolSize =
+	    2 * (GfxStats::MaxCustomTimers + 1) + // 2 slots per custom timer + 2 slots for total frame time
+	    2 * MaxGpuZonesPerFrame;
+
+	static constexpr u32 MaxPassStatsPerFrame = 256;
+
+	static constexpr u32 MaxAsyncComputePerFrame = 32; // async compute submissions with timing per frame
+
+	struct GpuZoneVK
+	{
+		const char* name       = nullptr;
+		u32         depth      = 0;
+		u32         beginQuery = ~0u;
+		u32         endQuery   = ~0u;
+	};
+
 	struct FrameData
 	{
 		FrameData();
@@ -563,10 +703,26 @@ public:
 		DynamicArray<u16> timestampSlotMap;
 		u32               timestampIssuedCount = 0;
 
+		DynamicArray<GpuZoneVK> gpuZones;
+
+		VkQueryPool               statisticsPool = VK_NULL_HANDLE; // only created if GfxConfig::pipelineStatistics is set
+		DynamicArray<GfxPassStats> passStats;
+		DynamicArray<u32>          passStatsQueries; // statistics query index for each pass, ~0u if none
+		u32                        statisticsQueryCount = 0;
+
+		// Begin and end timestamps of async compute submissions, only created if compute queue supports timestamps
+		VkQueryPool       asyncComputeTimestampPool = VK_NULL_HANDLE;
+		DynamicArray<u64> asyncComputeTimestampData;
+		u32               asyncComputeTimestampCount = 0;
+		double                  submitTime = 0.0; // CPU time of frame submission, used when timestamps can't be calibrated
+
 		UniquePtr<DestructionQueueVK> destructionQueue;
 
-		u32     frameIndex             = ~0u;
-		VkFence lastGraphicsFence      = VK_NULL_HANDLE;
+		u32          frameIndex = ~0u;
+		SubmissionVK lastGraphicsSubmission;
+
+		// Queue timeline values that must be reached before frame resources can be reused
+		u64 retireTimelineValues[u32(GfxContextType::count)] = {};
 
 		VkSemaphore presentCompleteSemaphore = VK_NULL_HANDLE;
 		bool        presentCompleteSemaphoreWaited = false;
@@ -575,11 +731,31 @@ public:
 	DynamicArray<FrameData> m_frameData;
 	FrameData*              m_currentFrame = nullptr;
 
+	// Destruction queue of the current frame, may be used from any thread. Published by beginFrame() only after the
+	// frame is retired, so that objects are never enqueued into a queue that is about to be flushed.
+	std::atomic<DestructionQueueVK*> m_currentDestructionQueue = {nullptr};
+
+	void initFrameData(FrameData& frame);
+	void retireFrame(FrameData& frame); // waits until frame resources are no longer used by the GPU and releases them
+
+	DynamicArray<u32>        m_gpuZoneStack;
+	DynamicArray<GfxGpuZone> m_resolvedGpuZones;
+	VkTimeDomainEXT          m_hostTimeDomain = VK_TIME_DOMAIN_DEVICE_EXT;
+
+	void resolveGpuZones(const FrameData& frame);
+
+	DynamicArray<GfxPassStats> m_resolvedPassStats;
+	DynamicArray<u64>          m_statisticsQueryData;
+	bool                       m_pipelineStatisticsEnabled = false;
+
+	void resolvePassStats(const FrameData& frame);
+
 	MemoryAllocatorVK m_transientLocalAllocator;
 	MemoryAllocatorVK m_transientHostAllocator;
 
 	u32 m_uniqueResourceCounter = 1;
 	u32 m_frameCount            = 0;
+	u32 m_retiredFrameCount     = 0; // frames with lower index are no longer used by the GPU
 
 	GfxStats m_stats;
 
@@ -587,9 +763,30 @@ public:
 
 	DynamicArray<GfxContext*> m_freeContexts[u32(GfxContextType::count)];
 
+	PoolAllocator<DescriptorPoolVK>           m_descriptorPoolAllocator;
+	PoolAllocator<TechniqueVK::WaveLimitsAMD> m_waveLimitsAllocator;
+
 	u32 m_presentInterval            = 1;
 	u32 m_desiredPresentInterval     = m_presentInterval;
-	u32 m_desiredSwapChainImageCount = 2;
+
+	GfxPresentMode m_presentMode        = GfxPresentMode::Default; // requested mode the swap chain was created with
+	GfxPresentMode m_desiredPresentMode = m_presentMode;
+
+	// Frame latency limiting
+
+	static constexpr u32 MaxFramesInFlight = 8;
+
+	struct InFlightFrame
+	{
+		u64 timelineValues[u32(GfxContextType::count)] = {};
+	};
+
+	InFlightFrame m_inFlightFrames[MaxFramesInFlight];
+	u64           m_presentedFrameCount = 0;
+	u32           m_maxFramesInFlight   = 2;
+	bool          m_frameLatencyWaited  = false;
+
+	void waitForFrameLatency();
 
 	Window*             m_window = nullptr;
 	WindowEventListener m_resizeEvents;
@@ -613,14 +810,19 @@ public:
 		bool AMD_negative_viewport_height         = false;
 		bool AMD_shader_explicit_vertex_parameter = false;
 		bool AMD_wave_limits                      = false;
+		bool EXT_calibrated_timestamps            = false;
 		bool EXT_descriptor_indexing              = false;
+		bool EXT_extended_dynamic_state           = false;
 		bool EXT_sample_locations                 = false;
 		bool KHR_buffer_device_address            = false;
 		bool KHR_deferred_host_operations         = false;
+		bool KHR_draw_indirect_count              = false;
+		bool KHR_dynamic_rendering                = false;
 		bool KHR_maintenance1                     = false;
 		bool KHR_pipeline_library                 = false;
 		bool KHR_ray_tracing                      = false;
 		bool KHR_ray_query                        = false;
+		bool KHR_timeline_semaphore               = false;
 		bool NV_framebuffer_mixed_samples         = false;
 		bool NV_geometry_shader_passthrough       = false;
 		bool NV_mesh_shader                       = false;
@@ -681,27 +883,58 @@ public:
 	void beginBuild();
 	void endBuild();
 	void submit(VkQueue queue);
-	void split();
+	SubmissionVK split(); // returns the submission of the work recorded before the split
 	void addDependency(VkSemaphore waitSemaphore, VkPipelineStageFlags waitDstStageMask);
+	void addDependency(const SubmissionVK& submission, VkPipelineStageFlags waitDstStageMask);
+	void waitForCompletion();
 
 	// TODO: buffer barriers!
 	VkImageLayout addImageBarrier(VkImage image, VkImageLayout nextLayout, VkImageLayout currentLayout,
-	    VkImageSubresourceRange* subresourceRange = nullptr, bool force = false);
+	    const VkImageSubresourceRange* subresourceRange = nullptr, bool force = false);
+	void addTextureBarrier(TextureVK& texture, VkImageLayout nextLayout,
+	    const VkImageSubresourceRange* subresourceRange = nullptr, bool isWrite = false);
 	void addBufferBarrier(GfxBuffer h, VkAccessFlagBits srcAccess, VkAccessFlagBits dstAccess,
 	    VkPipelineStageFlagBits srcStage, VkPipelineStageFlagBits dstStage);
 	void flushBarriers();
 
 	void beginRenderPass(const GfxPassDesc& desc);
 	void endRenderPass();
+
+	void beginPassStats(bool isCompute);
+	void endPassStats();
+
 	void resolveImage(GfxTextureArg src, GfxTextureArg dst);
 
 	void applyState();
+	bool isDefaultDescriptorSetCompatible(const PipelineBaseVK& pipelineBase, VkPipelineBindPoint bindPoint) const;
+	void applyDynamicState();
 
 	VkFence             m_fence                = VK_NULL_HANDLE;
 	VkCommandBuffer     m_commandBuffer        = VK_NULL_HANDLE;
 	VkDescriptorSet     m_currentDescriptorSet = VK_NULL_HANDLE;
 	VkPipelineBindPoint m_currentBindPoint     = VK_PIPELINE_BIND_POINT_MAX_ENUM;
 
+	// Layout compatibility info of the currently bound default descriptor set.
+	// Bound descriptor sets stay valid across pipeline changes if the new pipeline layout is compatible.
+	struct BoundDescriptorSetInfo
+	{
+		VkDescriptorSetLayout layout                 = VK_NULL_HANDLE;
+		VkPipelineBindPoint   bindPoint              = VK_PIPELINE_BIND_POINT_MAX_ENUM;
+		VkShaderStageFlags    pushConstantStageFlags = 0;
+		u32                   pushConstantsSize      = 0;
+	} m_boundDescriptorSet;
+
+	// Extended dynamic state values last recorded into the command buffer
+	struct DynamicStateVK
+	{
+		VkPrimitiveTopology primitiveTopology = VK_PRIMITIVE_TOPOLOGY_MAX_ENUM;
+		VkCullModeFlags     cullMode          = VK_CULL_MODE_FLAG_BITS_MAX_ENUM;
+		VkFrontFace         frontFace         = VK_FRONT_FACE_MAX_ENUM;
+		VkCompareOp         depthCompareOp    = VK_COMPARE_OP_MAX_ENUM;
+		u8                  depthTestEnable   = 0xFF;
+		u8                  depthWriteEnable  = 0xFF;
+	} m_dynamicState;
+
 	bool        m_isActive = false;
 	const char* m_name     = "";
 
@@ -761,9 +994,13 @@ public:
 	ClearParamsVK m_pendingClear;
 	bool          m_isRenderPassActive = false;
 
-	VkFramebuffer m_currentFrameBuffer = VK_NULL_HANDLE;
+	u32      m_activePassStats = ~0u; // index into current frame pass stats
+	GfxStats m_passStatsBegin;        // device stats at the start of the active pass
+
 	VkRenderPass  m_currentRenderPass  = VK_NULL_HANDLE;
 	GfxPassDesc   m_currentRenderPassDesc;
+	GfxFormat     m_currentColorFormats[GfxPassDesc::MaxTargets] = {};
+	GfxFormat     m_currentDepthStencilFormat = GfxFormat_Unknown;
 	u32           m_currentColorAttachmentCount = 0;
 	u32           m_currentColorSampleCount = 0;
 	u32           m_currentDepthSampleCount = 0;
@@ -773,8 +1010,16 @@ public:
 	VkSemaphore m_completionSemaphore    = VK_NULL_HANDLE;
 	bool        m_useCompletionSemaphore = false;
 
-	DynamicArray<VkSemaphore>          m_waitSemaphores;
-	DynamicArray<VkPipelineStageFlags> m_waitDstStageMasks;
+	static constexpr u32 InlineWaitSemaphoreCount = 8;
+	static constexpr u32 InlineBarrierCount       = 16;
+
+	SmallVector<VkSemaphore, InlineWaitSemaphoreCount>          m_waitSemaphores;
+	SmallVector<u64, InlineWaitSemaphoreCount>                  m_waitValues;
+	SmallVector<VkPipelineStageFlags, InlineWaitSemaphoreCount> m_waitDstStageMasks;
+
+	SubmissionVK m_lastSubmission;
+
+	u32 m_asyncComputeTimestampQuery = ~0u; // first of the begin/end query pair in FrameData::asyncComputeTimestampPool
 
 	GfxContextType m_type = GfxContextType::Graphics;
 
@@ -785,8 +1030,8 @@ public:
 		u32                                 srcStageMask    = 0; // VkPipelineStageFlagBits
 		u32                                 dstStageMask    = 0; // VkPipelineStageFlagBits
 		u32                                 dependencyFlags = 0;
-		DynamicArray<VkImageMemoryBarrier>  imageBarriers;
-		DynamicArray<VkBufferMemoryBarrier> bufferBarriers;
+		SmallVector<VkImageMemoryBarrier, InlineBarrierCount>  imageBarriers;
+		SmallVector<VkBufferMemoryBarrier, InlineBarrierCount> bufferBarriers;
 	} m_pendingBarriers;
 
 	struct BufferCopyCommand
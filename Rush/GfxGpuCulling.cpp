@@ -0,0 +1,83 @@
+#include "GfxGpuCulling.h"
+#include "UtilLog.h"
+
+namespace Rush
+{
+
+GfxGpuCulling::GfxGpuCulling(const GfxShaderSource& cullingShader)
+{
+	m_computeShader = Gfx_CreateComputeShader(cullingShader);
+
+	GfxShaderBindingDesc bindings;
+	bindings.descriptorSets[0].constantBuffers = 1;
+	bindings.descriptorSets[0].rwBuffers       = 3; // instances, draw arguments, draw count
+
+	m_technique = Gfx_CreateTechnique(GfxTechniqueDesc(m_computeShader, bindings, {WorkGroupSize, 1, 1}));
+
+	m_constantBuffer =
+	    Gfx_CreateBuffer(GfxBufferDesc(GfxBufferFlags::TransientConstant, GfxFormat_Unknown, 1, sizeof(Constants)));
+
+	// Count is cleared by uploading a zero every frame, which requires a transient buffer
+	m_drawCount = Gfx_CreateBuffer(GfxBufferDesc(
+	    GfxBufferFlags::Transient | GfxBufferFlags::Storage | GfxBufferFlags::IndirectArgs, GfxFormat_Unknown, 1, 4));
+}
+
+GfxGpuCulling::~GfxGpuCulling() {}
+
+void GfxGpuCulling::cull(GfxContext* ctx, GfxBufferArg instances, u32 instanceCount, const Frustum& frustum)
+{
+	if (instanceCount > m_drawArgsCapacity)
+	{
+		m_drawArgsCapacity = max<u32>(instanceCount, m_drawArgsCapacity * 2);
+		m_drawArgs         = Gfx_CreateBuffer(GfxBufferDesc(GfxBufferFlags::Storage | GfxBufferFlags::IndirectArgs,
+            GfxFormat_Unknown, m_drawArgsCapacity, sizeof(GfxDrawIndexedArg)));
+	}
+	else
+	{
+		// Previous draws may still be reading the arguments
+		Gfx_AddBufferBarrier(ctx, m_drawArgs, GfxResourceState_ShaderRead, GfxResourceState_General);
+	}
+
+	m_maxDrawCount = instanceCount;
+
+	Constants constants = {};
+	for (u32 i = 0; i < 6; ++i)
+	{
+		const Plane& plane         = frustum.plane(FrustumPlane(i));
+		constants.frustumPlanes[i] = Vec4(plane.n.x, plane.n.y, plane.n.z, plane.d);
+	}
+	constants.instanceCount = instanceCount;
+
+	Gfx_UpdateBufferT(ctx, m_constantBuffer, constants);
+
+	const u32 zero = 0;
+	Gfx_UpdateBufferT(ctx, m_drawCount, zero);
+
+	if (instanceCount == 0)
+	{
+		return;
+	}
+
+	Gfx_SetTechnique(ctx, m_technique);
+	Gfx_SetConstantBuffer(ctx, 0, m_constantBuffer);
+	Gfx_SetStorageBuffer(ctx, 0, instances);
+	Gfx_SetStorageBuffer(ctx, 1, m_drawArgs);
+	Gfx_SetStorageBuffer(ctx, 2, m_drawCount);
+
+	Gfx_Dispatch(ctx, divUp(instanceCount, WorkGroupSize), 1, 1);
+
+	Gfx_AddBufferBarrier(ctx, m_drawArgs, GfxResourceState_General, GfxResourceState_ShaderRead);
+	Gfx_AddBufferBarrier(ctx, m_drawCount, GfxResourceState_General, GfxResourceState_ShaderRead);
+}
+
+void GfxGpuCulling::draw(GfxContext* ctx) const
+{
+	if (m_maxDrawCount == 0)
+	{
+		return;
+	}
+
+	Gfx_DrawIndexedIndirectCount(ctx, m_drawArgs, 0, m_drawCount, 0, m_maxDrawCount);
+}
+
+} // namespace Rush
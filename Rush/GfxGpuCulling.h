@@ -0,0 +1,66 @@
+#pragma once
+
+#include "GfxDevice.h"
+#include "MathTypes.h"
+
+namespace Rush
+{
+
+// Instance layout expected by the culling shader, see Shaders/GpuCulling.hlsl
+struct GfxGpuCullingInstance
+{
+	Vec3  boundsCenter; // world space bounding sphere
+	float boundsRadius;
+	u32   indexCount;
+	u32   firstIndex;
+	s32   vertexOffset;
+	u32   firstInstance; // passed through to the draw, typically used to look up per-instance data
+};
+
+// Reference GPU-driven culling path.
+// A compute pass tests each instance against the view frustum and writes compacted GfxDrawIndexedArg entries
+// and a draw count, which are then consumed by Gfx_DrawIndexedIndirectCount() without a CPU round trip.
+// The culling shader is not embedded: compile csCullInstances from Shaders/GpuCulling.hlsl
+// (e.g. glslc -x hlsl -fshader-stage=compute -fentry-point=csCullInstances) and pass it to the constructor.
+class GfxGpuCulling
+{
+public:
+	static constexpr u32 WorkGroupSize = 64;
+
+	GfxGpuCulling(const GfxShaderSource& cullingShader);
+	~GfxGpuCulling();
+
+	GfxGpuCulling(const GfxGpuCulling&) = delete;
+	GfxGpuCulling& operator=(const GfxGpuCulling&) = delete;
+
+	// Must be called outside of a render pass. Instance buffer must be a storage buffer of GfxGpuCullingInstance.
+	// Output buffers are transitioned for indirect argument reads.
+	void cull(GfxContext* ctx, GfxBufferArg instances, u32 instanceCount, const Frustum& frustum);
+
+	// Draws visible instances using the output of the last cull() call.
+	// Index buffer, technique and other draw state must be set by the caller.
+	void draw(GfxContext* ctx) const;
+
+	GfxBuffer getDrawArgs() const { return m_drawArgs.get(); }
+	GfxBuffer getDrawCount() const { return m_drawCount.get(); }
+	u32       getMaxDrawCount() const { return m_maxDrawCount; }
+
+private:
+	struct Constants
+	{
+		Vec4 frustumPlanes[6];
+		u32  instanceCount;
+		u32  padding[3];
+	};
+
+	GfxOwn<GfxComputeShader> m_computeShader;
+	GfxOwn<GfxTechnique>     m_technique;
+	GfxOwn<GfxBuffer>        m_constantBuffer;
+	GfxOwn<GfxBuffer>        m_drawArgs;
+	GfxOwn<GfxBuffer>        m_drawCount;
+
+	u32 m_drawArgsCapacity = 0;
+	u32 m_maxDrawCount     = 0;
+};
+
+} // namespace Rush
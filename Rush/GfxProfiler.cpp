@@ -0,0 +1,160 @@
+#include "GfxProfiler.h"
+#include "UtilFile.h"
+#include "UtilLog.h"
+#include "UtilTimer.h"
+
+#include <stdio.h>
+#include <string.h>
+
+namespace Rush
+{
+
+GfxProfiler::GfxProfiler(u32 maxCapturedZones) : m_maxCapturedZones(maxCapturedZones) {}
+
+GfxProfiler::~GfxProfiler() {}
+
+void GfxProfiler::beginFrame()
+{
+	RUSH_ASSERT(m_zoneStack.empty());
+
+	m_frameZones.clear();
+
+	if (m_captureFramesLeft == 0)
+	{
+		return;
+	}
+
+	for (const GfxGpuZone& it : Gfx_GetGpuZones())
+	{
+		Zone zone;
+		zone.name      = it.name;
+		zone.beginTime = it.beginTime;
+		zone.endTime   = it.endTime;
+		zone.depth     = it.depth;
+		zone.track     = Track_Gpu;
+		addCapturedZone(zone);
+	}
+}
+
+void GfxProfiler::endFrame()
+{
+	RUSH_ASSERT_MSG(m_zoneStack.empty(), "All profiler zones must be closed before the end of the frame");
+
+	std::swap(m_lastFrameZones, m_frameZones);
+
+	if (m_captureFramesLeft == 0)
+	{
+		return;
+	}
+
+	if (m_captureFramesLeft > GpuLatencyFrames)
+	{
+		for (const Zone& zone : m_lastFrameZones)
+		{
+			addCapturedZone(zone);
+		}
+	}
+
+	--m_captureFramesLeft;
+}
+
+void GfxProfiler::beginZone(const char* name, GfxContext* ctx)
+{
+	Zone zone;
+	zone.name      = name;
+	zone.depth     = u32(m_zoneStack.size());
+	zone.beginTime = Timer::global.time();
+	zone.track     = Track_Cpu;
+
+	m_zoneStack.push_back(u32(m_frameZones.size()));
+	m_frameZones.push_back(zone);
+
+	if (ctx)
+	{
+		Gfx_BeginGpuZone(ctx, name);
+	}
+}
+
+void GfxProfiler::endZone(GfxContext* ctx)
+{
+	RUSH_ASSERT_MSG(!m_zoneStack.empty(), "GfxProfiler::endZone called without matching beginZone");
+
+	if (ctx)
+	{
+		Gfx_EndGpuZone(ctx);
+	}
+
+	m_frameZones[m_zoneStack.back()].endTime = Timer::global.time();
+	m_zoneStack.pop_back();
+}
+
+void GfxProfiler::startCapture(u32 frameCount)
+{
+	m_capturedZones.clear();
+	m_captureFramesLeft = frameCount ? frameCount + GpuLatencyFrames : 0;
+}
+
+void GfxProfiler::addCapturedZone(const Zone& zone)
+{
+	if (m_capturedZones.size() < m_maxCapturedZones)
+	{
+		m_capturedZones.push_back(zone);
+	}
+}
+
+static void writeJsonString(FileOut& f, const char* str)
+{
+	f.writeT('"');
+	for (const char* c = str ? str : ""; *c; ++c)
+	{
+		if (*c == '"' || *c == '\\')
+		{
+			f.writeT('\\');
+		}
+		f.writeT(*c);
+	}
+	f.writeT('"');
+}
+
+bool GfxProfiler::exportChromeTrace(const char* filename) const
+{
+	FileOut f(filename);
+	if (!f.valid())
+	{
+		RUSH_LOG_ERROR("Failed to open '%s' for writing", filename);
+		return false;
+	}
+
+	static const char* trackNames[Track_COUNT] = {"CPU", "GPU"};
+
+	char buffer[256];
+
+	auto writeString = [&](const char* str) { f.write(str, strlen(str)); };
+
+	writeString("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+	for (u32 i = 0; i < Track_COUNT; ++i)
+	{
+		snprintf(buffer, sizeof(buffer),
+		    "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+		    i ? ",\n" : "", i, trackNames[i]);
+		writeString(buffer);
+	}
+
+	for (const Zone& zone : m_capturedZones)
+	{
+		writeString(",\n{\"name\":");
+		writeJsonString(f, zone.name);
+
+		// Trace event times are in microseconds
+		snprintf(buffer, sizeof(buffer), ",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+		    u32(zone.track), zone.beginTime * 1e6, (zone.endTime - zone.beginTime) * 1e6);
+		writeString(buffer);
+	}
+
+	writeString("\n]}\n");
+
+	return true;
+}
+
+} // namespace Rush
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "GfxDevice.h"
+#include "UtilArray.h"
+
+namespace Rush
+{
+
+// Hierarchical CPU and GPU zone profiler.
+// CPU zones are timed with Timer::global. GPU zones use Gfx_BeginGpuZone() and are delivered several frames later,
+// converted to the same time base, so CPU recording and GPU execution of the same work can be viewed side by side.
+class GfxProfiler
+{
+public:
+	enum Track : u8
+	{
+		Track_Cpu,
+		Track_Gpu,
+
+		Track_COUNT
+	};
+
+	struct Zone
+	{
+		const char* name      = nullptr;
+		double      beginTime = 0.0; // in seconds, same time base as Timer::global
+		double      endTime   = 0.0;
+		u32         depth     = 0;
+		Track       track     = Track_Cpu;
+	};
+
+	GfxProfiler(u32 maxCapturedZones = 1 << 20);
+	~GfxProfiler();
+
+	// Must be called after Gfx_BeginFrame(), which resolves GPU zones of retired frames
+	void beginFrame();
+	void endFrame();
+
+	// Zone names are not copied and must remain valid while profiling data is in use.
+	// If a context is given, a GPU zone with the same name is recorded along with the CPU zone.
+	void beginZone(const char* name, GfxContext* ctx = nullptr);
+	void endZone(GfxContext* ctx = nullptr);
+
+	// Records CPU zones of the next frameCount frames and GPU zones delivered while capture is active.
+	void startCapture(u32 frameCount);
+	bool isCapturing() const { return m_captureFramesLeft != 0; }
+
+	ArrayView<const Zone> getCapturedZones() const { return m_capturedZones; }
+	ArrayView<const Zone> getLastFrameZones() const { return m_lastFrameZones; }
+
+	// Writes captured zones as Chrome trace event JSON, viewable in chrome://tracing or Perfetto
+	bool exportChromeTrace(const char* filename) const;
+
+private:
+	// GPU zones are resolved after frames retire, so keep collecting for a few frames after CPU capture ends
+	static constexpr u32 GpuLatencyFrames = 4;
+
+	void addCapturedZone(const Zone& zone);
+
+	DynamicArray<Zone> m_frameZones;
+	DynamicArray<Zone> m_lastFrameZones;
+	DynamicArray<u32>  m_zoneStack;
+
+	DynamicArray<Zone> m_capturedZones;
+	u32                m_maxCapturedZones  = 0;
+	u32                m_captureFramesLeft = 0;
+};
+
+struct GfxProfilerScope
+{
+	GfxProfilerScope(GfxProfiler& profiler, const char* name, GfxContext* ctx = nullptr)
+	: m_profiler(profiler), m_ctx(ctx)
+	{
+		m_profiler.beginZone(name, m_ctx);
+	}
+	~GfxProfilerScope() { m_profiler.endZone(m_ctx); }
+
+	GfxProfiler& m_profiler;
+	GfxContext*  m_ctx;
+};
+
+} // namespace Rush
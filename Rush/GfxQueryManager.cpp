@@ -0,0 +1,160 @@
+#include "GfxQueryManager.h"
+#include "UtilLog.h"
+
+namespace Rush
+{
+
+GfxQueryManager::GfxQueryManager(GfxQuueryType type, u32 queriesPerFrame, u32 frameLatency,
+    GfxPipelineStatisticFlags pipelineStatistics)
+: m_type(type), m_pipelineStatistics(pipelineStatistics), m_queriesPerFrame(queriesPerFrame)
+{
+	RUSH_ASSERT(queriesPerFrame != 0);
+	RUSH_ASSERT(frameLatency != 0);
+
+	if (type == GfxQuueryType::PipelineStatistics)
+	{
+		m_valueCount = 0;
+		for (u32 bits = u32(pipelineStatistics); bits; bits &= bits - 1)
+		{
+			++m_valueCount;
+		}
+		RUSH_ASSERT_MSG(m_valueCount != 0, "Pipeline statistics query manager requires at least one statistic");
+	}
+
+	GfxQueryPoolDesc desc;
+	desc.type               = type;
+	desc.count              = queriesPerFrame;
+	desc.pipelineStatistics = pipelineStatistics;
+
+	m_slots.resize(frameLatency);
+	for (Slot& slot : m_slots)
+	{
+		slot.pool = Gfx_CreateQueryPool(desc);
+	}
+}
+
+GfxQueryManager::~GfxQueryManager() {}
+
+bool GfxQueryManager::pollSlot(Slot& slot)
+{
+	if (!slot.pending)
+	{
+		return true;
+	}
+
+	// Each query writes its values followed by the availability word
+	const u32 stride = (m_valueCount + 1) * sizeof(u64);
+	m_readback.resize(slot.issuedCount * (m_valueCount + 1));
+
+	Gfx_GetQueryResults(slot.pool.get(), 0, slot.issuedCount, m_readback.size() * sizeof(u64), m_readback.data(),
+	    stride, GfxQueryResultFlags::Value64Bit | GfxQueryResultFlags::WithAvailability);
+
+	for (u32 i = 0; i < slot.issuedCount; ++i)
+	{
+		if (m_readback[i * (m_valueCount + 1) + m_valueCount] == 0)
+		{
+			return false;
+		}
+	}
+
+	for (u32 i = 0; i < slot.issuedCount; ++i)
+	{
+		Result result;
+		result.frame = slot.frame;
+		result.index = i;
+		for (u32 j = 0; j < m_valueCount; ++j)
+		{
+			result.values[j] = m_readback[i * (m_valueCount + 1) + j];
+		}
+		m_results.push_back(result);
+	}
+
+	slot.pending     = false;
+	slot.issuedCount = 0;
+
+	return true;
+}
+
+void GfxQueryManager::beginFrame(GfxContext* ctx)
+{
+	if (m_currentSlot != InvalidIndex && m_slots[m_currentSlot].issuedCount)
+	{
+		m_slots[m_currentSlot].pending = true;
+	}
+
+	m_results.clear();
+
+	// Results of older frames are delivered first
+	const u32 slotCount = u32(m_slots.size());
+	for (u32 i = 1; i <= slotCount; ++i)
+	{
+		pollSlot(m_slots[(m_frameIndex + i) % slotCount]);
+	}
+
+	++m_frameIndex;
+
+	m_currentSlot = u32(m_frameIndex % slotCount);
+	Slot& slot    = m_slots[m_currentSlot];
+
+	// GPU is too far behind: drop this frame's queries rather than waiting for the results
+	m_frameDropped = slot.pending || !slot.pool.valid();
+	if (m_frameDropped)
+	{
+		return;
+	}
+
+	slot.frame       = m_frameIndex;
+	slot.issuedCount = 0;
+
+	Gfx_ResetQuery(ctx, slot.pool.get(), 0, m_queriesPerFrame);
+}
+
+u32 GfxQueryManager::allocateQuery()
+{
+	RUSH_ASSERT_MSG(m_currentSlot != InvalidIndex, "GfxQueryManager::beginFrame must be called before issuing queries");
+
+	Slot& slot = m_slots[m_currentSlot];
+	if (m_frameDropped || slot.issuedCount == m_queriesPerFrame)
+	{
+		++m_droppedQueryCount;
+		return InvalidIndex;
+	}
+
+	return slot.issuedCount++;
+}
+
+u32 GfxQueryManager::beginQuery(GfxContext* ctx, GfxQueryControlFlags flags)
+{
+	RUSH_ASSERT(m_type != GfxQuueryType::Timestamp);
+
+	u32 index = allocateQuery();
+	if (index != InvalidIndex)
+	{
+		Gfx_BeginQuery(ctx, m_slots[m_currentSlot].pool.get(), index, flags);
+	}
+
+	return index;
+}
+
+void GfxQueryManager::endQuery(GfxContext* ctx, u32 index)
+{
+	if (index != InvalidIndex)
+	{
+		Gfx_EndQuery(ctx, m_slots[m_currentSlot].pool.get(), index);
+	}
+}
+
+u32 GfxQueryManager::writeTimestamp(GfxContext* ctx)
+{
+	RUSH_ASSERT(m_type == GfxQuueryType::Timestamp);
+
+	u32 index = allocateQuery();
+	if (index != InvalidIndex)
+	{
+		Gfx_WriteTimestamp(ctx, m_slots[m_currentSlot].pool.get(), index);
+	}
+
+	return index;
+}
+
+} // namespace Rush
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "GfxDevice.h"
+#include "UtilArray.h"
+
+namespace Rush
+{
+
+// Ring of per-frame query pools that delivers results without stalling the CPU.
+// Each frame allocates queries from its own pool. Pools of previous frames are polled on beginFrame() and results
+// are delivered as soon as the GPU makes them available. If the pool for the current frame still has outstanding
+// results (GPU is further behind than frameLatency), queries of this frame are dropped instead of waiting.
+class GfxQueryManager
+{
+public:
+	static constexpr u32 InvalidIndex = ~0u;
+	static constexpr u32 MaxValues    = 11; // number of GfxPipelineStatisticFlags
+
+	struct Result
+	{
+		u64 frame = 0; // value of getFrameIndex() when the query was issued
+		u32 index = 0; // query index returned by beginQuery() or writeTimestamp()
+		u64 values[MaxValues] = {};
+	};
+
+	GfxQueryManager(GfxQuueryType type, u32 queriesPerFrame, u32 frameLatency = 3,
+	    GfxPipelineStatisticFlags pipelineStatistics = GfxPipelineStatisticFlags::None);
+	~GfxQueryManager();
+
+	GfxQueryManager(const GfxQueryManager&) = delete;
+	GfxQueryManager& operator=(const GfxQueryManager&) = delete;
+
+	// Collects available results of previous frames and resets the pool for the new frame.
+	// Must be called before any queries are issued in the frame, using a context that executes before them.
+	void beginFrame(GfxContext* ctx);
+
+	// Returns InvalidIndex if the query could not be allocated. Such queries are silently ignored by endQuery().
+	u32  beginQuery(GfxContext* ctx, GfxQueryControlFlags flags = GfxQueryControlFlags::None);
+	void endQuery(GfxContext* ctx, u32 index);
+
+	// Only valid for timestamp managers
+	u32 writeTimestamp(GfxContext* ctx);
+
+	// Results delivered by the last beginFrame(), possibly from several different frames
+	ArrayView<const Result> getResults() const { return m_results; }
+
+	u64 getFrameIndex() const { return m_frameIndex; }
+	u32 getValueCount() const { return m_valueCount; }
+	u32 getDroppedQueryCount() const { return m_droppedQueryCount; }
+
+private:
+	struct Slot
+	{
+		GfxOwn<GfxQueryPool> pool;
+		u64                  frame       = 0;
+		u32                  issuedCount = 0;
+		bool                 pending     = false;
+	};
+
+	bool pollSlot(Slot& slot);
+	u32  allocateQuery();
+
+	DynamicArray<Slot>   m_slots;
+	DynamicArray<Result> m_results;
+	DynamicArray<u64>    m_readback;
+
+	GfxQuueryType             m_type;
+	GfxPipelineStatisticFlags m_pipelineStatistics;
+	u32                       m_queriesPerFrame;
+	u32                       m_valueCount        = 1;
+	u32                       m_currentSlot       = InvalidIndex;
+	u32                       m_droppedQueryCount = 0;
+	u64                       m_frameIndex        = 0;
+	bool                      m_frameDropped      = false;
+};
+
+struct GfxQueryScope
+{
+	GfxQueryScope(GfxQueryManager& manager, GfxContext* ctx) : m_manager(manager), m_ctx(ctx)
+	{
+		m_index = m_manager.beginQuery(m_ctx);
+	}
+	~GfxQueryScope() { m_manager.endQuery(m_ctx, m_index); }
+
+	GfxQueryManager& m_manager;
+	GfxContext*      m_ctx;
+	u32              m_index;
+};
+
+} // namespace Rush
@@ -0,0 +1,729 @@
+#include "GfxRenderGraph.h"
+#include "UtilLog.h"
+
+namespace Rush
+{
+
+static bool isCompatible(const GfxTextureDesc& a, const GfxTextureDesc& b)
+{
+	return a.width == b.width && a.height == b.height && a.depth == b.depth && a.mips == b.mips &&
+	       a.samples == b.samples && a.format == b.format && a.type == b.type && a.usage == b.usage;
+}
+
+static bool isCompatible(const GfxBufferDesc& a, const GfxBufferDesc& b)
+{
+	return a.flags == b.flags && a.format == b.format && a.stride == b.stride && a.count == b.count &&
+	       a.hostVisible == b.hostVisible;
+}
+
+bool GfxRenderGraph::Pass::hasTargets() const
+{
+	if (depthTarget != InvalidIndex)
+	{
+		return true;
+	}
+
+	for (u32 target : colorTargets)
+	{
+		if (target != InvalidIndex)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+GfxRenderGraph::~GfxRenderGraph() {}
+
+void GfxRenderGraph::reset()
+{
+	m_passes.clear();
+	m_accesses.clear();
+	m_sortedAccesses.clear();
+	m_textures.clear();
+	m_buffers.clear();
+
+	m_culledPassCount = 0;
+	m_compiled        = false;
+
+	++m_frameIndex;
+
+	// Release physical resources that were not needed for a while.
+	// Actual destruction is deferred by the device until the GPU is done with them.
+
+	for (size_t i = 0; i < m_texturePool.size();)
+	{
+		if (m_texturePool[i].lastFrame + MaxUnusedFrames < m_frameIndex)
+		{
+			m_texturePool[i] = std::move(m_texturePool.back());
+			m_texturePool.pop_back();
+		}
+		else
+		{
+			++i;
+		}
+	}
+
+	for (size_t i = 0; i < m_bufferPool.size();)
+	{
+		if (m_bufferPool[i].lastFrame + MaxUnusedFrames < m_frameIndex)
+		{
+			m_bufferPool[i] = std::move(m_bufferPool.back());
+			m_bufferPool.pop_back();
+		}
+		else
+		{
+			++i;
+		}
+	}
+}
+
+GfxRenderGraphTexture GfxRenderGraph::createTexture(const GfxTextureDesc& desc)
+{
+	TextureResource resource;
+	resource.desc = desc;
+
+	GfxRenderGraphTexture result;
+	result.index = u32(m_textures.size());
+	m_textures.push_back(resource);
+
+	m_compiled = false;
+
+	return result;
+}
+
+GfxRenderGraphBuffer GfxRenderGraph::createBuffer(const GfxBufferDesc& desc)
+{
+	BufferResource resource;
+	resource.desc = desc;
+
+	GfxRenderGraphBuffer result;
+	result.index = u32(m_buffers.size());
+	m_buffers.push_back(resource);
+
+	m_compiled = false;
+
+	return result;
+}
+
+GfxRenderGraphTexture GfxRenderGraph::importTexture(GfxTextureArg texture, bool isOutput)
+{
+	RUSH_ASSERT(texture.valid());
+
+	TextureResource resource;
+	resource.desc     = Gfx_GetTextureDesc(texture);
+	resource.imported = texture;
+	resource.isOutput = isOutput;
+
+	GfxRenderGraphTexture result;
+	result.index = u32(m_textures.size());
+	m_textures.push_back(resource);
+
+	m_compiled = false;
+
+	return result;
+}
+
+GfxRenderGraphBuffer GfxRenderGraph::importBuffer(GfxBufferArg buffer, bool isOutput)
+{
+	RUSH_ASSERT(buffer.valid());
+
+	BufferResource resource;
+	resource.imported = buffer;
+	resource.isOutput = isOutput;
+
+	GfxRenderGraphBuffer result;
+	result.index = u32(m_buffers.size());
+	m_buffers.push_back(resource);
+
+	m_compiled = false;
+
+	return result;
+}
+
+GfxRenderGraphPass GfxRenderGraph::addPass(
+    const char* name, GfxRenderGraphCallback callback, void* userData, GfxRenderGraphPassFlags flags)
+{
+	Pass pass;
+	pass.name     = name;
+	pass.callback = callback;
+	pass.userData = userData;
+	pass.flags    = flags;
+
+	for (u32& target : pass.colorTargets)
+	{
+		target = InvalidIndex;
+	}
+
+	GfxRenderGraphPass result;
+	result.index = u32(m_passes.size());
+	m_passes.push_back(pass);
+
+	m_compiled = false;
+
+	return result;
+}
+
+void GfxRenderGraph::addAccess(GfxRenderGraphPass pass, u32 resource, GfxResourceState state, u8 flags)
+{
+	RUSH_ASSERT(pass.index < m_passes.size());
+
+	Access access;
+	access.pass     = pass.index;
+	access.resource = resource;
+	access.state    = state;
+	access.flags    = flags;
+
+	m_accesses.push_back(access);
+
+	m_compiled = false;
+}
+
+void GfxRenderGraph::setColorTarget(GfxRenderGraphPass pass, u32 index, GfxRenderGraphTexture texture)
+{
+	RUSH_ASSERT(pass.index < m_passes.size());
+	RUSH_ASSERT(index < GfxPassDesc::MaxTargets);
+	RUSH_ASSERT(texture.index < m_textures.size());
+
+	m_passes[pass.index].colorTargets[index] = texture.index;
+
+	const bool isCleared = !!(m_passes[pass.index].passFlags & GfxPassFlags::ClearColor);
+	addAccess(pass, texture.index, GfxResourceState_RenderTarget,
+	    u8(AccessFlag_Write | (isCleared ? AccessFlag_Discard : 0)));
+}
+
+void GfxRenderGraph::setDepthTarget(GfxRenderGraphPass pass, GfxRenderGraphTexture texture)
+{
+	RUSH_ASSERT(pass.index < m_passes.size());
+	RUSH_ASSERT(texture.index < m_textures.size());
+
+	m_passes[pass.index].depthTarget = texture.index;
+
+	const bool isCleared = !!(m_passes[pass.index].passFlags & GfxPassFlags::ClearDepthStencil);
+	addAccess(pass, texture.index, GfxResourceState_DepthStencilTarget,
+	    u8(AccessFlag_Write | (isCleared ? AccessFlag_Discard : 0)));
+}
+
+void GfxRenderGraph::setClear(
+    GfxRenderGraphPass pass, GfxPassFlags flags, const ColorRGBA& color, float depth, u8 stencil)
+{
+	RUSH_ASSERT(pass.index < m_passes.size());
+
+	Pass& p        = m_passes[pass.index];
+	p.passFlags    = flags;
+	p.clearColor   = color;
+	p.clearDepth   = depth;
+	p.clearStencil = stencil;
+
+	// Targets may be declared before the clear
+	for (Access& access : m_accesses)
+	{
+		if (access.pass != pass.index || (access.flags & AccessFlag_Buffer))
+		{
+			continue;
+		}
+
+		bool isCleared = false;
+		if (access.state == GfxResourceState_RenderTarget)
+		{
+			isCleared = !!(flags & GfxPassFlags::ClearColor);
+		}
+		else if (access.state == GfxResourceState_DepthStencilTarget)
+		{
+			isCleared = !!(flags & GfxPassFlags::ClearDepthStencil);
+		}
+
+		if (isCleared)
+		{
+			access.flags |= AccessFlag_Discard;
+		}
+		else
+		{
+			access.flags &= u8(~AccessFlag_Discard);
+		}
+	}
+
+	m_compiled = false;
+}
+
+void GfxRenderGraph::readTexture(GfxRenderGraphPass pass, GfxRenderGraphTexture texture, GfxResourceState state)
+{
+	RUSH_ASSERT(texture.index < m_textures.size());
+	addAccess(pass, texture.index, state, 0);
+}
+
+void GfxRenderGraph::writeTexture(GfxRenderGraphPass pass, GfxRenderGraphTexture texture, GfxResourceState state)
+{
+	RUSH_ASSERT(texture.index < m_textures.size());
+	addAccess(pass, texture.index, state, AccessFlag_Write);
+}
+
+void GfxRenderGraph::readBuffer(GfxRenderGraphPass pass, GfxRenderGraphBuffer buffer, GfxResourceState state)
+{
+	RUSH_ASSERT(buffer.index < m_buffers.size());
+	addAccess(pass, buffer.index, state, AccessFlag_Buffer);
+}
+
+void GfxRenderGraph::writeBuffer(GfxRenderGraphPass pass, GfxRenderGraphBuffer buffer, GfxResourceState state)
+{
+	RUSH_ASSERT(buffer.index < m_buffers.size());
+	addAccess(pass, buffer.index, state, AccessFlag_Buffer | AccessFlag_Write);
+}
+
+void GfxRenderGraph::compile()
+{
+	// Group accesses by pass, preserving declaration order
+
+	for (Pass& pass : m_passes)
+	{
+		pass.accessCount = 0;
+	}
+
+	for (const Access& access : m_accesses)
+	{
+		m_passes[access.pass].accessCount++;
+	}
+
+	u32 accessOffset = 0;
+	for (Pass& pass : m_passes)
+	{
+		pass.accessOffset = accessOffset;
+		accessOffset += pass.accessCount;
+		pass.accessCount = 0;
+	}
+
+	m_sortedAccesses.resize(m_accesses.size());
+	for (const Access& access : m_accesses)
+	{
+		Pass& pass = m_passes[access.pass];
+		m_sortedAccesses[pass.accessOffset + pass.accessCount++] = access;
+	}
+
+	cullPasses();
+	computeLifetimes();
+	assignPhysicalResources();
+
+	m_compiled = true;
+}
+
+void GfxRenderGraph::cullPasses()
+{
+	// Walk passes backwards, tracking which resources still have a pending consumer.
+	// A pass is kept if it writes a resource that is consumed later or has explicit side effects.
+
+	DynamicArray<bool> textureNeeded(m_textures.size(), false);
+	DynamicArray<bool> bufferNeeded(m_buffers.size(), false);
+
+	for (size_t i = 0; i < m_textures.size(); ++i)
+	{
+		textureNeeded[i] = m_textures[i].isOutput;
+	}
+
+	for (size_t i = 0; i < m_buffers.size(); ++i)
+	{
+		bufferNeeded[i] = m_buffers[i].isOutput;
+	}
+
+	m_culledPassCount = 0;
+
+	for (size_t passIndex = m_passes.size(); passIndex-- > 0;)
+	{
+		Pass& pass = m_passes[passIndex];
+
+		const Access* accesses = m_sortedAccesses.data() + pass.accessOffset;
+
+		pass.alive = !!(pass.flags & GfxRenderGraphPassFlags::NeverCull);
+
+		for (u32 i = 0; i < pass.accessCount && !pass.alive; ++i)
+		{
+			const Access& access = accesses[i];
+			if (access.flags & AccessFlag_Write)
+			{
+				bool& needed = (access.flags & AccessFlag_Buffer) ? bufferNeeded[access.resource]
+				                                                  : textureNeeded[access.resource];
+				pass.alive   = needed;
+			}
+		}
+
+		if (!pass.alive)
+		{
+			++m_culledPassCount;
+			continue;
+		}
+
+		// Fully overwritten resources do not need earlier producers
+		for (u32 i = 0; i < pass.accessCount; ++i)
+		{
+			const Access& access = accesses[i];
+			if (access.flags & AccessFlag_Discard)
+			{
+				bool& needed = (access.flags & AccessFlag_Buffer) ? bufferNeeded[access.resource]
+				                                                  : textureNeeded[access.resource];
+				needed       = false;
+			}
+		}
+
+		// Reads and partial writes depend on earlier contents
+		for (u32 i = 0; i < pass.accessCount; ++i)
+		{
+			const Access& access = accesses[i];
+			if (!(access.flags & AccessFlag_Discard))
+			{
+				bool& needed = (access.flags & AccessFlag_Buffer) ? bufferNeeded[access.resource]
+				                                                  : textureNeeded[access.resource];
+				needed       = true;
+			}
+		}
+	}
+}
+
+void GfxRenderGraph::computeLifetimes()
+{
+	for (TextureResource& resource : m_textures)
+	{
+		resource.firstPass = InvalidIndex;
+		resource.lastPass  = InvalidIndex;
+	}
+
+	for (BufferResource& resource : m_buffers)
+	{
+		resource.firstPass = InvalidIndex;
+		resource.lastPass  = InvalidIndex;
+	}
+
+	for (u32 passIndex = 0; passIndex < m_passes.size(); ++passIndex)
+	{
+		const Pass& pass = m_passes[passIndex];
+		if (!pass.alive)
+		{
+			continue;
+		}
+
+		for (u32 i = 0; i < pass.accessCount; ++i)
+		{
+			const Access& access = m_sortedAccesses[pass.accessOffset + i];
+
+			u32& firstPass = (access.flags & AccessFlag_Buffer) ? m_buffers[access.resource].firstPass
+			                                                    : m_textures[access.resource].firstPass;
+			u32& lastPass  = (access.flags & AccessFlag_Buffer) ? m_buffers[access.resource].lastPass
+			                                                    : m_textures[access.resource].lastPass;
+
+			if (firstPass == InvalidIndex)
+			{
+				firstPass = passIndex;
+			}
+
+			lastPass = passIndex;
+		}
+	}
+}
+
+void GfxRenderGraph::assignPhysicalResources()
+{
+	for (PhysicalTexture& it : m_texturePool)
+	{
+		if (it.lastFrame == m_frameIndex)
+		{
+			it.lastPass = InvalidIndex;
+		}
+	}
+
+	for (PhysicalBuffer& it : m_bufferPool)
+	{
+		if (it.lastFrame == m_frameIndex)
+		{
+			it.lastPass = InvalidIndex;
+		}
+	}
+
+	for (TextureResource& resource : m_textures)
+	{
+		resource.physical = InvalidIndex;
+	}
+
+	for (BufferResource& resource : m_buffers)
+	{
+		resource.physical = InvalidIndex;
+	}
+
+	// Visit resources in order of first use, so that a physical resource can be handed over
+	// as soon as the lifetime of its previous owner ends
+
+	for (const Pass& pass : m_passes)
+	{
+		if (!pass.alive)
+		{
+			continue;
+		}
+
+		for (u32 i = 0; i < pass.accessCount; ++i)
+		{
+			const Access& access = m_sortedAccesses[pass.accessOffset + i];
+			if (access.flags & AccessFlag_Buffer)
+			{
+				BufferResource& resource = m_buffers[access.resource];
+				if (!resource.imported.valid() && resource.physical == InvalidIndex)
+				{
+					resource.physical = allocatePhysicalBuffer(resource);
+				}
+			}
+			else
+			{
+				TextureResource& resource = m_textures[access.resource];
+				if (!resource.imported.valid() && resource.physical == InvalidIndex)
+				{
+					resource.physical = allocatePhysicalTexture(resource);
+				}
+			}
+		}
+	}
+}
+
+u32 GfxRenderGraph::allocatePhysicalTexture(const TextureResource& resource)
+{
+	u32 result = InvalidIndex;
+
+	for (u32 i = 0; i < m_texturePool.size(); ++i)
+	{
+		const PhysicalTexture& it = m_texturePool[i];
+
+		const bool isFree =
+		    it.lastFrame != m_frameIndex || it.lastPass == InvalidIndex || it.lastPass < resource.firstPass;
+
+		if (isFree && isCompatible(it.desc, resource.desc))
+		{
+			result = i;
+			break;
+		}
+	}
+
+	if (result == InvalidIndex)
+	{
+		PhysicalTexture physical;
+		physical.desc    = resource.desc;
+		physical.texture = Gfx_CreateTexture(resource.desc);
+
+		result = u32(m_texturePool.size());
+		m_texturePool.push_back(std::move(physical));
+	}
+
+	PhysicalTexture& physical = m_texturePool[result];
+	physical.lastFrame        = m_frameIndex;
+	physical.lastPass         = resource.lastPass;
+
+	return result;
+}
+
+u32 GfxRenderGraph::allocatePhysicalBuffer(const BufferResource& resource)
+{
+	u32 result = InvalidIndex;
+
+	for (u32 i = 0; i < m_bufferPool.size(); ++i)
+	{
+		const PhysicalBuffer& it = m_bufferPool[i];
+
+		const bool isFree =
+		    it.lastFrame != m_frameIndex || it.lastPass == InvalidIndex || it.lastPass < resource.firstPass;
+
+		if (isFree && isCompatible(it.desc, resource.desc))
+		{
+			result = i;
+			break;
+		}
+	}
+
+	if (result == InvalidIndex)
+	{
+		PhysicalBuffer physical;
+		physical.desc   = resource.desc;
+		physical.buffer = Gfx_CreateBuffer(resource.desc);
+
+		result = u32(m_bufferPool.size());
+		m_bufferPool.push_back(std::move(physical));
+	}
+
+	PhysicalBuffer& physical = m_bufferPool[result];
+	physical.lastFrame       = m_frameIndex;
+	physical.lastPass        = resource.lastPass;
+
+	return result;
+}
+
+GfxTexture GfxRenderGraph::getTexture(GfxRenderGraphTexture texture) const
+{
+	RUSH_ASSERT(texture.index < m_textures.size());
+
+	const TextureResource& resource = m_textures[texture.index];
+	if (resource.imported.valid())
+	{
+		return resource.imported;
+	}
+	else if (resource.physical != InvalidIndex)
+	{
+		return m_texturePool[resource.physical].texture.get();
+	}
+	else
+	{
+		return InvalidResourceHandle();
+	}
+}
+
+GfxBuffer GfxRenderGraph::getBuffer(GfxRenderGraphBuffer buffer) const
+{
+	RUSH_ASSERT(buffer.index < m_buffers.size());
+
+	const BufferResource& resource = m_buffers[buffer.index];
+	if (resource.imported.valid())
+	{
+		return resource.imported;
+	}
+	else if (resource.physical != InvalidIndex)
+	{
+		return m_bufferPool[resource.physical].buffer.get();
+	}
+	else
+	{
+		return InvalidResourceHandle();
+	}
+}
+
+GfxRenderGraph::BufferState& GfxRenderGraph::getBufferState(u32 index)
+{
+	BufferResource& resource = m_buffers[index];
+	if (resource.imported.valid())
+	{
+		return resource.importedState;
+	}
+	else
+	{
+		// Tracked on the physical buffer, so that hazards between aliased resources are covered
+		return m_bufferPool[resource.physical].state;
+	}
+}
+
+static_assert(GfxResourceState_SharedPresent < 16, "Buffer read states must fit into BufferState::readStates");
+
+void GfxRenderGraph::addBarriers(GfxContext* ctx, const Pass& pass)
+{
+	for (u32 i = 0; i < pass.accessCount; ++i)
+	{
+		const Access& access = m_sortedAccesses[pass.accessOffset + i];
+
+		if (access.flags & AccessFlag_Buffer)
+		{
+			BufferState& state   = getBufferState(access.resource);
+			const bool   isWrite = !!(access.flags & AccessFlag_Write);
+			const u16    readBit = u16(1u << access.state);
+
+			GfxBufferArg buffer = getBuffer(GfxRenderGraphBuffer{access.resource});
+
+			if (isWrite)
+			{
+				if (state.readStates)
+				{
+					// Write-after-read must wait for every kind of read since the last write
+					for (u32 readState = 0; readState < 16; ++readState)
+					{
+						if (state.readStates & (1u << readState))
+						{
+							Gfx_AddBufferBarrier(ctx, buffer, GfxResourceState(readState), access.state);
+						}
+					}
+				}
+				else if (state.writeState != GfxResourceState_Undefined)
+				{
+					Gfx_AddBufferBarrier(ctx, buffer, state.writeState, access.state);
+				}
+
+				state.writeState = access.state;
+				state.readStates = 0;
+			}
+			else if (!(state.readStates & readBit))
+			{
+				// Previous write must be made visible to each new kind of read, read-after-read in the same state
+				// needs no synchronization
+				if (state.writeState != GfxResourceState_Undefined)
+				{
+					Gfx_AddBufferBarrier(ctx, buffer, state.writeState, access.state);
+				}
+
+				state.readStates |= readBit;
+			}
+		}
+		else
+		{
+			// Device tracks per-subresource texture state and drops redundant transitions
+			GfxTextureArg texture = getTexture(GfxRenderGraphTexture{access.resource});
+			Gfx_AddImageBarrier(ctx, texture, access.state);
+		}
+	}
+
+	Gfx_FlushBarriers(ctx);
+}
+
+void GfxRenderGraph::execute(GfxContext* ctx)
+{
+	if (!m_compiled)
+	{
+		compile();
+	}
+
+	for (const Pass& pass : m_passes)
+	{
+		if (!pass.alive)
+		{
+			continue;
+		}
+
+		if (pass.name)
+		{
+			Gfx_PushMarker(ctx, pass.name);
+		}
+
+		addBarriers(ctx, pass);
+
+		const bool hasTargets = pass.hasTargets();
+
+		if (hasTargets)
+		{
+			GfxPassDesc passDesc;
+			for (u32 i = 0; i < GfxPassDesc::MaxTargets; ++i)
+			{
+				if (pass.colorTargets[i] != InvalidIndex)
+				{
+					passDesc.color[i] = getTexture(GfxRenderGraphTexture{pass.colorTargets[i]});
+				}
+				passDesc.clearColors[i] = pass.clearColor;
+			}
+
+			if (pass.depthTarget != InvalidIndex)
+			{
+				passDesc.depth = getTexture(GfxRenderGraphTexture{pass.depthTarget});
+			}
+
+			passDesc.flags        = pass.passFlags;
+			passDesc.clearDepth   = pass.clearDepth;
+			passDesc.clearStencil = pass.clearStencil;
+
+			Gfx_BeginPass(ctx, passDesc);
+		}
+
+		if (pass.callback)
+		{
+			pass.callback(ctx, *this, pass.userData);
+		}
+
+		if (hasTargets)
+		{
+			Gfx_EndPass(ctx);
+		}
+
+		if (pass.name)
+		{
+			Gfx_PopMarker(ctx);
+		}
+	}
+}
+
+} // namespace Rush
@@ -0,0 +1,203 @@
+#pragma once
+
+#include "GfxDevice.h"
+#include "UtilArray.h"
+
+namespace Rush
+{
+
+class GfxRenderGraph;
+
+struct GfxRenderGraphTexture
+{
+	u32  index = ~0u;
+	bool valid() const { return index != ~0u; }
+};
+
+struct GfxRenderGraphBuffer
+{
+	u32  index = ~0u;
+	bool valid() const { return index != ~0u; }
+};
+
+struct GfxRenderGraphPass
+{
+	u32  index = ~0u;
+	bool valid() const { return index != ~0u; }
+};
+
+using GfxRenderGraphCallback = void (*)(GfxContext* ctx, const GfxRenderGraph& graph, void* userData);
+
+enum class GfxRenderGraphPassFlags : u8
+{
+	None = 0,
+
+	NeverCull = 1 << 0, // pass has side effects that are not declared through resource writes
+};
+RUSH_IMPLEMENT_FLAG_OPERATORS(GfxRenderGraphPassFlags, u8)
+
+// Frame graph built on top of the GfxDevice API.
+// Passes declare which resources they read and write. On execute, passes that do not contribute to any output
+// are culled, barriers are derived from declared accesses and transient resources with disjoint lifetimes
+// share the same physical texture or buffer.
+// Typical use: reset(), declare resources and passes, execute(). Handles are only valid until the next reset().
+class GfxRenderGraph
+{
+public:
+	GfxRenderGraph() = default;
+	~GfxRenderGraph();
+
+	GfxRenderGraph(const GfxRenderGraph&) = delete;
+	GfxRenderGraph& operator=(const GfxRenderGraph&) = delete;
+
+	// Removes all passes and resources of the previous frame. Physical transient resources are kept for reuse.
+	void reset();
+
+	GfxRenderGraphTexture createTexture(const GfxTextureDesc& desc);
+	GfxRenderGraphBuffer  createBuffer(const GfxBufferDesc& desc);
+
+	// Imported resources are owned by the caller. Writes to imported outputs are never culled.
+	GfxRenderGraphTexture importTexture(GfxTextureArg texture, bool isOutput = true);
+	GfxRenderGraphBuffer  importBuffer(GfxBufferArg buffer, bool isOutput = true);
+
+	GfxRenderGraphPass addPass(const char* name, GfxRenderGraphCallback callback, void* userData = nullptr,
+	    GfxRenderGraphPassFlags flags = GfxRenderGraphPassFlags::None);
+
+	// Passes with render targets are wrapped in Gfx_BeginPass() / Gfx_EndPass()
+	void setColorTarget(GfxRenderGraphPass pass, u32 index, GfxRenderGraphTexture texture);
+	void setDepthTarget(GfxRenderGraphPass pass, GfxRenderGraphTexture texture);
+	void setClear(GfxRenderGraphPass pass, GfxPassFlags flags, const ColorRGBA& color = ColorRGBA::Black(),
+	    float depth = 1.0f, u8 stencil = 0);
+
+	void readTexture(
+	    GfxRenderGraphPass pass, GfxRenderGraphTexture texture, GfxResourceState state = GfxResourceState_ShaderRead);
+	void writeTexture(
+	    GfxRenderGraphPass pass, GfxRenderGraphTexture texture, GfxResourceState state = GfxResourceState_General);
+	void readBuffer(
+	    GfxRenderGraphPass pass, GfxRenderGraphBuffer buffer, GfxResourceState state = GfxResourceState_ShaderRead);
+	void writeBuffer(
+	    GfxRenderGraphPass pass, GfxRenderGraphBuffer buffer, GfxResourceState state = GfxResourceState_General);
+
+	// Culls passes, computes resource lifetimes and assigns physical resources.
+	// Called automatically by execute() if the graph changed.
+	void compile();
+	void execute(GfxContext* ctx);
+
+	// Physical resources are assigned by compile() and are valid inside pass callbacks
+	GfxTexture getTexture(GfxRenderGraphTexture texture) const;
+	GfxBuffer  getBuffer(GfxRenderGraphBuffer buffer) const;
+
+	u32 getPassCount() const { return u32(m_passes.size()); }
+	u32 getCulledPassCount() const { return m_culledPassCount; }
+	u32 getPhysicalTextureCount() const { return u32(m_texturePool.size()); }
+	u32 getPhysicalBufferCount() const { return u32(m_bufferPool.size()); }
+
+private:
+	static constexpr u32 InvalidIndex    = ~0u;
+	static constexpr u32 MaxUnusedFrames = 3;
+
+	enum AccessFlags : u8
+	{
+		AccessFlag_Buffer  = 1 << 0,
+		AccessFlag_Write   = 1 << 1,
+		AccessFlag_Discard = 1 << 2, // previous contents are not needed by this access
+	};
+
+	struct Access
+	{
+		u32              pass     = InvalidIndex;
+		u32              resource = InvalidIndex;
+		GfxResourceState state    = GfxResourceState_Undefined;
+		u8               flags    = 0;
+	};
+
+	struct Pass
+	{
+		const char*             name     = nullptr;
+		GfxRenderGraphCallback  callback = nullptr;
+		void*                   userData = nullptr;
+		GfxRenderGraphPassFlags flags    = GfxRenderGraphPassFlags::None;
+
+		u32          colorTargets[GfxPassDesc::MaxTargets];
+		u32          depthTarget  = InvalidIndex;
+		GfxPassFlags passFlags    = GfxPassFlags::None;
+		ColorRGBA    clearColor   = ColorRGBA::Black();
+		float        clearDepth   = 1.0f;
+		u8           clearStencil = 0;
+
+		u32  accessOffset = 0;
+		u32  accessCount  = 0;
+		bool alive        = false;
+
+		bool hasTargets() const;
+	};
+
+	struct BufferState
+	{
+		GfxResourceState writeState = GfxResourceState_Undefined; // state of the last write, undefined if none
+		u16              readStates = 0; // bit per GfxResourceState read since the last write
+	};
+
+	struct TextureResource
+	{
+		GfxTextureDesc desc;
+		GfxTexture     imported;
+		u32            physical  = InvalidIndex;
+		u32            firstPass = InvalidIndex;
+		u32            lastPass  = InvalidIndex;
+		bool           isOutput  = false;
+	};
+
+	struct BufferResource
+	{
+		GfxBufferDesc desc;
+		GfxBuffer     imported;
+		BufferState   importedState;
+		u32           physical  = InvalidIndex;
+		u32           firstPass = InvalidIndex;
+		u32           lastPass  = InvalidIndex;
+		bool          isOutput  = false;
+	};
+
+	struct PhysicalTexture
+	{
+		GfxTextureDesc      desc;
+		GfxOwn<GfxTexture>  texture;
+		u64                 lastFrame = 0;
+		u32                 lastPass  = InvalidIndex;
+	};
+
+	struct PhysicalBuffer
+	{
+		GfxBufferDesc     desc;
+		GfxOwn<GfxBuffer> buffer;
+		BufferState       state;
+		u64               lastFrame = 0;
+		u32               lastPass  = InvalidIndex;
+	};
+
+	void addAccess(GfxRenderGraphPass pass, u32 resource, GfxResourceState state, u8 flags);
+	void cullPasses();
+	void computeLifetimes();
+	void assignPhysicalResources();
+	u32  allocatePhysicalTexture(const TextureResource& resource);
+	u32  allocatePhysicalBuffer(const BufferResource& resource);
+
+	BufferState& getBufferState(u32 index);
+	void         addBarriers(GfxContext* ctx, const Pass& pass);
+
+	DynamicArray<Pass>            m_passes;
+	DynamicArray<Access>          m_accesses;
+	DynamicArray<Access>          m_sortedAccesses;
+	DynamicArray<TextureResource> m_textures;
+	DynamicArray<BufferResource>  m_buffers;
+
+	DynamicArray<PhysicalTexture> m_texturePool;
+	DynamicArray<PhysicalBuffer>  m_bufferPool;
+
+	u64  m_frameIndex      = 1;
+	u32  m_culledPassCount = 0;
+	bool m_compiled        = false;
+};
+
+} // namespace Rush
@@ -1,8 +1,16 @@
 #include "Platform.h"
 #include "GfxDevice.h"
+#include "UtilJobs.h"
 #include "UtilLog.h"
 #include "Window.h"
 
+#if defined(RUSH_PLATFORM_MAC) || (defined(RUSH_PLATFORM_LINUX) && defined(__GLIBC__))
+#include <execinfo.h>
+#define RUSH_HAS_BACKTRACE 1
+#else
+#define RUSH_HAS_BACKTRACE 0
+#endif
+
 namespace Rush
 {
 
@@ -16,6 +24,8 @@ void Platform_Startup(const AppConfig& cfg)
 	RUSH_ASSERT(g_mainGfxDevice == nullptr);
 	RUSH_ASSERT(g_mainGfxContext == nullptr);
 
+	Jobs_Startup(cfg.workerThreads < 0 ? Jobs_GetDefaultWorkerThreadCount() : u32(cfg.workerThreads));
+
 	WindowDesc windowDesc;
 	windowDesc.width      = cfg.width;
 	windowDesc.height     = cfg.height;
@@ -51,6 +61,8 @@ void Platform_Shutdown()
 	Gfx_Release(g_mainGfxDevice);
 
 	g_mainWindow->release();
+
+	Jobs_Shutdown();
 }
 
 int Platform_Main(const AppConfig& cfg)
@@ -79,6 +91,29 @@ bool Platform_IsDebuggerPresent()
 {
 	return false;
 }
+
+u32 Platform_CaptureCallStack(void** frames, u32 maxFrames, u32 skipFrames)
+{
+#if RUSH_HAS_BACKTRACE
+	static constexpr u32 MaxCapturedFrames = 64;
+
+	void* capturedFrames[MaxCapturedFrames];
+	const u32 capturedCount = u32(backtrace(capturedFrames, int(MaxCapturedFrames)));
+
+	const u32 firstFrame = skipFrames + 1; // skip this function
+	u32       frameCount = 0;
+	for (u32 i = firstFrame; i < capturedCount && frameCount < maxFrames; ++i)
+	{
+		frames[frameCount++] = capturedFrames[i];
+	}
+	return frameCount;
+#else  // RUSH_HAS_BACKTRACE
+	(void)frames;
+	(void)maxFrames;
+	(void)skipFrames;
+	return 0;
+#endif // RUSH_HAS_BACKTRACE
+}
 #endif // RUSH_PLATFORM_WINDOWS
 
 }
@@ -39,6 +39,8 @@ struct AppConfig
 	int    argc = 0;
 	char** argv = nullptr;
 
+	int workerThreads = -1; // job system worker thread count, -1 to use Jobs_GetDefaultWorkerThreadCount()
+
 	const GfxConfig* gfxConfig = nullptr;
 
 	void* userData = nullptr;
@@ -89,4 +91,8 @@ Window*     Platform_CreateWindow(const WindowDesc& desc);
 
 bool Platform_IsDebuggerPresent();
 
+// Writes up to maxFrames return addresses of the calling thread, excluding the skipFrames innermost callers
+// of this function. Returns the number of frames written, which is 0 if stack capture is not supported.
+u32 Platform_CaptureCallStack(void** frames, u32 maxFrames, u32 skipFrames = 0);
+
 }
@@ -79,6 +79,11 @@ bool Platform_IsDebuggerPresent()
 	return IsDebuggerPresent();
 }
 
+u32 Platform_CaptureCallStack(void** frames, u32 maxFrames, u32 skipFrames)
+{
+	return CaptureStackBackTrace(skipFrames + 1, maxFrames, frames, nullptr);
+}
+
 }
 
 #endif
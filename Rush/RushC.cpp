@@ -479,6 +479,12 @@ void rush_gfx_draw_indexed_indirect(struct rush_gfx_context* ctx, rush_gfx_buffe
 	Gfx_DrawIndexedIndirect(convert(ctx), convertHandle<GfxBuffer>(args_buffer), args_buffer_offset, draw_count);
 }
 
+void rush_gfx_draw_indexed_indirect_count(struct rush_gfx_context* ctx, rush_gfx_buffer args_buffer, uint32_t args_buffer_offset, rush_gfx_buffer count_buffer, uint32_t count_buffer_offset, uint32_t max_draw_count)
+{
+	Gfx_DrawIndexedIndirectCount(convert(ctx), convertHandle<GfxBuffer>(args_buffer), args_buffer_offset,
+	    convertHandle<GfxBuffer>(count_buffer), count_buffer_offset, max_draw_count);
+}
+
 void rush_gfx_dispatch_indirect(struct rush_gfx_context* ctx, rush_gfx_buffer args_buffer, uint32_t args_buffer_offset, const void* push_constants, uint32_t push_constants_size)
 {
 	Gfx_DispatchIndirect(convert(ctx), convertHandle<GfxBuffer>(args_buffer), args_buffer_offset);
@@ -512,7 +518,7 @@ rush_gfx_buffer rush_gfx_create_buffer(const rush_gfx_buffer_desc* in_desc, cons
 	desc.stride      = in_desc->stride;
 	desc.count       = in_desc->count;
 	desc.hostVisible = in_desc->host_visible;
-	return {Gfx_CreateBuffer(desc, data).detach().index()};
+	return {Gfx_CreateBuffer(desc, data).detach().value()};
 }
 
 rush_gfx_texture rush_gfx_create_texture(const rush_gfx_texture_desc* in_desc, const rush_gfx_texture_data* in_data, uint32_t count, const void* pixels)
@@ -546,7 +552,7 @@ rush_gfx_texture rush_gfx_create_texture(const rush_gfx_texture_desc* in_desc, c
 		data[i].depth  = in_data[i].depth;
 	}
 
-	return {Gfx_CreateTexture(desc, data, count, pixels).detach().index()};
+	return {Gfx_CreateTexture(desc, data, count, pixels).detach().value()};
 }
 
 rush_gfx_blend_state rush_gfx_create_blend_state(const rush_gfx_blend_state_desc* in_desc)
@@ -562,7 +568,7 @@ rush_gfx_blend_state rush_gfx_create_blend_state(const rush_gfx_blend_state_desc
 	desc.alphaSeparate = in_desc->alpha_separate;
 	desc.enable        = in_desc->enable;
 
-	return { Gfx_CreateBlendState(desc).detach().index() };
+	return { Gfx_CreateBlendState(desc).detach().value() };
 }
 
 rush_gfx_sampler rush_gfx_create_sampler_state(const rush_gfx_sampler_desc* in_desc)
@@ -580,7 +586,7 @@ rush_gfx_sampler rush_gfx_create_sampler_state(const rush_gfx_sampler_desc* in_d
 	desc.anisotropy    = in_desc->anisotropy;
 	desc.mipLodBias    = in_desc->mip_lod_bias;
 
-	return { Gfx_CreateSamplerState(desc).detach().index() };
+	return { Gfx_CreateSamplerState(desc).detach().value() };
 }
 
 rush_gfx_depth_stencil_state rush_gfx_create_depth_stencil_state(const rush_gfx_depth_stencil_desc* in_desc)
@@ -591,7 +597,7 @@ rush_gfx_depth_stencil_state rush_gfx_create_depth_stencil_state(const rush_gfx_
 	desc.enable      = in_desc->enable;
 	desc.writeEnable = in_desc->write_enable;
 
-	return { Gfx_CreateDepthStencilState(desc).detach().index() };
+	return { Gfx_CreateDepthStencilState(desc).detach().value() };
 }
 
 rush_gfx_rasterizer_state rush_gfx_create_rasterizer_state(const rush_gfx_rasterizer_desc* in_desc)
@@ -603,7 +609,7 @@ rush_gfx_rasterizer_state rush_gfx_create_rasterizer_state(const rush_gfx_raster
 	desc.depthBias           = in_desc->depth_bias;
 	desc.depthBiasSlopeScale = in_desc->depth_bias_slope_scale;
 
-	return { Gfx_CreateRasterizerState(desc).detach().index() };
+	return { Gfx_CreateRasterizerState(desc).detach().value() };
 }
 
 namespace Rush { extern const char* MSL_EmbeddedShaders; }
@@ -676,22 +682,22 @@ void rush_gfx_reset_stats()
 
 rush_gfx_vertex_shader rush_gfx_create_vertex_shader(const rush_gfx_shader_source* in_code)
 {
-	return {Gfx_CreateVertexShader(convert(in_code)).detach().index()};
+	return {Gfx_CreateVertexShader(convert(in_code)).detach().value()};
 }
 
 rush_gfx_pixel_shader rush_gfx_create_pixel_shader(const rush_gfx_shader_source* in_code)
 {
-	return {Gfx_CreatePixelShader(convert(in_code)).detach().index()};
+	return {Gfx_CreatePixelShader(convert(in_code)).detach().value()};
 }
 
 rush_gfx_geometry_shader rush_gfx_create_geometry_shader(const rush_gfx_shader_source* in_code)
 {
-	return {Gfx_CreateGeometryShader(convert(in_code)).detach().index()};
+	return {Gfx_CreateGeometryShader(convert(in_code)).detach().value()};
 }
 
 rush_gfx_compute_shader rush_gfx_create_compute_shader(const rush_gfx_shader_source* in_code)
 {
-	return {Gfx_CreateComputeShader(convert(in_code)).detach().index()};
+	return {Gfx_CreateComputeShader(convert(in_code)).detach().value()};
 }
 
 rush_gfx_vertex_format rush_gfx_create_vertex_format(const rush_gfx_vertex_element* elements, uint32_t count)
@@ -716,7 +722,7 @@ rush_gfx_vertex_format rush_gfx_create_vertex_format(const rush_gfx_vertex_eleme
 		}
 		desc.add(elem.stream, type, (GfxVertexFormatDesc::Semantic)elem.semantic, elem.index);
 	}
-	return {Gfx_CreateVertexFormat(desc).detach().index()};
+	return {Gfx_CreateVertexFormat(desc).detach().value()};
 }
 
 rush_gfx_technique rush_gfx_create_technique(const rush_gfx_technique_desc* in_desc)
@@ -753,7 +759,7 @@ rush_gfx_technique rush_gfx_create_technique(const rush_gfx_technique_desc* in_d
 	desc.specializationData          = in_desc->spec_data;
 	desc.specializationDataSize      = in_desc->spec_data_size;
 
-	return {Gfx_CreateTechnique(desc).detach().index()};
+	return {Gfx_CreateTechnique(desc).detach().value()};
 }
 
 void rush_gfx_set_technique(struct rush_gfx_context* ctx, rush_gfx_technique h)
@@ -873,7 +879,7 @@ rush_gfx_mapped_buffer gfx_map_buffer(rush_gfx_buffer h, uint32_t offset, uint32
 
 	result.data   = mapped_buffer.data;
 	result.size   = mapped_buffer.size;
-	result.handle = rush_gfx_buffer{mapped_buffer.handle.index()};
+	result.handle = rush_gfx_buffer{mapped_buffer.handle.value()};
 
 	return result;
 }
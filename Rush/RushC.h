@@ -251,37 +251,37 @@ struct rush_gfx_device*  rush_platform_get_device();
 struct rush_gfx_context* rush_platform_get_context();
 
 typedef struct rush_gfx_vertex_format 
-{ uint16_t handle; } rush_gfx_vertex_format;
+{ uint32_t handle; } rush_gfx_vertex_format;
 typedef struct rush_gfx_vertex_shader 
-{ uint16_t handle; } rush_gfx_vertex_shader;
+{ uint32_t handle; } rush_gfx_vertex_shader;
 typedef struct rush_gfx_pixel_shader 
-{ uint16_t handle; } rush_gfx_pixel_shader;
+{ uint32_t handle; } rush_gfx_pixel_shader;
 typedef struct rush_gfx_geometry_shader 
-{ uint16_t handle; } rush_gfx_geometry_shader;
+{ uint32_t handle; } rush_gfx_geometry_shader;
 typedef struct rush_gfx_compute_shader 
-{ uint16_t handle; } rush_gfx_compute_shader;
+{ uint32_t handle; } rush_gfx_compute_shader;
 typedef struct rush_gfx_mesh_shader 
-{ uint16_t handle; } rush_gfx_mesh_shader;
+{ uint32_t handle; } rush_gfx_mesh_shader;
 typedef struct rush_gfx_ray_tracing_pipeline 
-{ uint16_t handle; } rush_gfx_ray_tracing_pipeline;
+{ uint32_t handle; } rush_gfx_ray_tracing_pipeline;
 typedef struct rush_gfx_acceleration_structure 
-{ uint16_t handle; } rush_gfx_acceleration_structure;
+{ uint32_t handle; } rush_gfx_acceleration_structure;
 typedef struct rush_gfx_texture 
-{ uint16_t handle; } rush_gfx_texture;
+{ uint32_t handle; } rush_gfx_texture;
 typedef struct rush_gfx_buffer 
-{ uint16_t handle; } rush_gfx_buffer;
+{ uint32_t handle; } rush_gfx_buffer;
 typedef struct rush_gfx_sampler 
-{ uint16_t handle; } rush_gfx_sampler;
+{ uint32_t handle; } rush_gfx_sampler;
 typedef struct rush_gfx_blend_state 
-{ uint16_t handle; } rush_gfx_blend_state;
+{ uint32_t handle; } rush_gfx_blend_state;
 typedef struct rush_gfx_depth_stencil_state 
-{ uint16_t handle; } rush_gfx_depth_stencil_state;
+{ uint32_t handle; } rush_gfx_depth_stencil_state;
 typedef struct rush_gfx_rasterizer_state 
-{ uint16_t handle; } rush_gfx_rasterizer_state;
+{ uint32_t handle; } rush_gfx_rasterizer_state;
 typedef struct rush_gfx_technique 
-{ uint16_t handle; } rush_gfx_technique;
+{ uint32_t handle; } rush_gfx_technique;
 typedef struct rush_gfx_descriptor_set 
-{ uint16_t handle; } rush_gfx_descriptor_set;
+{ uint32_t handle; } rush_gfx_descriptor_set;
 
 typedef enum rush_gfx_blend_param
 {
@@ -792,6 +792,7 @@ void rush_gfx_draw_indexed(struct rush_gfx_context* ctx, uint32_t index_count, u
 void rush_gfx_draw_indexed2(struct rush_gfx_context* ctx, uint32_t index_count, uint32_t first_index, uint32_t base_vertex, uint32_t vertex_count, const void* push_constants, uint32_t push_constants_size);
 void rush_gfx_draw_indexed_instanced(struct rush_gfx_context* ctx, uint32_t index_count, uint32_t first_index, uint32_t base_vertex, uint32_t vertex_count, uint32_t instance_count, uint32_t instance_offset);
 void rush_gfx_draw_indexed_indirect(struct rush_gfx_context* ctx, rush_gfx_buffer args_buffer, uint32_t args_buffer_offset, uint32_t draw_count);
+void rush_gfx_draw_indexed_indirect_count(struct rush_gfx_context* ctx, rush_gfx_buffer args_buffer, uint32_t args_buffer_offset, rush_gfx_buffer count_buffer, uint32_t count_buffer_offset, uint32_t max_draw_count);
 void rush_gfx_dispatch_indirect(struct rush_gfx_context* ctx, rush_gfx_buffer args_buffer, uint32_t args_buffer_offset, const void* push_constants, uint32_t push_constants_size);
 void rush_gfx_push_marker(struct rush_gfx_context* ctx, const char* marker);
 void rush_gfx_pop_marker(struct rush_gfx_context* ctx);
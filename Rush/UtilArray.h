@@ -116,6 +116,13 @@ public:
 
 	DynamicArray() = default;
 
+	// Storage is allocated from the given allocator instead of the default one.
+	// Copies of the array use the default allocator, while moves keep the original allocator.
+	explicit DynamicArray(Allocator& allocator)
+	{
+		m_buffer.m_allocator = &allocator;
+	}
+
 	DynamicArray(size_t size)
 		: DynamicArray()
 	{
@@ -163,6 +170,7 @@ public:
 	{
 		if (&other != this)
 		{
+			Buffer<T>::destroy(m_buffer);
 			m_buffer = other.m_buffer;
 			other.m_buffer = Buffer<T>();
 		}
@@ -194,6 +202,9 @@ public:
 	const T& back() const { return m_buffer.m_data[m_buffer.m_size - 1]; }
 
 	size_t size() const { return m_buffer.m_size; }
+	size_t capacity() const { return m_buffer.m_capacity; }
+
+	Allocator* getAllocator() const { return m_buffer.m_allocator ? m_buffer.m_allocator : getDefaultAllocator(); }
 
 	ArrayView<T> slice(size_t start, size_t count)
 	{
@@ -231,6 +242,42 @@ public:
 		Buffer<T>::pop(m_buffer);
 	}
 
+	// Copies [first, last) before pos and returns pointer to the first inserted element.
+	// Source range must not point into this array.
+	T* insert(const T* pos, const T* first, const T* last)
+	{
+		static_assert(std::is_copy_constructible<T>::value, "Type must be copy-constructible");
+		return Buffer<T>::insert(m_buffer, pos - m_buffer.m_data, first, last);
+	}
+
+	T* insert(const T* pos, ArrayView<const T> values)
+	{
+		return insert(pos, values.begin(), values.end());
+	}
+
+	T* insert(const T* pos, const T& val)
+	{
+		static_assert(std::is_copy_constructible<T>::value, "Type must be copy-constructible");
+		return Buffer<T>::insert(m_buffer, pos - m_buffer.m_data, T(val));
+	}
+
+	T* insert(const T* pos, T&& val)
+	{
+		return Buffer<T>::insert(m_buffer, pos - m_buffer.m_data, std::move(val));
+	}
+
+	// Removes elements in [first, last), preserving order of the remaining ones.
+	// Returns pointer to the element that followed the erased range.
+	T* erase(const T* first, const T* last)
+	{
+		return Buffer<T>::erase(m_buffer, const_cast<T*>(first), const_cast<T*>(last));
+	}
+
+	T* erase(const T* pos)
+	{
+		return erase(pos, pos + 1);
+	}
+
 	RUSH_FORCEINLINE void clear()
 	{
 		Buffer<T>::destructRange(begin(), end());
@@ -255,6 +302,12 @@ public:
 		Buffer<T>::push(m_buffer, std::move(val));
 	}
 
+	template <typename... Args>
+	RUSH_FORCEINLINE T& emplace_back(Args&&... args)
+	{
+		return Buffer<T>::emplace(m_buffer, std::forward<Args>(args)...);
+	}
+
 	RUSH_FORCEINLINE void pop_back()
 	{
 		Buffer<T>::pop(m_buffer);
@@ -265,6 +318,12 @@ private:
 	Buffer<T> m_buffer;
 };
 
+// DynamicArray only holds a pointer to heap storage, so nested arrays can be moved with memcpy on growth
+template <typename T>
+struct IsTriviallyRelocatable<DynamicArray<T>> : std::true_type
+{
+};
+
 template <typename T, size_t CAPACITY>
 struct StaticArray
 {
@@ -304,6 +363,7 @@ struct StaticArray
 
 	void pushBackUnsafe(const T& val)
 	{
+		RUSH_ASSERT_MSG(currentSize < CAPACITY, "StaticArray capacity exceeded");
 		data[currentSize] = val;
 		++currentSize;
 	}
@@ -338,48 +398,110 @@ struct StaticArray
 	size_t currentSize;
 };
 
+// Dynamic array that keeps up to N elements in inline storage and only moves to the heap when it grows past that.
+// Unlike DynamicArray, elements are not stable across moves of the container itself.
 template <typename T, size_t N>
-struct alignas(alignof(T)) InlineDynamicArray
+class SmallVector
 {
-	RUSH_DISALLOW_COPY_AND_ASSIGN(InlineDynamicArray)
+	static_assert(N > 0, "SmallVector requires inline capacity, use DynamicArray instead");
 
-	u8 m_inlineData[sizeof(T) * N];
-	T * m_data = nullptr;
-	u32 m_count = 0;
+public:
 
-	InlineDynamicArray(u32 count)
-		: m_data(reinterpret_cast<T*>(m_inlineData))
-		, m_count(count)
+	SmallVector()
 	{
-		if (m_count > N)
-		{
-			m_data = new T[m_count];
-		}
-		else
-		{
-			Buffer<T>::constructRange(m_data, m_data + m_count);
-		}
+		resetToInline();
+	}
+
+	explicit SmallVector(Allocator& allocator)
+		: SmallVector()
+	{
+		m_buffer.m_allocator = &allocator;
+	}
+
+	SmallVector(size_t size)
+		: SmallVector()
+	{
+		resize(size);
 	}
 
-	~InlineDynamicArray()
+	SmallVector(size_t size, const T& defaultValue)
+		: SmallVector()
 	{
-		if ((void*)m_data == (void*)m_inlineData)
+		resize(size, defaultValue);
+	}
+
+	SmallVector(ArrayView<const T> values)
+		: SmallVector()
+	{
+		insert(end(), values.begin(), values.end());
+	}
+
+	SmallVector(const SmallVector& other)
+		: SmallVector()
+	{
+		insert(end(), other.begin(), other.end());
+	}
+
+	SmallVector(SmallVector&& other) noexcept
+		: SmallVector()
+	{
+		moveFrom(other);
+	}
+
+	SmallVector& operator = (const SmallVector& other)
+	{
+		if (&other != this)
 		{
-			Buffer<T>::destructRange(m_data, m_data + m_count);
+			clear();
+			insert(end(), other.begin(), other.end());
 		}
-		else
+		return *this;
+	}
+
+	SmallVector& operator = (SmallVector&& other) noexcept
+	{
+		if (&other != this)
 		{
-			delete[] m_data;
+			clear();
+			freeHeapStorage();
+			resetToInline();
+			moveFrom(other);
 		}
+		return *this;
 	}
 
-	T&       operator[](size_t i) { return m_data[i]; }
-	const T& operator[](size_t i) const { return m_data[i]; }
+	~SmallVector()
+	{
+		clear();
+		freeHeapStorage();
+	}
 
-	size_t size() const { return m_count; }
+	T&       operator[](size_t i) { return m_buffer.m_data[i]; }
+	const T& operator[](size_t i) const { return m_buffer.m_data[i]; }
 
-	T*       data() { return m_data; }
-	const T* data() const { return m_data; }
+	T*       data()       { return m_buffer.m_data; }
+	const T* data() const { return m_buffer.m_data; }
+
+	T* begin() { return m_buffer.m_data; }
+	T* end()   { return m_buffer.m_data + m_buffer.m_size; }
+
+	const T* begin() const { return m_buffer.m_data; }
+	const T* end() const { return m_buffer.m_data + m_buffer.m_size; }
+
+	T& front() { return m_buffer.m_data[0]; }
+	const T& front() const { return m_buffer.m_data[0]; }
+
+	T& back() { return m_buffer.m_data[m_buffer.m_size - 1]; }
+	const T& back() const { return m_buffer.m_data[m_buffer.m_size - 1]; }
+
+	size_t size() const { return m_buffer.m_size; }
+	size_t capacity() const { return m_buffer.m_capacity; }
+	bool   empty() const { return m_buffer.m_size == 0; }
+
+	// True while elements live in the inline storage
+	bool isInline() const { return m_buffer.m_data == inlineData(); }
+
+	Allocator* getAllocator() const { return m_buffer.m_allocator ? m_buffer.m_allocator : getDefaultAllocator(); }
 
 	ArrayView<T> slice(size_t start, size_t count)
 	{
@@ -389,6 +511,158 @@ struct alignas(alignof(T)) InlineDynamicArray
 	{
 		return ArrayView<const T>::sliceFrom(*this, start, count);
 	}
+
+	void reserve(size_t desiredCapacity)
+	{
+		if (desiredCapacity > m_buffer.m_capacity)
+		{
+			grow(desiredCapacity);
+		}
+	}
+
+	void resize(size_t desiredSize)
+	{
+		reserve(desiredSize);
+		Buffer<T>::resize(m_buffer, desiredSize);
+	}
+
+	void resize(size_t desiredSize, const T& defaultValue)
+	{
+		static_assert(std::is_copy_constructible<T>::value, "Type must be copy-constructible");
+		reserve(desiredSize);
+		Buffer<T>::resize(m_buffer, desiredSize, defaultValue);
+	}
+
+	template <typename... Args>
+	T& emplace_back(Args&&... args)
+	{
+		if (m_buffer.m_size == m_buffer.m_capacity)
+		{
+			// Arguments may reference an element of this array, so construct the value before growing
+			T val(std::forward<Args>(args)...);
+			grow(Buffer<T>::growCapacity(m_buffer.m_capacity, m_buffer.m_size + 1));
+			return Buffer<T>::emplace(m_buffer, std::move(val));
+		}
+
+		return Buffer<T>::emplace(m_buffer, std::forward<Args>(args)...);
+	}
+
+	void push(const T& val) { emplace_back(val); }
+	void push_back(const T& val) { emplace_back(val); }
+	void push_back(T&& val) { emplace_back(std::move(val)); }
+
+	void pop() { Buffer<T>::pop(m_buffer); }
+	void pop_back() { Buffer<T>::pop(m_buffer); }
+
+	// Copies [first, last) before pos and returns pointer to the first inserted element.
+	// Source range must not point into this array.
+	T* insert(const T* pos, const T* first, const T* last)
+	{
+		static_assert(std::is_copy_constructible<T>::value, "Type must be copy-constructible");
+		const size_t index = pos - m_buffer.m_data;
+		reserveForInsert(last - first);
+		return Buffer<T>::insert(m_buffer, index, first, last);
+	}
+
+	T* insert(const T* pos, ArrayView<const T> values)
+	{
+		return insert(pos, values.begin(), values.end());
+	}
+
+	T* insert(const T* pos, const T& val)
+	{
+		static_assert(std::is_copy_constructible<T>::value, "Type must be copy-constructible");
+		return insert(pos, T(val));
+	}
+
+	T* insert(const T* pos, T&& val)
+	{
+		const size_t index = pos - m_buffer.m_data;
+		T tmp(std::move(val));
+		reserveForInsert(1);
+		return Buffer<T>::insert(m_buffer, index, std::move(tmp));
+	}
+
+	T* erase(const T* first, const T* last)
+	{
+		return Buffer<T>::erase(m_buffer, const_cast<T*>(first), const_cast<T*>(last));
+	}
+
+	T* erase(const T* pos)
+	{
+		return erase(pos, pos + 1);
+	}
+
+	void clear()
+	{
+		Buffer<T>::destructRange(begin(), end());
+		m_buffer.m_size = 0;
+	}
+
+private:
+
+	T*       inlineData() { return reinterpret_cast<T*>(m_inlineData); }
+	const T* inlineData() const { return reinterpret_cast<const T*>(m_inlineData); }
+
+	void resetToInline()
+	{
+		m_buffer.m_data     = inlineData();
+		m_buffer.m_size     = 0;
+		m_buffer.m_capacity = N;
+	}
+
+	void reserveForInsert(size_t count)
+	{
+		if (m_buffer.m_size + count > m_buffer.m_capacity)
+		{
+			grow(Buffer<T>::growCapacity(m_buffer.m_capacity, m_buffer.m_size + count));
+		}
+	}
+
+	// Inline storage can't be reallocated, so elements are always relocated to a new heap block
+	void grow(size_t newCapacity)
+	{
+		MemoryTagScope tagScope(MemoryTag::Container, false);
+
+		Allocator* allocator = Buffer<T>::getAllocator(m_buffer);
+
+		T* newData = (T*)allocator->allocate(newCapacity * sizeof(T), alignof(T));
+		RUSH_ASSERT_MSG(newData, "Failed to allocate array storage");
+
+		Buffer<T>::relocateRange(newData, begin(), end());
+		freeHeapStorage();
+
+		m_buffer.m_data     = newData;
+		m_buffer.m_capacity = newCapacity;
+	}
+
+	void freeHeapStorage()
+	{
+		if (!isInline())
+		{
+			m_buffer.m_allocator->deallocate(m_buffer.m_data);
+		}
+	}
+
+	void moveFrom(SmallVector& other)
+	{
+		m_buffer.m_allocator = other.m_buffer.m_allocator;
+
+		if (other.isInline())
+		{
+			Buffer<T>::relocateRange(inlineData(), other.begin(), other.end());
+			m_buffer.m_size = other.m_buffer.m_size;
+		}
+		else
+		{
+			m_buffer = other.m_buffer;
+		}
+
+		other.resetToInline();
+	}
+
+	Buffer<T> m_buffer;
+	alignas(T) u8 m_inlineData[sizeof(T) * N];
 };
 
 }
@@ -1,13 +1,36 @@
 #pragma once
 
 #include "Rush.h"
+#include "UtilLog.h"
 #include "UtilMemory.h"
 
+#include <new>
+#include <string.h>
+#include <type_traits>
 #include <utility>
 
+// Capacity of a full Buffer grows by NUMERATOR / DENOMINATOR (but always by at least one element)
+#ifndef RUSH_BUFFER_GROWTH_NUMERATOR
+#define RUSH_BUFFER_GROWTH_NUMERATOR 2
+#endif
+
+#ifndef RUSH_BUFFER_GROWTH_DENOMINATOR
+#define RUSH_BUFFER_GROWTH_DENOMINATOR 1
+#endif
+
+static_assert(RUSH_BUFFER_GROWTH_NUMERATOR > RUSH_BUFFER_GROWTH_DENOMINATOR, "Buffer growth factor must be above 1");
+
 namespace Rush
 {
 
+// Types that can be moved to a new address with memcpy, without running constructors or destructors.
+// Trivially copyable types are relocatable by definition. Containers that own their storage through a plain pointer
+// (and don't point into themselves) may opt in by specializing this trait.
+template <typename T>
+struct IsTriviallyRelocatable : std::bool_constant<std::is_trivially_copyable_v<T>>
+{
+};
+
 // Generic buffer similar to tinystl::buffer
 template<typename T>
 struct Buffer
@@ -15,44 +38,112 @@ struct Buffer
 	T* m_data = nullptr;
 	size_t m_size = 0;
 	size_t m_capacity = 0;
+	Allocator* m_allocator = nullptr; // default allocator is bound on first allocation
+
+	static constexpr bool Relocatable = IsTriviallyRelocatable<T>::value;
+
+	// Value-initialized trivial types are all zero bits
+	static constexpr bool ZeroInitializable = std::is_trivially_default_constructible_v<T> && std::is_trivially_copyable_v<T>;
 
 	T* begin() { return m_data; }
 	T* end()   { return m_data + m_size; }
 
+	static Allocator* getAllocator(Buffer& buf)
+	{
+		if (!buf.m_allocator)
+		{
+			buf.m_allocator = getDefaultAllocator();
+		}
+		return buf.m_allocator;
+	}
+
+	static size_t growCapacity(size_t capacity, size_t requiredCapacity)
+	{
+		size_t newCapacity = capacity * RUSH_BUFFER_GROWTH_NUMERATOR / RUSH_BUFFER_GROWTH_DENOMINATOR;
+		if (newCapacity <= capacity)
+		{
+			newCapacity = capacity + 1;
+		}
+		return newCapacity < requiredCapacity ? requiredCapacity : newCapacity;
+	}
+
 	static void destructRange(T* begin, T* end)
 	{
-		for (; begin < end; ++begin)
+		if constexpr (!std::is_trivially_destructible_v<T>)
 		{
-			begin->~T();
+			for (; begin < end; ++begin)
+			{
+				begin->~T();
+			}
 		}
 	}
 
-	static void push(Buffer& buf, const T& val)
+	// Moves [begin, end) to uninitialized memory at where, leaving the source range uninitialized.
+	// Ranges may overlap as long as where <= begin.
+	static void relocateRange(T* where, T* begin, T* end)
 	{
-		if (buf.m_size < buf.m_capacity)
+		if constexpr (Relocatable)
 		{
-			new(&buf.m_data[buf.m_size++]) T(val);
+			if (begin != end)
+			{
+				memmove((void*)where, (const void*)begin, (end - begin) * sizeof(T));
+			}
 		}
 		else
 		{
-			size_t newCapacity = (buf.m_capacity > 0) ? (2 * buf.m_capacity) : 1;
-			reserve(buf, newCapacity);
-			new(&buf.m_data[buf.m_size++]) T(val);
+			for (; begin < end; ++begin, ++where)
+			{
+				new(where) T(std::move(*begin));
+				begin->~T();
+			}
 		}
 	}
 
-	static void push(Buffer& buf, T&& val)
+	// Same as relocateRange, but processes elements back to front. Ranges may overlap as long as where >= begin.
+	static void relocateRangeBackward(T* where, T* begin, T* end)
 	{
-		if (buf.m_size < buf.m_capacity)
+		if constexpr (Relocatable)
 		{
-			new(&buf.m_data[buf.m_size++]) T(std::move(val));
+			if (begin != end)
+			{
+				memmove((void*)where, (const void*)begin, (end - begin) * sizeof(T));
+			}
 		}
 		else
 		{
-			size_t newCapacity = (buf.m_capacity > 0) ? (2 * buf.m_capacity) : 1;
-			reserve(buf, newCapacity);
-			new(&buf.m_data[buf.m_size++]) T(std::move(val));
+			where += end - begin;
+			while (end > begin)
+			{
+				--end;
+				--where;
+				new(where) T(std::move(*end));
+				end->~T();
+			}
+		}
+	}
+
+	template <typename... Args>
+	static T& emplace(Buffer& buf, Args&&... args)
+	{
+		if (buf.m_size == buf.m_capacity)
+		{
+			// Arguments may reference an element of this buffer, so construct the value before reallocating
+			T val(std::forward<Args>(args)...);
+			reserve(buf, growCapacity(buf.m_capacity, buf.m_size + 1));
+			return *new(&buf.m_data[buf.m_size++]) T(std::move(val));
 		}
+
+		return *new(&buf.m_data[buf.m_size++]) T(std::forward<Args>(args)...);
+	}
+
+	static void push(Buffer& buf, const T& val)
+	{
+		emplace(buf, val);
+	}
+
+	static void push(Buffer& buf, T&& val)
+	{
+		emplace(buf, std::move(val));
 	}
 
 	static void pop(Buffer& buf)
@@ -63,25 +154,52 @@ struct Buffer
 
 	static void constructCopyRange(T* where, const T* begin, const T* end)
 	{
-		for (; begin < end; ++begin, ++where)
+		if constexpr (std::is_trivially_copyable_v<T>)
 		{
-			new(where) T(*begin);
+			if (begin != end)
+			{
+				memcpy((void*)where, (const void*)begin, (end - begin) * sizeof(T));
+			}
+		}
+		else
+		{
+			for (; begin < end; ++begin, ++where)
+			{
+				new(where) T(*begin);
+			}
 		}
 	}
 
 	static void constructMoveRange(T* where, T* begin, T* end)
 	{
-		for (; begin < end; ++begin, ++where)
+		if constexpr (std::is_trivially_copyable_v<T>)
 		{
-			new(where) T(std::move(*begin));
+			constructCopyRange(where, begin, end);
+		}
+		else
+		{
+			for (; begin < end; ++begin, ++where)
+			{
+				new(where) T(std::move(*begin));
+			}
 		}
 	}
 
 	static void constructRange(T* begin, T* end)
 	{
-		for (; begin < end; ++begin)
+		if constexpr (ZeroInitializable)
+		{
+			if (begin < end)
+			{
+				memset((void*)begin, 0, (end - begin) * sizeof(T));
+			}
+		}
+		else
 		{
-			new(begin) T();
+			for (; begin < end; ++begin)
+			{
+				new(begin) T();
+			}
 		}
 	}
 
@@ -97,13 +215,27 @@ struct Buffer
 	{
 		if (newCapacity <= buf.m_capacity) return;
 
-		T* newData = (T*)allocateBytes(newCapacity * sizeof(T));
+		MemoryTagScope tagScope(MemoryTag::Container, false);
 
-		constructMoveRange(newData, buf.begin(), buf.end());
-		destructRange(buf.begin(), buf.end());
-		deallocateBytes(buf.m_data);
+		Allocator* allocator = getAllocator(buf);
+
+		if constexpr (Relocatable)
+		{
+			buf.m_data = (T*)allocator->reallocate(
+			    buf.m_data, buf.m_capacity * sizeof(T), newCapacity * sizeof(T), alignof(T));
+			RUSH_ASSERT_MSG(buf.m_data, "Failed to allocate buffer storage");
+		}
+		else
+		{
+			T* newData = (T*)allocator->allocate(newCapacity * sizeof(T), alignof(T));
+			RUSH_ASSERT_MSG(newData, "Failed to allocate buffer storage");
+
+			relocateRange(newData, buf.begin(), buf.end());
+			allocator->deallocate(buf.m_data);
+
+			buf.m_data = newData;
+		}
 
-		buf.m_data = newData;
 		buf.m_capacity = newCapacity;
 	}
 
@@ -127,10 +259,66 @@ struct Buffer
 		buf.m_size = newSize;
 	}
 
+	// Copies [first, last) before element at index. Source range must not be part of this buffer.
+	static T* insert(Buffer& buf, size_t index, const T* first, const T* last)
+	{
+		RUSH_ASSERT(index <= buf.m_size);
+		RUSH_ASSERT_MSG(last <= buf.m_data || first >= buf.m_data + buf.m_capacity,
+		    "Inserted range must not alias the buffer");
+
+		const size_t count = last - first;
+		if (buf.m_size + count > buf.m_capacity)
+		{
+			reserve(buf, growCapacity(buf.m_capacity, buf.m_size + count));
+		}
+
+		T* where = buf.m_data + index;
+		relocateRangeBackward(where + count, where, buf.end());
+		constructCopyRange(where, first, last);
+		buf.m_size += count;
+
+		return where;
+	}
+
+	static T* insert(Buffer& buf, size_t index, T&& val)
+	{
+		RUSH_ASSERT(index <= buf.m_size);
+
+		// Value may reference an element of this buffer, which is about to be moved
+		T tmp(std::move(val));
+
+		if (buf.m_size == buf.m_capacity)
+		{
+			reserve(buf, growCapacity(buf.m_capacity, buf.m_size + 1));
+		}
+
+		T* where = buf.m_data + index;
+		relocateRangeBackward(where + 1, where, buf.end());
+		new(where) T(std::move(tmp));
+		++buf.m_size;
+
+		return where;
+	}
+
+	// Removes elements in [first, last) and shifts the remaining elements down
+	static T* erase(Buffer& buf, T* first, T* last)
+	{
+		RUSH_ASSERT(first >= buf.begin() && first <= last && last <= buf.end());
+
+		destructRange(first, last);
+		relocateRange(first, last, buf.end());
+		buf.m_size -= last - first;
+
+		return first;
+	}
+
 	static void destroy(Buffer& buf)
 	{
 		destructRange(buf.m_data, buf.m_data + buf.m_size);
-		deallocateBytes(buf.m_data);
+		if (buf.m_data)
+		{
+			buf.m_allocator->deallocate(buf.m_data);
+		}
 	}
 };
 
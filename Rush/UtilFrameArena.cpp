@@ -0,0 +1,238 @@
+#include "UtilFrameArena.h"
+#include "UtilArray.h"
+#include "UtilLog.h"
+
+#include <mutex>
+#include <string.h>
+
+namespace Rush
+{
+
+namespace
+{
+
+struct FrameArenaRegistry
+{
+	std::mutex                mutex;
+	DynamicArray<FrameArena*> arenas;
+};
+
+FrameArenaRegistry& getFrameArenaRegistry()
+{
+	static FrameArenaRegistry registry;
+	return registry;
+}
+
+inline uintptr_t alignAddress(uintptr_t address, size_t alignment)
+{
+	return (address + alignment - 1) & ~uintptr_t(alignment - 1);
+}
+
+} // namespace
+
+FrameArena::FrameArena(size_t blockSize, bool resetOnBeginFrame, Allocator* backingAllocator)
+: m_backingAllocator(backingAllocator ? backingAllocator : getSystemAllocator())
+, m_blockSize(blockSize)
+, m_resetOnBeginFrame(resetOnBeginFrame)
+{
+	RUSH_ASSERT(blockSize != 0);
+
+	if (m_resetOnBeginFrame)
+	{
+		FrameArenaRegistry&         registry = getFrameArenaRegistry();
+		std::lock_guard<std::mutex> lock(registry.mutex);
+		registry.arenas.push_back(this);
+	}
+}
+
+FrameArena::~FrameArena()
+{
+	if (m_resetOnBeginFrame)
+	{
+		FrameArenaRegistry&         registry = getFrameArenaRegistry();
+		std::lock_guard<std::mutex> lock(registry.mutex);
+		for (FrameArena*& it : registry.arenas)
+		{
+			if (it == this)
+			{
+				registry.arenas.erase(&it);
+				break;
+			}
+		}
+	}
+
+	freeBlocks(m_firstBlock);
+}
+
+FrameArena::Block* FrameArena::allocateBlock(size_t minSize)
+{
+	const size_t size  = minSize > m_blockSize ? minSize : m_blockSize;
+	Block*       block = static_cast<Block*>(m_backingAllocator->allocate(sizeof(Block) + size, alignof(Block)));
+	RUSH_ASSERT_MSG(block, "Failed to allocate frame arena block");
+
+	block->next = nullptr;
+	block->size = size;
+	block->used = 0;
+
+	return block;
+}
+
+void FrameArena::freeBlocks(Block* block)
+{
+	while (block)
+	{
+		Block* next = block->next;
+		m_backingAllocator->deallocate(block);
+		block = next;
+	}
+}
+
+void* FrameArena::allocate(size_t sizeBytes, size_t alignment)
+{
+	RUSH_ASSERT((alignment & (alignment - 1)) == 0);
+
+	Block* block = m_currentBlock ? m_currentBlock : m_firstBlock;
+	while (block)
+	{
+		const uintptr_t base    = reinterpret_cast<uintptr_t>(block->data());
+		const uintptr_t address = alignAddress(base + block->used, alignment);
+		if (address + sizeBytes <= base + block->size)
+		{
+			block->used    = size_t(address + sizeBytes - base);
+			m_currentBlock = block;
+
+			const size_t usedBytes = getUsedBytes();
+			m_peakUsedBytes        = usedBytes > m_peakUsedBytes ? usedBytes : m_peakUsedBytes;
+
+			m_lastAllocation = reinterpret_cast<void*>(address);
+			return m_lastAllocation;
+		}
+
+		// Blocks after the current one are free, they are kept from earlier frames or rewinds
+		if (!block->next)
+		{
+			break;
+		}
+		block       = block->next;
+		block->used = 0;
+	}
+
+	// Worst case padding is reserved, since block data is only aligned to alignof(Block)
+	Block* newBlock = allocateBlock(sizeBytes + alignment);
+	if (block)
+	{
+		block->next = newBlock;
+	}
+	else
+	{
+		m_firstBlock = newBlock;
+	}
+	m_currentBlock = newBlock;
+
+	return allocate(sizeBytes, alignment);
+}
+
+void* FrameArena::reallocate(void* ptr, size_t oldSizeBytes, size_t newSizeBytes, size_t alignment)
+{
+	if (ptr && ptr == m_lastAllocation)
+	{
+		const uintptr_t base    = reinterpret_cast<uintptr_t>(m_currentBlock->data());
+		const uintptr_t address = reinterpret_cast<uintptr_t>(ptr);
+		if (address + newSizeBytes <= base + m_currentBlock->size)
+		{
+			m_currentBlock->used = size_t(address + newSizeBytes - base);
+
+			const size_t usedBytes = getUsedBytes();
+			m_peakUsedBytes        = usedBytes > m_peakUsedBytes ? usedBytes : m_peakUsedBytes;
+
+			return ptr;
+		}
+	}
+
+	void* result = allocate(newSizeBytes, alignment);
+	if (ptr)
+	{
+		memcpy(result, ptr, oldSizeBytes < newSizeBytes ? oldSizeBytes : newSizeBytes);
+	}
+	return result;
+}
+
+void FrameArena::rewind(const Marker& marker)
+{
+	m_lastAllocation = nullptr;
+
+	if (marker.block)
+	{
+		m_currentBlock       = marker.block;
+		m_currentBlock->used = marker.offset;
+	}
+	else
+	{
+		// Arena was empty when the marker was taken
+		m_currentBlock = m_firstBlock;
+		if (m_currentBlock)
+		{
+			m_currentBlock->used = 0;
+		}
+	}
+}
+
+void FrameArena::reset()
+{
+	m_lastAllocation = nullptr;
+
+	if (m_firstBlock && m_firstBlock->next)
+	{
+		const size_t capacity = getCapacityBytes();
+		freeBlocks(m_firstBlock);
+		m_firstBlock = allocateBlock(capacity);
+	}
+
+	m_currentBlock = m_firstBlock;
+	if (m_currentBlock)
+	{
+		m_currentBlock->used = 0;
+	}
+}
+
+size_t FrameArena::getUsedBytes() const
+{
+	size_t result = 0;
+	for (Block* block = m_firstBlock; block; block = block->next)
+	{
+		result += block->used;
+		if (block == m_currentBlock)
+		{
+			break;
+		}
+	}
+	return m_currentBlock ? result : 0;
+}
+
+size_t FrameArena::getCapacityBytes() const
+{
+	size_t result = 0;
+	for (Block* block = m_firstBlock; block; block = block->next)
+	{
+		result += block->size;
+	}
+	return result;
+}
+
+FrameArena& FrameArena::getThreadLocal()
+{
+	thread_local FrameArena arena(DefaultBlockSize, true);
+	return arena;
+}
+
+void FrameArena::resetFrameArenas()
+{
+	FrameArenaRegistry&         registry = getFrameArenaRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	for (FrameArena* arena : registry.arenas)
+	{
+		arena->reset();
+	}
+}
+
+} // namespace Rush
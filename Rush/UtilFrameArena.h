@@ -0,0 +1,102 @@
+#pragma once
+
+#include "Rush.h"
+#include "UtilMemory.h"
+
+namespace Rush
+{
+
+// Byte-oriented linear allocator for short-lived scratch memory.
+// Allocations are served from a chain of blocks that grows on demand and are never freed individually.
+// Memory is reclaimed by rewinding to a marker (see FrameArenaScope) or by reset(), which keeps the blocks for reuse.
+// Can be used as an Allocator to back DynamicArray and SmallVector storage.
+class FrameArena : public Allocator
+{
+public:
+	static constexpr size_t DefaultBlockSize = 64 * 1024;
+
+	struct Block;
+
+	struct Marker
+	{
+		Block* block  = nullptr;
+		size_t offset = 0;
+	};
+
+	// Arenas created with resetOnBeginFrame are reset by Gfx_BeginFrame(), so their memory is only valid for one frame.
+	// Backing allocator defaults to the system allocator.
+	FrameArena(size_t blockSize = DefaultBlockSize, bool resetOnBeginFrame = false, Allocator* backingAllocator = nullptr);
+	~FrameArena();
+
+	FrameArena(const FrameArena&) = delete;
+	FrameArena& operator=(const FrameArena&) = delete;
+
+	void* allocate(size_t sizeBytes, size_t alignment) override;
+	void  deallocate(void*) override {}
+
+	// Grows the most recent allocation in place when possible
+	void* reallocate(void* ptr, size_t oldSizeBytes, size_t newSizeBytes, size_t alignment) override;
+
+	template <typename T> T* allocateArray(size_t count)
+	{
+		return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+	}
+
+	Marker getMarker() const { return Marker{m_currentBlock, m_currentBlock ? m_currentBlock->used : 0}; }
+
+	// Frees all allocations made after the marker was taken
+	void rewind(const Marker& marker);
+
+	// Frees all allocations. If the previous frame needed more than one block, they are merged into a single
+	// block large enough for the whole frame, so steady state frames don't chain.
+	void reset();
+
+	size_t getUsedBytes() const;
+	size_t getCapacityBytes() const;
+	size_t getPeakUsedBytes() const { return m_peakUsedBytes; }
+
+	// Arena owned by the calling thread, created on first use and reset by Gfx_BeginFrame().
+	// Must not be used concurrently with Gfx_BeginFrame().
+	static FrameArena& getThreadLocal();
+
+	// Resets all arenas created with resetOnBeginFrame. Called by Gfx_BeginFrame().
+	static void resetFrameArenas();
+
+	struct Block
+	{
+		Block* next;
+		size_t size;
+		size_t used;
+
+		u8* data() { return reinterpret_cast<u8*>(this + 1); }
+	};
+
+private:
+	Block* allocateBlock(size_t minSize);
+	void   freeBlocks(Block* block);
+
+	Allocator* m_backingAllocator  = nullptr;
+	Block*     m_firstBlock        = nullptr;
+	Block*     m_currentBlock      = nullptr;
+	void*      m_lastAllocation    = nullptr;
+	size_t     m_blockSize         = 0;
+	size_t     m_peakUsedBytes     = 0;
+	bool       m_resetOnBeginFrame = false;
+};
+
+// Rewinds the arena to its state at construction when going out of scope
+class FrameArenaScope
+{
+public:
+	FrameArenaScope(FrameArena& arena) : m_arena(arena), m_marker(arena.getMarker()) {}
+	~FrameArenaScope() { m_arena.rewind(m_marker); }
+
+	FrameArenaScope(const FrameArenaScope&) = delete;
+	FrameArenaScope& operator=(const FrameArenaScope&) = delete;
+
+private:
+	FrameArena&        m_arena;
+	FrameArena::Marker m_marker;
+};
+
+}
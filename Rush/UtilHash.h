@@ -97,5 +97,21 @@ namespace Rush
 			? state
 			: hashStrFnv1aCE(message + 1, u32((u64)(state ^ u32(*message)) * 0x01000193));
 	}
+
+	// Compile-time equivalents of hashFnv1a64() and hashStrFnv1a64(), producing identical values
+
+	inline constexpr u64 hashFnv1a64CE(const char* message, size_t length, u64 state = 0xcbf29ce484222325)
+	{
+		return (length == 0)
+			? state
+			: hashFnv1a64CE(message + 1, length - 1, (state ^ u8(*message)) * 0x100000001b3);
+	}
+
+	inline constexpr u64 hashStrFnv1a64CE(const char* message, u64 state = 0xcbf29ce484222325)
+	{
+		return (*message == 0)
+			? state
+			: hashStrFnv1a64CE(message + 1, (state ^ u64(*message)) * 0x100000001b3);
+	}
 }
 
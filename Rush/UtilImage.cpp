@@ -1,6 +1,7 @@
 #include <cstring>
 
 #include "UtilImage.h"
+#include "UtilJobs.h"
 
 namespace Rush
 {
@@ -28,7 +29,12 @@ void convertToRGBA8(ImageView image, ArrayView<ColorRGBA8> output)
 		return;
 	}
 
-	forRows(image, [&](const u8* row, u32 y) {
+	// Rows are converted in parallel, in chunks of roughly RowChunkPixels
+	static constexpr u32 RowChunkPixels = 16384;
+	const size_t rowsPerChunk = image.width ? max<u32>(1, RowChunkPixels / image.width) : 1;
+
+	parallelFor(image.height, rowsPerChunk, [&](size_t y) {
+		const u8* row = image.data + static_cast<size_t>(image.bytesPerRow) * y;
 		for (u32 x = 0; x < image.width; ++x)
 		{
 			const size_t srcIndex = static_cast<size_t>(x) * 4;
@@ -0,0 +1,505 @@
+#include "UtilJobs.h"
+#include "UtilLog.h"
+#include "UtilPoolAllocator.h"
+#include "UtilQueue.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <thread>
+
+namespace Rush
+{
+
+struct JobEntry
+{
+	Job         job;
+	JobCounter* signal = nullptr;
+	JobEntry*   next   = nullptr; // continuation list link
+};
+
+namespace
+{
+
+// Bounded Chase-Lev work-stealing deque of job entries.
+// Owner thread pushes and pops at the bottom, any thread may steal from the top.
+// See "Correct and Efficient Work-Stealing for Weak Memory Models" (Le, Pop, Cohen, Zappa Nardelli).
+// Sequentially consistent accesses of top and bottom stand in for the fences of the original algorithm.
+class JobDeque
+{
+public:
+	static constexpr s64 Capacity = 4096;
+
+	// Returns false if the deque is full
+	bool push(JobEntry* entry)
+	{
+		const s64 bottom = m_bottom.load(std::memory_order_relaxed);
+		const s64 top    = m_top.load(std::memory_order_acquire);
+		if (bottom - top >= Capacity)
+		{
+			return false;
+		}
+
+		m_entries[bottom & (Capacity - 1)].store(entry, std::memory_order_relaxed);
+		m_bottom.store(bottom + 1, std::memory_order_seq_cst);
+
+		return true;
+	}
+
+	JobEntry* pop()
+	{
+		const s64 bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+		m_bottom.store(bottom, std::memory_order_seq_cst);
+		s64 top = m_top.load(std::memory_order_seq_cst);
+
+		if (top > bottom)
+		{
+			m_bottom.store(bottom + 1, std::memory_order_relaxed);
+			return nullptr;
+		}
+
+		JobEntry* entry = m_entries[bottom & (Capacity - 1)].load(std::memory_order_relaxed);
+		if (top == bottom)
+		{
+			// Last entry, race against thieves
+			if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			{
+				entry = nullptr;
+			}
+			m_bottom.store(bottom + 1, std::memory_order_relaxed);
+		}
+
+		return entry;
+	}
+
+	// Returns null if the deque is empty or another thread won the race for the top entry
+	JobEntry* steal()
+	{
+		s64       top    = m_top.load(std::memory_order_seq_cst);
+		const s64 bottom = m_bottom.load(std::memory_order_seq_cst);
+		if (top >= bottom)
+		{
+			return nullptr;
+		}
+
+		JobEntry* entry = m_entries[top & (Capacity - 1)].load(std::memory_order_relaxed);
+		if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+		{
+			return nullptr;
+		}
+
+		return entry;
+	}
+
+private:
+	alignas(CacheLineSize) std::atomic<s64> m_top    = {0};
+	alignas(CacheLineSize) std::atomic<s64> m_bottom = {0};
+	alignas(CacheLineSize) std::atomic<JobEntry*> m_entries[Capacity] = {};
+};
+
+static constexpr u32 InvalidThreadIndex     = ~0u;
+static constexpr u32 InjectionQueueCapacity = 4096;
+static constexpr u32 IdleSpinCount          = 64;
+
+struct JobScheduler
+{
+	JobScheduler(u32 workerThreadCount) : workerThreadCount(workerThreadCount), injectionQueue(InjectionQueueCapacity)
+	{
+		// Main thread uses deque 0
+		deques = new JobDeque[workerThreadCount + 1];
+	}
+
+	~JobScheduler() { delete[] deques; }
+
+	u32       workerThreadCount;
+	JobDeque* deques;
+
+	// Jobs submitted by threads that don't own a deque. Consumer side is guarded by a try-lock.
+	MpscQueue<JobEntry*> injectionQueue;
+	std::atomic_flag     injectionConsumerLock = ATOMIC_FLAG_INIT;
+
+	// Number of entries in deques and the injection queue, used to put idle workers to sleep
+	std::atomic<u32>  queuedJobCount = {0};
+	std::atomic<u32>  sleepingCount  = {0};
+	std::atomic<bool> quit           = {false};
+
+	std::mutex              sleepMutex;
+	std::condition_variable sleepCondition;
+
+	DynamicArray<std::thread> threads;
+};
+
+JobScheduler* g_jobScheduler = nullptr;
+
+// Entries are also used while the scheduler is not running (inline execution and deferred jobs), so the pool is not
+// owned by the scheduler. It is intentionally never destroyed, as jobs may be submitted during static destruction.
+PoolAllocator<JobEntry>& getJobEntryAllocator()
+{
+	static PoolAllocator<JobEntry>* allocator = new PoolAllocator<JobEntry>;
+	return *allocator;
+}
+
+thread_local u32 t_jobThreadIndex = InvalidThreadIndex;
+
+void executeEntry(JobEntry* entry)
+{
+	const Job   job    = entry->job;
+	JobCounter* signal = entry->signal;
+	getJobEntryAllocator().destroy(entry);
+
+	job.function(job.userData);
+
+	if (signal)
+	{
+		signal->signal();
+	}
+}
+
+void wakeWorkers(u32 count)
+{
+	if (g_jobScheduler->sleepingCount.load(std::memory_order_seq_cst) == 0)
+	{
+		return;
+	}
+
+	{
+		// Worker may be between checking its wait predicate and going to sleep
+		std::lock_guard<std::mutex> lock(g_jobScheduler->sleepMutex);
+	}
+
+	if (count == 1)
+	{
+		g_jobScheduler->sleepCondition.notify_one();
+	}
+	else
+	{
+		g_jobScheduler->sleepCondition.notify_all();
+	}
+}
+
+// Takes ownership of a linked list of entries
+void submitEntries(JobEntry* entries)
+{
+	if (!g_jobScheduler)
+	{
+		while (entries)
+		{
+			JobEntry* next = entries->next;
+			executeEntry(entries);
+			entries = next;
+		}
+		return;
+	}
+
+	u32 count = 0;
+	for (JobEntry* it = entries; it; it = it->next)
+	{
+		++count;
+	}
+
+	// Count is raised before entries become visible, so it never underflows when they are taken
+	g_jobScheduler->queuedJobCount.fetch_add(count, std::memory_order_seq_cst);
+
+	const u32 threadIndex     = t_jobThreadIndex;
+	u32       overflow        = 0;
+	JobEntry* overflowEntries = nullptr;
+	while (entries)
+	{
+		JobEntry* next = entries->next;
+		entries->next  = nullptr;
+
+		const bool queued = threadIndex != InvalidThreadIndex ? g_jobScheduler->deques[threadIndex].push(entries)
+		                                                      : g_jobScheduler->injectionQueue.push(entries);
+		if (!queued)
+		{
+			entries->next   = overflowEntries;
+			overflowEntries = entries;
+			++overflow;
+		}
+
+		entries = next;
+	}
+
+	if (overflow != count)
+	{
+		wakeWorkers(count - overflow);
+	}
+
+	// Queues are full, so help by executing the remaining jobs right away
+	if (overflow)
+	{
+		g_jobScheduler->queuedJobCount.fetch_sub(overflow, std::memory_order_relaxed);
+		while (overflowEntries)
+		{
+			JobEntry* next = overflowEntries->next;
+			executeEntry(overflowEntries);
+			overflowEntries = next;
+		}
+	}
+}
+
+JobEntry* popInjectedEntry()
+{
+	JobScheduler& scheduler = *g_jobScheduler;
+	if (scheduler.injectionConsumerLock.test_and_set(std::memory_order_acquire))
+	{
+		return nullptr;
+	}
+
+	JobEntry* entry = nullptr;
+	scheduler.injectionQueue.pop(entry);
+	scheduler.injectionConsumerLock.clear(std::memory_order_release);
+
+	return entry;
+}
+
+JobEntry* findEntry()
+{
+	JobScheduler& scheduler   = *g_jobScheduler;
+	const u32     threadIndex = t_jobThreadIndex;
+	const u32     dequeCount  = scheduler.workerThreadCount + 1;
+
+	JobEntry* entry = nullptr;
+	if (threadIndex != InvalidThreadIndex)
+	{
+		entry = scheduler.deques[threadIndex].pop();
+	}
+
+	if (!entry)
+	{
+		entry = popInjectedEntry();
+	}
+
+	// Steal from other threads, starting from the next one to spread out contention
+	const u32 firstVictim = threadIndex != InvalidThreadIndex ? threadIndex + 1 : 0;
+	for (u32 i = 0; i < dequeCount && !entry; ++i)
+	{
+		const u32 victim = (firstVictim + i) % dequeCount;
+		if (victim != threadIndex)
+		{
+			entry = scheduler.deques[victim].steal();
+		}
+	}
+
+	if (entry)
+	{
+		scheduler.queuedJobCount.fetch_sub(1, std::memory_order_relaxed);
+	}
+
+	return entry;
+}
+
+bool runPendingJob()
+{
+	JobEntry* entry = g_jobScheduler ? findEntry() : nullptr;
+	if (entry)
+	{
+		executeEntry(entry);
+		return true;
+	}
+	return false;
+}
+
+void workerThreadMain(u32 threadIndex)
+{
+	t_jobThreadIndex = threadIndex;
+
+	JobScheduler& scheduler = *g_jobScheduler;
+
+	u32 idleCount = 0;
+	while (!scheduler.quit.load(std::memory_order_relaxed))
+	{
+		if (runPendingJob())
+		{
+			idleCount = 0;
+			continue;
+		}
+
+		if (++idleCount < IdleSpinCount)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(scheduler.sleepMutex);
+		scheduler.sleepingCount.fetch_add(1, std::memory_order_seq_cst);
+		scheduler.sleepCondition.wait(lock, [&scheduler]() {
+			return scheduler.queuedJobCount.load(std::memory_order_seq_cst) != 0 ||
+			       scheduler.quit.load(std::memory_order_relaxed);
+		});
+		scheduler.sleepingCount.fetch_sub(1, std::memory_order_relaxed);
+		idleCount = 0;
+	}
+
+	// Jobs may have been submitted by the jobs that were running during shutdown
+	while (runPendingJob())
+	{
+	}
+
+	t_jobThreadIndex = InvalidThreadIndex;
+}
+
+} // namespace
+
+JobCounter::~JobCounter()
+{
+	// Thread that completed the counter may still be releasing the lock in signal()
+	std::lock_guard<std::mutex> lock(m_continuationMutex);
+	RUSH_ASSERT_MSG(isDone(), "Job counter destroyed while jobs are pending");
+}
+
+bool JobCounter::deferUntilDone(JobEntry* entries)
+{
+	std::lock_guard<std::mutex> lock(m_continuationMutex);
+
+	if (isDone())
+	{
+		return false;
+	}
+
+	JobEntry* last = entries;
+	while (last->next)
+	{
+		last = last->next;
+	}
+	last->next      = m_continuations;
+	m_continuations = entries;
+
+	return true;
+}
+
+void JobCounter::signal()
+{
+	// Only the final decrement needs to synchronize with deferUntilDone()
+	u32 pending = m_pending.load(std::memory_order_relaxed);
+	while (pending > 1)
+	{
+		if (m_pending.compare_exchange_weak(pending, pending - 1, std::memory_order_acq_rel))
+		{
+			return;
+		}
+	}
+
+	JobEntry* continuations = nullptr;
+	{
+		std::lock_guard<std::mutex> lock(m_continuationMutex);
+		RUSH_ASSERT(m_pending.load(std::memory_order_relaxed) != 0);
+		if (m_pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		{
+			continuations   = m_continuations;
+			m_continuations = nullptr;
+		}
+	}
+
+	// Counter may be destroyed at this point, continuations are independent of it
+	if (continuations)
+	{
+		submitEntries(continuations);
+	}
+}
+
+u32 Jobs_GetDefaultWorkerThreadCount()
+{
+	const u32 hardwareThreadCount = std::thread::hardware_concurrency();
+	return hardwareThreadCount > 1 ? hardwareThreadCount - 1 : 0;
+}
+
+u32 Jobs_GetWorkerThreadCount() { return g_jobScheduler ? g_jobScheduler->workerThreadCount : 0; }
+
+void Jobs_Startup(u32 workerThreadCount)
+{
+	RUSH_ASSERT_MSG(g_jobScheduler == nullptr, "Job system is already running");
+
+	g_jobScheduler   = new JobScheduler(workerThreadCount);
+	t_jobThreadIndex = 0;
+
+	g_jobScheduler->threads.reserve(workerThreadCount);
+	for (u32 i = 0; i < workerThreadCount; ++i)
+	{
+		g_jobScheduler->threads.push_back(std::thread(workerThreadMain, i + 1));
+	}
+}
+
+void Jobs_Shutdown()
+{
+	RUSH_ASSERT_MSG(g_jobScheduler != nullptr, "Job system is not running");
+	RUSH_ASSERT_MSG(t_jobThreadIndex == 0, "Job system must be shut down by the thread that started it");
+
+	JobScheduler& scheduler = *g_jobScheduler;
+
+	while (runPendingJob())
+	{
+	}
+
+	scheduler.quit.store(true, std::memory_order_relaxed);
+	{
+		std::lock_guard<std::mutex> lock(scheduler.sleepMutex);
+	}
+	scheduler.sleepCondition.notify_all();
+
+	for (std::thread& thread : scheduler.threads)
+	{
+		thread.join();
+	}
+
+	while (runPendingJob())
+	{
+	}
+
+	delete g_jobScheduler;
+	g_jobScheduler   = nullptr;
+	t_jobThreadIndex = InvalidThreadIndex;
+}
+
+void Jobs_Run(const Job* jobs, u32 count, JobCounter* signal, JobCounter* dependency)
+{
+	if (count == 0)
+	{
+		return;
+	}
+
+	if (signal)
+	{
+		signal->add(count);
+	}
+
+	JobEntry* entries = nullptr;
+	for (u32 i = count; i-- > 0;)
+	{
+		RUSH_ASSERT(jobs[i].function);
+		JobEntry* entry = getJobEntryAllocator().create();
+		entry->job      = jobs[i];
+		entry->signal   = signal;
+		entry->next     = entries;
+		entries         = entry;
+	}
+
+	if (dependency && dependency->deferUntilDone(entries))
+	{
+		return;
+	}
+
+	submitEntries(entries);
+}
+
+void Jobs_Wait(const JobCounter& counter)
+{
+	u32 idleCount = 0;
+	while (!counter.isDone())
+	{
+		if (runPendingJob())
+		{
+			idleCount = 0;
+		}
+		else if (++idleCount < IdleSpinCount)
+		{
+			std::this_thread::yield();
+		}
+		else
+		{
+			// Remaining jobs are running on other threads
+			std::this_thread::sleep_for(std::chrono::microseconds(50));
+		}
+	}
+}
+
+} // namespace Rush
@@ -0,0 +1,150 @@
+#pragma once
+
+#include "Rush.h"
+#include "MathCommon.h"
+#include "UtilArray.h"
+
+#include <atomic>
+#include <mutex>
+#include <type_traits>
+
+namespace Rush
+{
+
+// Work-stealing job scheduler.
+// Each worker thread (and the thread that called Jobs_Startup) owns a Chase-Lev deque: jobs submitted by a worker are
+// pushed to and popped from the bottom of its own deque, while idle workers steal from the top of other deques.
+// Jobs submitted from other threads go through a shared injection queue.
+// Completion is tracked with JobCounter, which may also be used to defer jobs until other jobs complete.
+// Threads that wait on a counter execute pending jobs instead of blocking.
+
+typedef void (*JobFunction)(void* userData);
+
+struct Job
+{
+	JobFunction function = nullptr;
+	void*       userData = nullptr;
+};
+
+struct JobEntry;
+
+// Number of outstanding jobs in a group. Counter must outlive all jobs that signal it or depend on it.
+class JobCounter
+{
+public:
+	JobCounter() = default;
+	~JobCounter(); // counter must be done
+
+	JobCounter(const JobCounter&) = delete;
+	JobCounter& operator=(const JobCounter&) = delete;
+
+	bool isDone() const { return m_pending.load(std::memory_order_acquire) == 0; }
+	u32  getPending() const { return m_pending.load(std::memory_order_acquire); }
+
+	// Implementation details, used by the scheduler
+	void add(u32 count) { m_pending.fetch_add(count, std::memory_order_relaxed); }
+	bool deferUntilDone(JobEntry* entries); // returns false if the counter is already done
+	void signal();
+
+private:
+	std::atomic<u32> m_pending = {0};
+
+	std::mutex m_continuationMutex;
+	JobEntry*  m_continuations = nullptr; // submitted when the counter reaches zero
+};
+
+// Zero worker threads is valid, in which case jobs execute on threads that submit or wait for them.
+// Calling thread becomes the main scheduler thread and must be the one that calls Jobs_Shutdown().
+void Jobs_Startup(u32 workerThreadCount);
+void Jobs_Shutdown(); // waits for all submitted jobs
+
+// Hardware thread count minus one, leaving a core for the main thread
+u32 Jobs_GetDefaultWorkerThreadCount();
+
+u32 Jobs_GetWorkerThreadCount();
+
+// Queues jobs for execution. Signal counter (optional) is incremented immediately and decremented as each job
+// completes. If a dependency counter is given, jobs are only queued once it reaches zero.
+// Jobs execute immediately on the calling thread if the scheduler is not running.
+void Jobs_Run(const Job* jobs, u32 count, JobCounter* signal = nullptr, JobCounter* dependency = nullptr);
+
+inline void Jobs_Run(const Job& job, JobCounter* signal = nullptr, JobCounter* dependency = nullptr)
+{
+	Jobs_Run(&job, 1, signal, dependency);
+}
+
+// Executes pending jobs on the calling thread until the counter reaches zero
+void Jobs_Wait(const JobCounter& counter);
+
+// Calls fn(size_t index) for every index in [0, count), spreading the work over worker threads and the calling thread.
+// Indices are processed in chunks of grainSize; each job claims chunks until none are left, which balances load
+// without creating one job per chunk. Returns when all indices have been processed.
+template <typename F> void parallelFor(size_t count, size_t grainSize, F&& fn)
+{
+	grainSize               = max<size_t>(grainSize, 1);
+	const size_t chunkCount = (count + grainSize - 1) / grainSize;
+
+	if (chunkCount <= 1 || Jobs_GetWorkerThreadCount() == 0)
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			fn(i);
+		}
+		return;
+	}
+
+	struct Context
+	{
+		size_t                      count;
+		size_t                      grainSize;
+		size_t                      chunkCount;
+		std::remove_reference_t<F>* fn;
+		std::atomic<size_t>         nextChunk = {0};
+	};
+
+	Context context;
+	context.count      = count;
+	context.grainSize  = grainSize;
+	context.chunkCount = chunkCount;
+	context.fn         = &fn;
+
+	Job job;
+	job.userData = &context;
+	job.function = [](void* userData) {
+		Context& context = *static_cast<Context*>(userData);
+		for (;;)
+		{
+			const size_t chunk = context.nextChunk.fetch_add(1, std::memory_order_relaxed);
+			if (chunk >= context.chunkCount)
+			{
+				break;
+			}
+
+			const size_t first = chunk * context.grainSize;
+			const size_t last  = min(first + context.grainSize, context.count);
+			for (size_t i = first; i < last; ++i)
+			{
+				(*context.fn)(i);
+			}
+		}
+	};
+
+	// One job per thread, calling thread takes part through Jobs_Wait()
+	static constexpr u32 InlineJobCount = 16;
+	const u32            jobCount       = u32(min<size_t>(chunkCount, Jobs_GetWorkerThreadCount() + 1));
+
+	SmallVector<Job, InlineJobCount> jobs;
+	jobs.resize(jobCount, job);
+
+	JobCounter counter;
+	Jobs_Run(jobs.data(), jobCount, &counter);
+	Jobs_Wait(counter);
+}
+
+// Calls fn(T&) for every element of the array, see parallelFor(count, grainSize, fn)
+template <typename T, typename F> void parallelFor(ArrayView<T> items, size_t grainSize, F&& fn)
+{
+	parallelFor(items.size(), grainSize, [&items, &fn](size_t i) { fn(items[i]); });
+}
+
+} // namespace Rush
@@ -0,0 +1,534 @@
+#include "UtilMemory.h"
+#include "Platform.h"
+#include "UtilLog.h"
+
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef RUSH_PLATFORM_WINDOWS
+#include <malloc.h>
+#endif // RUSH_PLATFORM_WINDOWS
+
+namespace Rush
+{
+
+namespace
+{
+
+void* systemAllocate(size_t sizeBytes, size_t alignment)
+{
+	RUSH_ASSERT((alignment & (alignment - 1)) == 0);
+
+#ifdef RUSH_PLATFORM_WINDOWS
+	return _aligned_malloc(sizeBytes ? sizeBytes : 1, alignment);
+#else  // RUSH_PLATFORM_WINDOWS
+	if (alignment <= DefaultAllocationAlignment)
+	{
+		return malloc(sizeBytes);
+	}
+
+	void* result = nullptr;
+	if (posix_memalign(&result, alignment, sizeBytes))
+	{
+		return nullptr;
+	}
+	return result;
+#endif // RUSH_PLATFORM_WINDOWS
+}
+
+// Blocks may only be resized in place if they were allocated with the same alignment
+bool systemCanReallocate(size_t alignment)
+{
+#ifdef RUSH_PLATFORM_WINDOWS
+	(void)alignment;
+	return true;
+#else  // RUSH_PLATFORM_WINDOWS
+	// There is no aligned realloc on POSIX
+	return alignment <= DefaultAllocationAlignment;
+#endif // RUSH_PLATFORM_WINDOWS
+}
+
+void* systemReallocate(void* ptr, size_t sizeBytes, size_t alignment)
+{
+#ifdef RUSH_PLATFORM_WINDOWS
+	return _aligned_realloc(ptr, sizeBytes ? sizeBytes : 1, alignment);
+#else  // RUSH_PLATFORM_WINDOWS
+	RUSH_ASSERT(alignment <= DefaultAllocationAlignment);
+	return realloc(ptr, sizeBytes);
+#endif // RUSH_PLATFORM_WINDOWS
+}
+
+void systemFree(void* ptr)
+{
+#ifdef RUSH_PLATFORM_WINDOWS
+	_aligned_free(ptr);
+#else  // RUSH_PLATFORM_WINDOWS
+	free(ptr);
+#endif // RUSH_PLATFORM_WINDOWS
+}
+
+thread_local MemoryTag g_currentTag = MemoryTag::General;
+
+#if RUSH_MEMORY_TRACKING
+
+// Stored immediately before the pointer returned to the user
+struct AllocationHeader
+{
+	size_t    sizeBytes;
+	u32       offset; // from the start of the system block to the user pointer
+	MemoryTag tag;
+};
+
+static constexpr size_t MinHeaderSize = 16;
+static_assert(sizeof(AllocationHeader) <= MinHeaderSize, "Allocation header does not fit");
+
+// Counters are only written by the thread that owns them, using plain loads and stores rather than read-modify-write
+// operations, and are summed over all threads by Memory_GetStats(). Current values of one thread may be negative if
+// it frees memory allocated by another thread.
+struct TagCounters
+{
+	std::atomic<s64> currentBytes {0};
+	std::atomic<s64> currentAllocations {0};
+	std::atomic<u64> totalAllocations {0};
+	std::atomic<u64> totalFrees {0};
+	std::atomic<u64> totalBytes {0};
+};
+
+struct alignas(CacheLineSize) ThreadCounters
+{
+	TagCounters       tags[size_t(MemoryTag::count)];
+	ThreadCounters*   next = nullptr;
+	std::atomic<bool> inUse {true};
+};
+
+// Shared by threads that allocate or free memory after releasing their own counters on exit, guarded by a spin lock.
+// Never released, so it is never claimed by another thread.
+constinit ThreadCounters   g_exitingThreadCounters;
+constinit std::atomic_flag g_exitingThreadLock = ATOMIC_FLAG_INIT;
+
+// Counters are never freed. Counters released by exited threads are reused by new threads, which keeps their totals.
+constinit std::atomic<ThreadCounters*> g_threadCounters {&g_exitingThreadCounters};
+
+thread_local ThreadCounters* t_threadCounters         = nullptr;
+thread_local bool            t_threadCountersReleased = false;
+
+struct ThreadCountersOwner
+{
+	~ThreadCountersOwner()
+	{
+		t_threadCounters->inUse.store(false, std::memory_order_release);
+		t_threadCounters         = nullptr;
+		t_threadCountersReleased = true;
+	}
+};
+
+// Peaks can't be maintained per allocation without shared counters, so they are sampled by Memory_GetStats()
+std::mutex g_peakMutex;
+size_t     g_peakBytes[size_t(MemoryTag::count)];
+size_t     g_totalPeakBytes = 0;
+
+static constexpr u32 CallStackSampleCapacity = 256;
+
+std::atomic<u32>      g_sampleInterval {0};
+std::atomic<u32>      g_sampleCounter {0};
+std::mutex            g_sampleMutex;
+MemoryCallStackSample g_samples[CallStackSampleCapacity];
+u32                   g_sampleCount = 0;
+u32                   g_sampleNext  = 0;
+
+size_t getHeaderSize(size_t alignment) { return alignment > MinHeaderSize ? alignment : MinHeaderSize; }
+
+size_t getBlockAlignment(size_t alignment)
+{
+	return alignment > DefaultAllocationAlignment ? alignment : DefaultAllocationAlignment;
+}
+
+AllocationHeader* getHeader(void* ptr) { return static_cast<AllocationHeader*>(ptr) - 1; }
+
+void* getBlock(void* ptr) { return static_cast<u8*>(ptr) - getHeader(ptr)->offset; }
+
+ThreadCounters* acquireThreadCounters()
+{
+	for (ThreadCounters* it = g_threadCounters.load(std::memory_order_acquire); it; it = it->next)
+	{
+		bool expected = false;
+		if (it->inUse.compare_exchange_strong(expected, true, std::memory_order_acquire, std::memory_order_relaxed))
+		{
+			return it;
+		}
+	}
+
+	// Counters themselves are not tracked
+	void* block = systemAllocate(sizeof(ThreadCounters), alignof(ThreadCounters));
+	RUSH_ASSERT(block);
+
+	ThreadCounters* result = new (block) ThreadCounters;
+	result->next           = g_threadCounters.load(std::memory_order_relaxed);
+	while (!g_threadCounters.compare_exchange_weak(
+	    result->next, result, std::memory_order_release, std::memory_order_relaxed))
+	{
+	}
+
+	return result;
+}
+
+// Returns null once the counters of the current thread have been released during thread exit
+ThreadCounters* getThreadCounters()
+{
+	if (!t_threadCounters && !t_threadCountersReleased)
+	{
+		thread_local ThreadCountersOwner owner;
+		t_threadCounters = acquireThreadCounters();
+	}
+	return t_threadCounters;
+}
+
+template <typename T> void increment(std::atomic<T>& counter, T value)
+{
+	counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+void trackAllocation(TagCounters& counters, size_t sizeBytes)
+{
+	increment<s64>(counters.currentBytes, s64(sizeBytes));
+	increment<s64>(counters.currentAllocations, 1);
+	increment<u64>(counters.totalAllocations, 1);
+	increment<u64>(counters.totalBytes, sizeBytes);
+}
+
+void trackFree(TagCounters& counters, size_t sizeBytes)
+{
+	increment<s64>(counters.currentBytes, -s64(sizeBytes));
+	increment<s64>(counters.currentAllocations, -1);
+	increment<u64>(counters.totalFrees, 1);
+}
+
+template <typename F> void updateCounters(MemoryTag tag, F&& update)
+{
+	if (ThreadCounters* counters = getThreadCounters())
+	{
+		update(counters->tags[size_t(tag)]);
+	}
+	else
+	{
+		while (g_exitingThreadLock.test_and_set(std::memory_order_acquire))
+		{
+		}
+		update(g_exitingThreadCounters.tags[size_t(tag)]);
+		g_exitingThreadLock.clear(std::memory_order_release);
+	}
+}
+
+void sampleCallStack(size_t sizeBytes, MemoryTag tag)
+{
+	const u32 interval = g_sampleInterval.load(std::memory_order_relaxed);
+	if (interval == 0 || g_sampleCounter.fetch_add(1, std::memory_order_relaxed) % interval != 0)
+	{
+		return;
+	}
+
+	MemoryCallStackSample sample;
+	sample.frameCount = Platform_CaptureCallStack(sample.frames, MemoryCallStackSample::MaxFrames, 2);
+	sample.sizeBytes  = sizeBytes;
+	sample.tag        = tag;
+
+	std::lock_guard<std::mutex> lock(g_sampleMutex);
+	g_samples[g_sampleNext] = sample;
+	g_sampleNext            = (g_sampleNext + 1) % CallStackSampleCapacity;
+	if (g_sampleCount < CallStackSampleCapacity)
+	{
+		++g_sampleCount;
+	}
+}
+
+void onAllocate(size_t sizeBytes, MemoryTag tag)
+{
+	updateCounters(tag, [sizeBytes](TagCounters& counters) { trackAllocation(counters, sizeBytes); });
+	sampleCallStack(sizeBytes, tag);
+}
+
+void onFree(size_t sizeBytes, MemoryTag tag)
+{
+	updateCounters(tag, [sizeBytes](TagCounters& counters) { trackFree(counters, sizeBytes); });
+}
+
+void* initHeader(void* block, size_t headerSize, size_t sizeBytes, MemoryTag tag)
+{
+	void*             ptr    = static_cast<u8*>(block) + headerSize;
+	AllocationHeader* header = getHeader(ptr);
+	header->sizeBytes        = sizeBytes;
+	header->offset           = u32(headerSize);
+	header->tag              = tag;
+	return ptr;
+}
+
+// Sums counters of all threads. Peak values are not filled in.
+MemoryStats sumThreadCounters()
+{
+	s64 currentBytes[size_t(MemoryTag::count)]       = {};
+	s64 currentAllocations[size_t(MemoryTag::count)] = {};
+
+	MemoryStats result;
+	for (const ThreadCounters* it = g_threadCounters.load(std::memory_order_acquire); it; it = it->next)
+	{
+		for (size_t i = 0; i < size_t(MemoryTag::count); ++i)
+		{
+			const TagCounters& counters = it->tags[i];
+			currentBytes[i] += counters.currentBytes.load(std::memory_order_relaxed);
+			currentAllocations[i] += counters.currentAllocations.load(std::memory_order_relaxed);
+			result.tags[i].totalAllocations += counters.totalAllocations.load(std::memory_order_relaxed);
+			result.tags[i].totalFrees += counters.totalFrees.load(std::memory_order_relaxed);
+			result.tags[i].totalBytes += counters.totalBytes.load(std::memory_order_relaxed);
+		}
+	}
+
+	for (size_t i = 0; i < size_t(MemoryTag::count); ++i)
+	{
+		// Counters of different threads are read at different times, so a free may be seen before its allocation
+		MemoryTagStats& stats    = result.tags[i];
+		stats.currentBytes       = currentBytes[i] > 0 ? size_t(currentBytes[i]) : 0;
+		stats.currentAllocations = currentAllocations[i] > 0 ? size_t(currentAllocations[i]) : 0;
+
+		result.total.currentBytes += stats.currentBytes;
+		result.total.currentAllocations += stats.currentAllocations;
+		result.total.totalAllocations += stats.totalAllocations;
+		result.total.totalFrees += stats.totalFrees;
+		result.total.totalBytes += stats.totalBytes;
+	}
+
+	return result;
+}
+
+#endif // RUSH_MEMORY_TRACKING
+
+class SystemAllocator : public Allocator
+{
+public:
+	void* allocate(size_t sizeBytes, size_t alignment) override
+	{
+		return Memory_Allocate(sizeBytes, alignment, g_currentTag);
+	}
+
+	void deallocate(void* ptr) override { Memory_Free(ptr); }
+
+	void* reallocate(void* ptr, size_t oldSizeBytes, size_t newSizeBytes, size_t alignment) override
+	{
+#if !RUSH_MEMORY_TRACKING
+		// Untracked blocks don't record their size, which is required to move over-aligned blocks
+		if (!systemCanReallocate(alignment))
+		{
+			return Allocator::reallocate(ptr, oldSizeBytes, newSizeBytes, alignment);
+		}
+#endif // RUSH_MEMORY_TRACKING
+		(void)oldSizeBytes;
+		return Memory_Reallocate(ptr, newSizeBytes, alignment, g_currentTag);
+	}
+};
+
+// Containers may be destroyed during static destruction, so the system allocator must never be destroyed.
+// Union member destructors don't run implicitly, and constant initialization makes the allocator available before
+// any dynamic initializer.
+union ImmortalSystemAllocator
+{
+	constexpr ImmortalSystemAllocator() : allocator() {}
+	~ImmortalSystemAllocator() {}
+
+	SystemAllocator allocator;
+};
+
+constinit ImmortalSystemAllocator g_systemAllocator;
+constinit Allocator*              g_defaultAllocator = &g_systemAllocator.allocator;
+
+} // namespace
+
+void* Allocator::reallocate(void* ptr, size_t oldSizeBytes, size_t newSizeBytes, size_t alignment)
+{
+	void* result = allocate(newSizeBytes, alignment);
+	if (ptr && result)
+	{
+		// Original block is kept if allocation fails, same as realloc()
+		memcpy(result, ptr, oldSizeBytes < newSizeBytes ? oldSizeBytes : newSizeBytes);
+		deallocate(ptr);
+	}
+	return result;
+}
+
+Allocator* getSystemAllocator() { return &g_systemAllocator.allocator; }
+
+Allocator* getDefaultAllocator() { return g_defaultAllocator; }
+
+void setDefaultAllocator(Allocator* allocator) { g_defaultAllocator = allocator ? allocator : &g_systemAllocator.allocator; }
+
+const char* toString(MemoryTag tag)
+{
+	switch (tag)
+	{
+	case MemoryTag::General: return "General";
+	case MemoryTag::Container: return "Container";
+	case MemoryTag::String: return "String";
+	case MemoryTag::Font: return "Font";
+	case MemoryTag::Staging: return "Staging";
+	case MemoryTag::VulkanCommand: return "VulkanCommand";
+	case MemoryTag::VulkanObject: return "VulkanObject";
+	case MemoryTag::VulkanCache: return "VulkanCache";
+	case MemoryTag::VulkanDevice: return "VulkanDevice";
+	case MemoryTag::VulkanInstance: return "VulkanInstance";
+	default: return "Unknown";
+	}
+}
+
+MemoryTag Memory_GetCurrentTag() { return g_currentTag; }
+
+void Memory_SetCurrentTag(MemoryTag tag) { g_currentTag = tag; }
+
+#if RUSH_MEMORY_TRACKING
+
+void* Memory_Allocate(size_t sizeBytes, size_t alignment, MemoryTag tag)
+{
+	const size_t headerSize = getHeaderSize(alignment);
+	void*        block      = systemAllocate(headerSize + sizeBytes, getBlockAlignment(alignment));
+	if (!block)
+	{
+		return nullptr;
+	}
+
+	onAllocate(sizeBytes, tag);
+
+	return initHeader(block, headerSize, sizeBytes, tag);
+}
+
+void* Memory_Reallocate(void* ptr, size_t sizeBytes, size_t alignment, MemoryTag tag)
+{
+	if (!ptr)
+	{
+		return Memory_Allocate(sizeBytes, alignment, tag);
+	}
+
+	if (sizeBytes == 0)
+	{
+		Memory_Free(ptr);
+		return nullptr;
+	}
+
+	const AllocationHeader oldHeader  = *getHeader(ptr);
+	const size_t           headerSize = getHeaderSize(alignment);
+
+	void* result = nullptr;
+	if (oldHeader.offset == headerSize && systemCanReallocate(alignment))
+	{
+		void* block = systemReallocate(getBlock(ptr), headerSize + sizeBytes, getBlockAlignment(alignment));
+		if (!block)
+		{
+			return nullptr;
+		}
+		result = initHeader(block, headerSize, sizeBytes, tag);
+	}
+	else
+	{
+		void* block = systemAllocate(headerSize + sizeBytes, getBlockAlignment(alignment));
+		if (!block)
+		{
+			return nullptr;
+		}
+		result = initHeader(block, headerSize, sizeBytes, tag);
+		memcpy(result, ptr, oldHeader.sizeBytes < sizeBytes ? oldHeader.sizeBytes : sizeBytes);
+		systemFree(getBlock(ptr));
+	}
+
+	onFree(oldHeader.sizeBytes, oldHeader.tag);
+	onAllocate(sizeBytes, tag);
+
+	return result;
+}
+
+void Memory_Free(void* ptr)
+{
+	if (ptr)
+	{
+		const AllocationHeader* header = getHeader(ptr);
+		onFree(header->sizeBytes, header->tag);
+		systemFree(getBlock(ptr));
+	}
+}
+
+MemoryStats Memory_GetStats()
+{
+	MemoryStats result = sumThreadCounters();
+
+	std::lock_guard<std::mutex> lock(g_peakMutex);
+	for (size_t i = 0; i < size_t(MemoryTag::count); ++i)
+	{
+		if (g_peakBytes[i] < result.tags[i].currentBytes)
+		{
+			g_peakBytes[i] = result.tags[i].currentBytes;
+		}
+		result.tags[i].peakBytes = g_peakBytes[i];
+	}
+	if (g_totalPeakBytes < result.total.currentBytes)
+	{
+		g_totalPeakBytes = result.total.currentBytes;
+	}
+	result.total.peakBytes = g_totalPeakBytes;
+
+	return result;
+}
+
+void Memory_ResetPeaks()
+{
+	const MemoryStats stats = sumThreadCounters();
+
+	std::lock_guard<std::mutex> lock(g_peakMutex);
+	for (size_t i = 0; i < size_t(MemoryTag::count); ++i)
+	{
+		g_peakBytes[i] = stats.tags[i].currentBytes;
+	}
+	g_totalPeakBytes = stats.total.currentBytes;
+}
+
+void Memory_SetCallStackSampling(u32 interval) { g_sampleInterval.store(interval, std::memory_order_relaxed); }
+
+u32 Memory_GetCallStackSamples(MemoryCallStackSample* outSamples, u32 maxSamples)
+{
+	std::lock_guard<std::mutex> lock(g_sampleMutex);
+
+	const u32 count = maxSamples < g_sampleCount ? maxSamples : g_sampleCount;
+	for (u32 i = 0; i < count; ++i)
+	{
+		outSamples[i] = g_samples[(g_sampleNext + CallStackSampleCapacity - 1 - i) % CallStackSampleCapacity];
+	}
+	return count;
+}
+
+#else // RUSH_MEMORY_TRACKING
+
+void* Memory_Allocate(size_t sizeBytes, size_t alignment, MemoryTag) { return systemAllocate(sizeBytes, alignment); }
+
+void* Memory_Reallocate(void* ptr, size_t sizeBytes, size_t alignment, MemoryTag)
+{
+	RUSH_ASSERT_MSG(systemCanReallocate(alignment), "Over-aligned reallocation requires RUSH_MEMORY_TRACKING");
+
+	if (sizeBytes == 0)
+	{
+		systemFree(ptr);
+		return nullptr;
+	}
+
+	return systemReallocate(ptr, sizeBytes, alignment);
+}
+
+void Memory_Free(void* ptr) { systemFree(ptr); }
+
+MemoryStats Memory_GetStats() { return MemoryStats(); }
+
+void Memory_ResetPeaks() {}
+
+void Memory_SetCallStackSampling(u32) {}
+
+u32 Memory_GetCallStackSamples(MemoryCallStackSample*, u32) { return 0; }
+
+#endif // RUSH_MEMORY_TRACKING
+
+} // namespace Rush
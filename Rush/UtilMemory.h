@@ -1,16 +1,164 @@
 #pragma once
 
+#include "Rush.h"
+
+#include <stddef.h>
+
 namespace Rush
 {
 
-inline void* allocateBytes(size_t sizeBytes)
+// Alignment of memory returned by malloc(), sufficient for all fundamental types
+static constexpr size_t DefaultAllocationAlignment = alignof(max_align_t);
+
+// Data written by different threads should be at least this far apart to avoid false sharing
+static constexpr size_t CacheLineSize = 64;
+
+// Heap tracking counts bytes and calls per MemoryTag for all allocations made through the system allocator and
+// the Vulkan allocation callbacks. Counters are kept per thread, so threads don't contend on them. Each allocation
+// carries a small header, so tracking can be compiled out.
+#ifndef RUSH_MEMORY_TRACKING
+#define RUSH_MEMORY_TRACKING 1
+#endif
+
+enum class MemoryTag : u8
+{
+	General,
+	Container,
+	String,
+	Font,
+	Staging,
+
+	// Vulkan driver allocations, by VkSystemAllocationScope
+	VulkanCommand,
+	VulkanObject,
+	VulkanCache,
+	VulkanDevice,
+	VulkanInstance,
+
+	count
+};
+
+const char* toString(MemoryTag tag);
+
+struct MemoryTagStats
+{
+	size_t currentBytes       = 0;
+	size_t peakBytes          = 0; // highest currentBytes seen by Memory_GetStats() since Memory_ResetPeaks()
+	size_t currentAllocations = 0;
+	u64    totalAllocations   = 0; // including reallocations
+	u64    totalFrees         = 0;
+	u64    totalBytes         = 0; // sum of all allocation sizes, useful to measure churn
+};
+
+struct MemoryStats
+{
+	MemoryTagStats tags[size_t(MemoryTag::count)];
+	MemoryTagStats total;
+
+	const MemoryTagStats& operator[](MemoryTag tag) const { return tags[size_t(tag)]; }
+};
+
+// Returns a snapshot of the counters, summed over all threads. Counters of different threads are read independently,
+// so the snapshot is only approximately consistent while other threads are allocating. Peaks are sampled by this
+// function rather than updated by every allocation, so it should be called regularly (i.e. once per frame) to
+// observe them. All values are zero if RUSH_MEMORY_TRACKING is disabled.
+MemoryStats Memory_GetStats();
+
+// Sets peak values to current values, e.g. to measure the high water mark of each frame
+void Memory_ResetPeaks();
+
+struct MemoryCallStackSample
+{
+	static constexpr u32 MaxFrames = 16;
+
+	void*     frames[MaxFrames];
+	u32       frameCount;
+	size_t    sizeBytes;
+	MemoryTag tag;
+};
+
+// Captures the call stack of every N-th allocation into a ring buffer. Zero disables sampling (default).
+void Memory_SetCallStackSampling(u32 interval);
+
+// Copies up to maxSamples most recent samples, newest first. Returns the number of samples written.
+u32 Memory_GetCallStackSamples(MemoryCallStackSample* outSamples, u32 maxSamples);
+
+// Tracked heap primitives used by the system allocator. Memory must be freed with Memory_Free().
+void* Memory_Allocate(size_t sizeBytes, size_t alignment, MemoryTag tag);
+void* Memory_Reallocate(void* ptr, size_t sizeBytes, size_t alignment, MemoryTag tag); // frees if size is 0
+void  Memory_Free(void* ptr);
+
+// Tag of allocations made by the system allocator on the current thread
+MemoryTag Memory_GetCurrentTag();
+void      Memory_SetCurrentTag(MemoryTag tag);
+
+class MemoryTagScope
+{
+public:
+	// Non-overriding scopes only apply when no other tag is active, so that generic code (i.e. containers)
+	// does not hide the more specific tag of the system that owns the memory.
+	MemoryTagScope(MemoryTag tag, bool overrideOuter = true) : m_previousTag(Memory_GetCurrentTag())
+	{
+		if (overrideOuter || m_previousTag == MemoryTag::General)
+		{
+			Memory_SetCurrentTag(tag);
+		}
+	}
+
+	~MemoryTagScope() { Memory_SetCurrentTag(m_previousTag); }
+
+	MemoryTagScope(const MemoryTagScope&) = delete;
+	MemoryTagScope& operator=(const MemoryTagScope&) = delete;
+
+private:
+	MemoryTag m_previousTag;
+};
+
+// Interface used by Util containers and allocateBytes() to get memory.
+// Implementations must honor the requested alignment, which is always a power of two.
+class Allocator
+{
+public:
+	virtual ~Allocator() = default;
+
+	virtual void* allocate(size_t sizeBytes, size_t alignment) = 0;
+
+	// Null ptr must be accepted and is not an error
+	virtual void deallocate(void* ptr) = 0;
+
+	// Contents are preserved up to the smaller of the old and new sizes. Same as allocate() if ptr is null.
+	// Default implementation allocates a new block and copies the contents.
+	virtual void* reallocate(void* ptr, size_t oldSizeBytes, size_t newSizeBytes, size_t alignment);
+};
+
+// System heap allocator. Used unless a different default is installed.
+Allocator* getSystemAllocator();
+
+// Default allocator is used by containers which were not given an explicit allocator.
+// It must be installed before any allocations are made and outlive all memory allocated from it.
+Allocator* getDefaultAllocator();
+void       setDefaultAllocator(Allocator* allocator); // null restores the system allocator
+
+inline void* allocateBytes(size_t sizeBytes, size_t alignment = DefaultAllocationAlignment)
+{
+	return getDefaultAllocator()->allocate(sizeBytes, alignment);
+}
+
+inline void* allocateBytes(size_t sizeBytes, MemoryTag tag, size_t alignment = DefaultAllocationAlignment)
+{
+	MemoryTagScope tagScope(tag);
+	return allocateBytes(sizeBytes, alignment);
+}
+
+inline void* reallocateBytes(
+    void* ptr, size_t oldSizeBytes, size_t newSizeBytes, size_t alignment = DefaultAllocationAlignment)
 {
-	return new char[sizeBytes];
+	return getDefaultAllocator()->reallocate(ptr, oldSizeBytes, newSizeBytes, alignment);
 }
 
 inline void deallocateBytes(void* ptr)
 {
-	delete [] (char*)ptr;
+	getDefaultAllocator()->deallocate(ptr);
 }
 
 template <typename T> class UniquePtr
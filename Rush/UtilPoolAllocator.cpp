@@ -0,0 +1,288 @@
+#include "UtilPoolAllocator.h"
+#include "UtilLog.h"
+
+namespace Rush
+{
+
+namespace
+{
+
+// Blocks cached per thread before a batch is returned to the shared list
+constexpr u32 ThreadCacheBatchSize = 32;
+
+// Number of distinct pools a thread may cache blocks for at the same time
+constexpr u32 ThreadCacheEntryCount = 8;
+
+std::atomic<u64> g_nextBlockPoolId = {1};
+
+// Live pools, used to validate cache entries of pools that may have been destroyed
+struct BlockPoolRegistry
+{
+	std::mutex               mutex;
+	DynamicArray<BlockPool*> pools;
+};
+
+BlockPoolRegistry& getBlockPoolRegistry()
+{
+	static BlockPoolRegistry registry;
+	return registry;
+}
+
+struct ThreadCacheEntry
+{
+	u64              poolId = 0;
+	BlockPool::Node* head   = nullptr;
+	u32              count  = 0;
+};
+
+void flushEntry(ThreadCacheEntry& entry, BlockPool* pool)
+{
+	if (entry.head)
+	{
+		BlockPool::Node* last = entry.head;
+		while (last->next)
+		{
+			last = last->next;
+		}
+		pool->pushFreeList(entry.head, last);
+	}
+
+	entry = ThreadCacheEntry();
+}
+
+// Entries of a pool that no longer exists are dropped, its memory was released together with the pool
+void flushEntryIfAlive(ThreadCacheEntry& entry)
+{
+	if (entry.poolId == 0)
+	{
+		return;
+	}
+
+	BlockPoolRegistry&          registry = getBlockPoolRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	for (BlockPool* pool : registry.pools)
+	{
+		if (pool->getId() == entry.poolId)
+		{
+			flushEntry(entry, pool);
+			return;
+		}
+	}
+
+	entry = ThreadCacheEntry();
+}
+
+struct ThreadCache
+{
+	ThreadCacheEntry entries[ThreadCacheEntryCount];
+
+	~ThreadCache()
+	{
+		for (ThreadCacheEntry& entry : entries)
+		{
+			flushEntryIfAlive(entry);
+		}
+	}
+
+	ThreadCacheEntry* find(u64 poolId)
+	{
+		for (ThreadCacheEntry& entry : entries)
+		{
+			if (entry.poolId == poolId)
+			{
+				return &entry;
+			}
+		}
+		return nullptr;
+	}
+
+	ThreadCacheEntry& findOrAdd(u64 poolId)
+	{
+		if (ThreadCacheEntry* entry = find(poolId))
+		{
+			return *entry;
+		}
+
+		u32 victim = 0;
+		for (u32 i = 0; i < ThreadCacheEntryCount; ++i)
+		{
+			if (entries[i].poolId == 0)
+			{
+				victim = i;
+				break;
+			}
+			if (entries[i].count < entries[victim].count)
+			{
+				victim = i;
+			}
+		}
+
+		flushEntryIfAlive(entries[victim]);
+		entries[victim].poolId = poolId;
+
+		return entries[victim];
+	}
+};
+
+ThreadCache& getThreadCache()
+{
+	thread_local ThreadCache cache;
+	return cache;
+}
+
+inline size_t alignSize(size_t size, size_t alignment) { return (size + alignment - 1) & ~(alignment - 1); }
+
+} // namespace
+
+BlockPool::BlockPool(size_t blockSize, size_t blockAlignment, u32 blocksPerSlab, Allocator* backingAllocator)
+: m_backingAllocator(backingAllocator ? backingAllocator : getSystemAllocator())
+, m_blockSize(alignSize(blockSize, blockAlignment))
+, m_blockAlignment(blockAlignment)
+, m_blocksPerSlab(blocksPerSlab)
+, m_id(g_nextBlockPoolId.fetch_add(1, std::memory_order_relaxed))
+{
+	RUSH_ASSERT(blockSize >= sizeof(Node));
+	RUSH_ASSERT(blockAlignment >= alignof(Node) && (blockAlignment & (blockAlignment - 1)) == 0);
+	RUSH_ASSERT(blocksPerSlab != 0);
+
+	BlockPoolRegistry&          registry = getBlockPoolRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	registry.pools.push_back(this);
+}
+
+BlockPool::~BlockPool()
+{
+	{
+		BlockPoolRegistry&          registry = getBlockPoolRegistry();
+		std::lock_guard<std::mutex> lock(registry.mutex);
+		for (BlockPool*& it : registry.pools)
+		{
+			if (it == this)
+			{
+				registry.pools.erase(&it);
+				break;
+			}
+		}
+	}
+
+	if (getLiveBlockCount() != 0)
+	{
+		RUSH_LOG_WARNING("Block pool destroyed with %d blocks still allocated", int(getLiveBlockCount()));
+	}
+
+	for (void* slab : m_slabs)
+	{
+		m_backingAllocator->deallocate(slab);
+	}
+}
+
+size_t BlockPool::getSlabCount() const
+{
+	std::lock_guard<std::mutex> lock(m_slabMutex);
+	return m_slabs.size();
+}
+
+void BlockPool::pushFreeList(Node* first, Node* last)
+{
+	Node* head = m_freeList.load(std::memory_order_relaxed);
+	do
+	{
+		last->next = head;
+	} while (!m_freeList.compare_exchange_weak(head, first, std::memory_order_release, std::memory_order_relaxed));
+}
+
+BlockPool::Node* BlockPool::allocateSlab()
+{
+	u8* slab = static_cast<u8*>(m_backingAllocator->allocate(m_blockSize * m_blocksPerSlab, m_blockAlignment));
+	RUSH_ASSERT_MSG(slab, "Failed to allocate block pool slab");
+
+	{
+		std::lock_guard<std::mutex> lock(m_slabMutex);
+		m_slabs.push_back(slab);
+	}
+
+	for (u32 i = 0; i < m_blocksPerSlab; ++i)
+	{
+		Node* node = reinterpret_cast<Node*>(slab + i * m_blockSize);
+		node->next = (i + 1 < m_blocksPerSlab) ? reinterpret_cast<Node*>(slab + (i + 1) * m_blockSize) : nullptr;
+	}
+
+	return reinterpret_cast<Node*>(slab);
+}
+
+void* BlockPool::allocate()
+{
+	ThreadCacheEntry& entry = getThreadCache().findOrAdd(m_id);
+
+	if (!entry.head)
+	{
+		// Take everything other threads have returned, falling back to a new slab
+		entry.head = m_freeList.exchange(nullptr, std::memory_order_acquire);
+		if (!entry.head)
+		{
+			entry.head = allocateSlab();
+		}
+
+		entry.count = 0;
+		for (Node* it = entry.head; it; it = it->next)
+		{
+			++entry.count;
+		}
+	}
+
+	Node* result = entry.head;
+	entry.head   = result->next;
+	--entry.count;
+
+	m_liveBlockCount.fetch_add(1, std::memory_order_relaxed);
+
+	return result;
+}
+
+void BlockPool::deallocate(void* ptr)
+{
+	if (!ptr)
+	{
+		return;
+	}
+
+	m_liveBlockCount.fetch_sub(1, std::memory_order_relaxed);
+
+	ThreadCacheEntry& entry = getThreadCache().findOrAdd(m_id);
+
+	Node* node = static_cast<Node*>(ptr);
+	node->next = entry.head;
+	entry.head = node;
+	++entry.count;
+
+	if (entry.count >= 2 * ThreadCacheBatchSize)
+	{
+		// Keep one batch for this thread and give the rest back
+		Node* last = entry.head;
+		for (u32 i = 1; i < ThreadCacheBatchSize; ++i)
+		{
+			last = last->next;
+		}
+
+		Node* returned = last->next;
+		last->next     = nullptr;
+		entry.count    = ThreadCacheBatchSize;
+
+		Node* returnedLast = returned;
+		while (returnedLast->next)
+		{
+			returnedLast = returnedLast->next;
+		}
+		pushFreeList(returned, returnedLast);
+	}
+}
+
+void BlockPool::flushThreadCache()
+{
+	if (ThreadCacheEntry* entry = getThreadCache().find(m_id))
+	{
+		flushEntry(*entry, this);
+	}
+}
+
+} // namespace Rush
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "Rush.h"
+#include "UtilArray.h"
+#include "UtilMemory.h"
+
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <utility>
+
+namespace Rush
+{
+
+// Thread-safe allocator of fixed-size blocks, carved from larger slabs that are only returned on destruction.
+// Freed blocks go to a small per-thread cache first and are handed back to the shared lock-free free list in batches.
+// The shared list is only ever popped as a whole (exchange with null), which avoids the ABA problem of a classic
+// lock-free stack without needing tagged pointers.
+class BlockPool
+{
+public:
+	static constexpr u32 DefaultBlocksPerSlab = 64;
+
+	BlockPool(size_t blockSize, size_t blockAlignment, u32 blocksPerSlab = DefaultBlocksPerSlab,
+	    Allocator* backingAllocator = nullptr);
+	~BlockPool(); // all blocks should be freed by this point, remaining ones are reported and released
+
+	BlockPool(const BlockPool&) = delete;
+	BlockPool& operator=(const BlockPool&) = delete;
+
+	void* allocate();
+	void  deallocate(void* ptr);
+
+	size_t getBlockSize() const { return m_blockSize; }
+	size_t getLiveBlockCount() const { return m_liveBlockCount.load(std::memory_order_relaxed); }
+	size_t getSlabCount() const;
+
+	struct Node
+	{
+		Node* next;
+	};
+
+	// Returns blocks held by the calling thread's cache to the shared free list
+	void flushThreadCache();
+
+	// Implementation details, used by per-thread caches
+	u64  getId() const { return m_id; }
+	void pushFreeList(Node* first, Node* last);
+
+private:
+	Node* allocateSlab();
+
+	std::atomic<Node*>  m_freeList       = {nullptr};
+	std::atomic<size_t> m_liveBlockCount = {0};
+
+	Allocator* m_backingAllocator;
+	size_t     m_blockSize;
+	size_t     m_blockAlignment;
+	u32        m_blocksPerSlab;
+	u64        m_id;
+
+	mutable std::mutex  m_slabMutex;
+	DynamicArray<void*> m_slabs;
+};
+
+// Typed wrapper around BlockPool, for objects that are frequently created and destroyed
+template <typename T, u32 BlocksPerSlab = BlockPool::DefaultBlocksPerSlab> class PoolAllocator
+{
+public:
+	PoolAllocator(Allocator* backingAllocator = nullptr)
+	: m_pool(sizeof(T) > sizeof(BlockPool::Node) ? sizeof(T) : sizeof(BlockPool::Node),
+	      alignof(T) > alignof(BlockPool::Node) ? alignof(T) : alignof(BlockPool::Node), BlocksPerSlab,
+	      backingAllocator)
+	{
+	}
+
+	template <typename... Args> T* create(Args&&... args)
+	{
+		return new (m_pool.allocate()) T(std::forward<Args>(args)...);
+	}
+
+	void destroy(T* ptr)
+	{
+		if (ptr)
+		{
+			ptr->~T();
+			m_pool.deallocate(ptr);
+		}
+	}
+
+	BlockPool&       getBlockPool() { return m_pool; }
+	const BlockPool& getBlockPool() const { return m_pool; }
+
+private:
+	BlockPool m_pool;
+};
+
+}
@@ -0,0 +1,323 @@
+#pragma once
+
+#include "Rush.h"
+#include "MathCommon.h"
+#include "UtilLog.h"
+#include "UtilMemory.h"
+
+#include <atomic>
+#include <new>
+#include <stdint.h>
+#include <utility>
+
+namespace Rush
+{
+
+// Bounded lock-free queue for exactly one producer thread and one consumer thread.
+// Capacity is rounded up to a power of two. Producer and consumer indices live on separate cache lines, and each side
+// keeps a cached copy of the other side's index, so shared cache lines are only touched when the queue looks full
+// (producer) or empty (consumer).
+template <typename T> class SpscQueue
+{
+public:
+	SpscQueue(u32 capacity, Allocator* allocator = nullptr)
+	: m_allocator(allocator ? allocator : getDefaultAllocator()), m_capacity(nextPow2(capacity)), m_mask(m_capacity - 1)
+	{
+		RUSH_ASSERT(capacity != 0);
+
+		MemoryTagScope tagScope(MemoryTag::Container, false);
+		m_data = static_cast<T*>(m_allocator->allocate(sizeof(T) * m_capacity, max(alignof(T), CacheLineSize)));
+		RUSH_ASSERT_MSG(m_data, "Failed to allocate queue storage");
+	}
+
+	~SpscQueue()
+	{
+		const size_t tail = m_tail.load(std::memory_order_acquire);
+		for (size_t i = m_head.load(std::memory_order_relaxed); i != tail; ++i)
+		{
+			m_data[i & m_mask].~T();
+		}
+		m_allocator->deallocate(m_data);
+	}
+
+	SpscQueue(const SpscQueue&) = delete;
+	SpscQueue& operator=(const SpscQueue&) = delete;
+
+	// Producer interface. Functions return false (or the number of items actually pushed) when the queue is full.
+
+	template <typename... Args> bool emplace(Args&&... args)
+	{
+		const size_t tail = m_tail.load(std::memory_order_relaxed);
+		if (getFreeCount(tail, 1) == 0)
+		{
+			return false;
+		}
+
+		new (&m_data[tail & m_mask]) T(std::forward<Args>(args)...);
+		m_tail.store(tail + 1, std::memory_order_release);
+
+		return true;
+	}
+
+	bool push(const T& item) { return emplace(item); }
+	bool push(T&& item) { return emplace(std::move(item)); }
+
+	// Copies up to count items and publishes them to the consumer at once
+	size_t pushBatch(const T* items, size_t count)
+	{
+		const size_t tail = m_tail.load(std::memory_order_relaxed);
+		count             = min(count, getFreeCount(tail, count));
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			new (&m_data[(tail + i) & m_mask]) T(items[i]);
+		}
+		m_tail.store(tail + count, std::memory_order_release);
+
+		return count;
+	}
+
+	// Consumer interface. Functions return false (or the number of items actually popped) when the queue is empty.
+
+	bool pop(T& outItem) { return popBatch(&outItem, 1) == 1; }
+
+	// Moves up to maxCount items to the output and releases their slots to the producer at once
+	size_t popBatch(T* outItems, size_t maxCount)
+	{
+		const size_t head  = m_head.load(std::memory_order_relaxed);
+		const size_t count = min(maxCount, getReadyCount(head, maxCount));
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			T& item     = m_data[(head + i) & m_mask];
+			outItems[i] = std::move(item);
+			item.~T();
+		}
+		m_head.store(head + count, std::memory_order_release);
+
+		return count;
+	}
+
+	// Approximate while the other thread is active
+	size_t size() const
+	{
+		return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire);
+	}
+	bool   empty() const { return size() == 0; }
+	size_t capacity() const { return m_capacity; }
+
+private:
+	// Cached index of the other side is only refreshed if it doesn't satisfy the request
+	size_t getFreeCount(size_t tail, size_t wanted)
+	{
+		if (m_capacity - (tail - m_cachedHead) < wanted)
+		{
+			m_cachedHead = m_head.load(std::memory_order_acquire);
+		}
+		return m_capacity - (tail - m_cachedHead);
+	}
+
+	size_t getReadyCount(size_t head, size_t wanted)
+	{
+		if (m_cachedTail - head < wanted)
+		{
+			m_cachedTail = m_tail.load(std::memory_order_acquire);
+		}
+		return m_cachedTail - head;
+	}
+
+	// Written by the consumer
+	alignas(CacheLineSize) std::atomic<size_t> m_head = {0};
+	size_t m_cachedTail                                = 0;
+
+	// Written by the producer
+	alignas(CacheLineSize) std::atomic<size_t> m_tail = {0};
+	size_t m_cachedHead                                = 0;
+
+	// Read-only after construction
+	alignas(CacheLineSize) Allocator* m_allocator;
+	T*     m_data = nullptr;
+	size_t m_capacity;
+	size_t m_mask;
+};
+
+// Bounded lock-free queue for any number of producer threads and one consumer thread.
+// Based on the bounded queue by Dmitry Vyukov: every slot carries a sequence number, which tells producers whether
+// the slot is free in the current lap and tells the consumer whether its contents were published.
+// Producers only contend on a single compare-exchange of the tail index. Batch pushes claim consecutive slots with one
+// compare-exchange, which keeps batches contiguous in the queue.
+template <typename T> class MpscQueue
+{
+public:
+	MpscQueue(u32 capacity, Allocator* allocator = nullptr)
+	: m_allocator(allocator ? allocator : getDefaultAllocator()), m_capacity(nextPow2(capacity)), m_mask(m_capacity - 1)
+	{
+		RUSH_ASSERT(capacity != 0);
+
+		MemoryTagScope tagScope(MemoryTag::Container, false);
+		m_cells = static_cast<Cell*>(m_allocator->allocate(sizeof(Cell) * m_capacity, max(alignof(Cell), CacheLineSize)));
+		RUSH_ASSERT_MSG(m_cells, "Failed to allocate queue storage");
+
+		for (size_t i = 0; i < m_capacity; ++i)
+		{
+			new (&m_cells[i]) Cell;
+			m_cells[i].sequence.store(i, std::memory_order_relaxed);
+		}
+	}
+
+	~MpscQueue()
+	{
+		for (size_t i = m_head;; ++i)
+		{
+			Cell& cell = m_cells[i & m_mask];
+			if (cell.sequence.load(std::memory_order_acquire) != i + 1)
+			{
+				break;
+			}
+			cell.item()->~T();
+		}
+
+		for (size_t i = 0; i < m_capacity; ++i)
+		{
+			m_cells[i].~Cell();
+		}
+		m_allocator->deallocate(m_cells);
+	}
+
+	MpscQueue(const MpscQueue&) = delete;
+	MpscQueue& operator=(const MpscQueue&) = delete;
+
+	// Producer interface, may be called from any thread.
+	// Functions return false (or the number of items actually pushed) when the queue is full.
+
+	template <typename... Args> bool emplace(Args&&... args)
+	{
+		size_t pos;
+		if (claim(1, pos) == 0)
+		{
+			return false;
+		}
+
+		Cell& cell = m_cells[pos & m_mask];
+		new (cell.storage) T(std::forward<Args>(args)...);
+		cell.sequence.store(pos + 1, std::memory_order_release);
+
+		return true;
+	}
+
+	bool push(const T& item) { return emplace(item); }
+	bool push(T&& item) { return emplace(std::move(item)); }
+
+	// Copies up to count items into consecutive slots
+	size_t pushBatch(const T* items, size_t count)
+	{
+		size_t pos;
+		count = claim(count, pos);
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			Cell& cell = m_cells[(pos + i) & m_mask];
+			new (cell.storage) T(items[i]);
+			cell.sequence.store(pos + i + 1, std::memory_order_release);
+		}
+
+		return count;
+	}
+
+	// Consumer interface, must only be called from one thread at a time.
+	// Items are returned in the order their slots were claimed. An item whose producer is still writing it blocks
+	// the items behind it, in which case fewer items are returned than are in the queue.
+
+	bool pop(T& outItem) { return popBatch(&outItem, 1) == 1; }
+
+	size_t popBatch(T* outItems, size_t maxCount)
+	{
+		size_t count = 0;
+		for (; count < maxCount; ++count)
+		{
+			const size_t pos  = m_head + count;
+			Cell&        cell = m_cells[pos & m_mask];
+			if (cell.sequence.load(std::memory_order_acquire) != pos + 1)
+			{
+				break;
+			}
+
+			T* item         = cell.item();
+			outItems[count] = std::move(*item);
+			item->~T();
+
+			// Slot becomes available to producers in the next lap
+			cell.sequence.store(pos + m_capacity, std::memory_order_release);
+		}
+		m_head += count;
+
+		return count;
+	}
+
+	size_t capacity() const { return m_capacity; }
+
+private:
+	struct Cell
+	{
+		std::atomic<size_t> sequence;
+		alignas(T) u8 storage[sizeof(T)];
+
+		T* item() { return std::launder(reinterpret_cast<T*>(storage)); }
+	};
+
+	// Claims up to count consecutive slots starting at outPos, returns the number of claimed slots.
+	// The consumer frees slots in order, so a batch fits if its last slot is free in the current lap.
+	size_t claim(size_t count, size_t& outPos)
+	{
+		count = min(count, m_capacity);
+		if (count == 0)
+		{
+			return 0;
+		}
+
+		size_t pos = m_tail.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			const size_t   lastPos = pos + count - 1;
+			const intptr_t diff =
+			    intptr_t(m_cells[lastPos & m_mask].sequence.load(std::memory_order_acquire)) - intptr_t(lastPos);
+
+			if (diff == 0)
+			{
+				if (m_tail.compare_exchange_weak(pos, pos + count, std::memory_order_relaxed))
+				{
+					outPos = pos;
+					return count;
+				}
+			}
+			else if (diff < 0)
+			{
+				// Not enough space for the whole batch
+				if (count == 1)
+				{
+					return 0;
+				}
+				count /= 2;
+			}
+			else
+			{
+				// Another producer claimed the slots first
+				pos = m_tail.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	// Written by producers
+	alignas(CacheLineSize) std::atomic<size_t> m_tail = {0};
+
+	// Written by the consumer
+	alignas(CacheLineSize) size_t m_head = 0;
+
+	// Read-only after construction
+	alignas(CacheLineSize) Allocator* m_allocator;
+	Cell*  m_cells = nullptr;
+	size_t m_capacity;
+	size_t m_mask;
+};
+
+} // namespace Rush
@@ -5,8 +5,8 @@
 #include "UtilLog.h"
 #include "UtilArray.h"
 
-#include <limits>
 #include <string.h>
+#include <type_traits>
 
 namespace Rush
 {
@@ -14,91 +14,214 @@ struct InvalidResourceHandle
 {
 };
 
+// Handle value packs the pool slot index (low bits) and the generation of the slot (high bits).
+// Slot generation is incremented when a resource is removed, so stale handles don't alias resources that
+// later reuse the same slot. Value 0 (slot 0, generation 0) is reserved for invalid handles.
 struct UntypedResourceHandle
 {
-	typedef u16 IndexType;
-	UntypedResourceHandle(IndexType _index) : m_index(_index) {}
+	typedef u32 ValueType;
 
-	bool      valid() const { return m_index != 0; }
-	IndexType index() const { return m_index; }
+	static constexpr u32 IndexBits      = 20;
+	static constexpr u32 GenerationBits = 32 - IndexBits;
+	static constexpr u32 IndexMask      = (1u << IndexBits) - 1;
+	static constexpr u32 GenerationMask = (1u << GenerationBits) - 1;
+	static constexpr u32 MaxIndex       = IndexMask;
 
-	IndexType m_index;
+	UntypedResourceHandle(ValueType _value) : m_value(_value) {}
+
+	static UntypedResourceHandle make(u32 index, u32 generation)
+	{
+		return UntypedResourceHandle((generation << IndexBits) | index);
+	}
+
+	bool      valid() const { return m_value != 0; }
+	u32       index() const { return m_value & IndexMask; }
+	u32       generation() const { return m_value >> IndexBits; }
+	ValueType value() const { return m_value; }
+
+	ValueType m_value;
 };
 
 template <typename T> class ResourceHandle
 {
 public:
-	typedef u16 IndexType;
+	typedef UntypedResourceHandle::ValueType ValueType;
 
-	ResourceHandle() : m_index(0) {}
-	ResourceHandle(InvalidResourceHandle) : m_index(0) {}
-	explicit ResourceHandle(UntypedResourceHandle h) : m_index(h.index()) {}
+	ResourceHandle() : m_value(0) {}
+	ResourceHandle(InvalidResourceHandle) : m_value(0) {}
+	explicit ResourceHandle(UntypedResourceHandle h) : m_value(h.value()) {}
 
-	bool      valid() const { return m_index != 0; }
-	IndexType index() const { return m_index; }
+	bool      valid() const { return m_value != 0; }
+	u32       index() const { return m_value & UntypedResourceHandle::IndexMask; }
+	u32       generation() const { return m_value >> UntypedResourceHandle::IndexBits; }
+	ValueType value() const { return m_value; }
 
-	bool operator==(const ResourceHandle<T>& rhs) const { return m_index == rhs.m_index; }
-	bool operator!=(const ResourceHandle<T>& rhs) const { return m_index != rhs.m_index; }
+	bool operator==(const ResourceHandle<T>& rhs) const { return m_value == rhs.m_value; }
+	bool operator!=(const ResourceHandle<T>& rhs) const { return m_value != rhs.m_value; }
 
-	operator UntypedResourceHandle() const { return UntypedResourceHandle(m_index); }
+	operator UntypedResourceHandle() const { return UntypedResourceHandle(m_value); }
 
 private:
-	ResourceHandle(IndexType idx) : m_index(idx) {}
-	IndexType m_index;
+	ResourceHandle(ValueType value) : m_value(value) {}
+	ValueType m_value;
 };
 
-template <typename T, typename HANDLE_TYPE> class ResourcePool
+// Slot storage for resources addressed by generational handles.
+// Hot data (T) is stored densely, in a separate array from the slot bookkeeping. Rarely accessed data may optionally be
+// split into COLD_TYPE, which lives in its own array and is accessed through getCold().
+// Accessing a removed resource through a stale handle is detected by comparing slot and handle generations.
+template <typename T, typename HANDLE_TYPE, typename COLD_TYPE = void> class ResourcePool
 {
 public:
 	typedef HANDLE_TYPE HandleType;
+	typedef COLD_TYPE   ColdType;
+
+	static constexpr bool HasColdData = !std::is_void_v<COLD_TYPE>;
 
 	ResourcePool()
 	{
-		push(T {});
+		pushReservedSlot();
 	}
 
 	template<typename DeducedT>
 	HANDLE_TYPE push(DeducedT&& val) noexcept
 	{
-		size_t idx;
+		u32 idx;
 		if (empty.empty())
 		{
-			idx = data.size();
+			idx = u32(data.size());
+			RUSH_ASSERT_MSG(idx <= UntypedResourceHandle::MaxIndex, "Resource pool capacity exceeded");
 			data.push_back(std::forward<T>(val));
+			slots.push_back(AliveBit);
+			if constexpr (HasColdData)
+			{
+				cold.emplace_back();
+			}
 		}
 		else
 		{
 			idx = empty.back();
 			empty.pop_back();
 			data[idx] = std::forward<T>(val);
+			slots[idx] |= AliveBit;
+			if constexpr (HasColdData)
+			{
+				cold[idx] = COLD_TYPE {};
+			}
 		}
-		RUSH_ASSERT(idx < std::numeric_limits<UntypedResourceHandle::IndexType>::max());
-		return HANDLE_TYPE(UntypedResourceHandle((UntypedResourceHandle::IndexType)idx));
+
+		return HANDLE_TYPE(UntypedResourceHandle::make(idx, slots[idx] & UntypedResourceHandle::GenerationMask));
 	}
 
 	void remove(HANDLE_TYPE h)
 	{
 		if (h.valid())
 		{
-			empty.push_back(h.index());
+			RUSH_ASSERT_MSG(contains(h), "Removing resource through a stale handle");
+			const u32 idx = h.index();
+			slots[idx] = (slots[idx] + 1) & UntypedResourceHandle::GenerationMask; // clears alive bit
+			empty.push_back(idx);
 		}
 	}
 
 	void reset()
 	{
 		data.clear();
+		slots.clear();
 		empty.clear();
+		if constexpr (HasColdData)
+		{
+			cold.clear();
+		}
+		pushReservedSlot();
 	}
 
 	u32 allocatedCount() const
 	{
-		return u32(data.size() - empty.size());
+		return u32(data.size() - empty.size() - 1);
+	}
+
+	// Returns true if the handle refers to a live resource. Always false for the invalid handle.
+	bool contains(HANDLE_TYPE h) const
+	{
+		const u32 idx = h.index();
+		return h.valid() && idx < slots.size() && slots[idx] == (h.generation() | AliveBit);
+	}
+
+	// Invalid handles resolve to the reserved default-constructed entry
+	const T& operator[](HANDLE_TYPE h) const
+	{
+		RUSH_ASSERT_MSG(!h.valid() || contains(h), "Stale resource handle");
+		return data[h.index()];
+	}
+	T& operator[](HANDLE_TYPE h)
+	{
+		RUSH_ASSERT_MSG(!h.valid() || contains(h), "Stale resource handle");
+		return data[h.index()];
+	}
+
+	template <bool Enabled = HasColdData, typename = std::enable_if_t<Enabled>>
+	auto& getCold(HANDLE_TYPE h)
+	{
+		RUSH_ASSERT_MSG(!h.valid() || contains(h), "Stale resource handle");
+		return cold[h.index()];
+	}
+
+	template <bool Enabled = HasColdData, typename = std::enable_if_t<Enabled>>
+	const auto& getCold(HANDLE_TYPE h) const
+	{
+		RUSH_ASSERT_MSG(!h.valid() || contains(h), "Stale resource handle");
+		return cold[h.index()];
+	}
+
+	// Calls fn(HANDLE_TYPE, T&) for every live resource. Resources must not be added or removed during iteration.
+	template <typename F> void forEach(F&& fn)
+	{
+		for (u32 idx = 1; idx < u32(slots.size()); ++idx)
+		{
+			if (slots[idx] & AliveBit)
+			{
+				fn(makeHandle(idx), data[idx]);
+			}
+		}
+	}
+
+	template <typename F> void forEach(F&& fn) const
+	{
+		for (u32 idx = 1; idx < u32(slots.size()); ++idx)
+		{
+			if (slots[idx] & AliveBit)
+			{
+				fn(makeHandle(idx), static_cast<const T&>(data[idx]));
+			}
+		}
 	}
 
-	const T& operator[](HANDLE_TYPE h) const { return data[h.index()]; }
-	T& operator[](HANDLE_TYPE h) { return data[h.index()]; }
+	typedef std::conditional_t<HasColdData, COLD_TYPE, u8> ColdStorageType;
 
-	DynamicArray<T>      data;
-	DynamicArray<size_t> empty;
+	DynamicArray<T>               data;
+	DynamicArray<ColdStorageType> cold;  // empty unless COLD_TYPE is specified
+	DynamicArray<u32>             slots; // slot generation and alive bit
+	DynamicArray<u32>             empty;
+
+private:
+	static constexpr u32 AliveBit = 1u << 31;
+
+	static_assert(UntypedResourceHandle::GenerationBits <= 31, "Alive bit must not overlap slot generation");
+
+	HANDLE_TYPE makeHandle(u32 idx) const
+	{
+		return HANDLE_TYPE(UntypedResourceHandle::make(idx, slots[idx] & UntypedResourceHandle::GenerationMask));
+	}
+
+	void pushReservedSlot()
+	{
+		data.push_back(T {});
+		slots.push_back(AliveBit);
+		if constexpr (HasColdData)
+		{
+			cold.emplace_back();
+		}
+	}
 };
 }
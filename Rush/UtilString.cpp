@@ -0,0 +1,92 @@
+#include "UtilString.h"
+#include "UtilArray.h"
+#include "UtilLog.h"
+
+#include <mutex>
+#include <stddef.h>
+
+namespace Rush
+{
+
+// Chained hash table of interned strings. Entries are never removed, so pointers to them stay valid forever.
+struct StringId::Table
+{
+	static constexpr size_t InitialBucketCount = 256;
+
+	std::mutex           mutex;
+	DynamicArray<Entry*> buckets;
+	size_t               entryCount = 0;
+};
+
+// Table is intentionally never destroyed, so interned strings remain valid during static destruction
+StringId::Table& StringId::getTable()
+{
+	static Table* table = new Table;
+	return *table;
+}
+
+const StringId::Entry* StringId::intern(const char* str, size_t length, HashType hash)
+{
+	if (length == 0)
+	{
+		return nullptr;
+	}
+
+	Table& table = getTable();
+
+	std::lock_guard<std::mutex> lock(table.mutex);
+
+	MemoryTagScope tagScope(MemoryTag::String);
+
+	if (table.buckets.empty())
+	{
+		table.buckets.resize(Table::InitialBucketCount, nullptr);
+	}
+
+	size_t bucketMask = table.buckets.size() - 1;
+
+	for (Entry* it = table.buckets[hash & bucketMask]; it; it = it->next)
+	{
+		if (it->hash == hash && it->length == length && memcmp(it->str, str, length) == 0)
+		{
+			return it;
+		}
+	}
+
+	// Keep average chain length below 1
+	if (table.entryCount == table.buckets.size())
+	{
+		DynamicArray<Entry*> newBuckets(table.buckets.size() * 2, nullptr);
+		bucketMask = newBuckets.size() - 1;
+
+		for (Entry* bucket : table.buckets)
+		{
+			Entry* it = bucket;
+			while (it)
+			{
+				Entry* next = it->next;
+				it->next = newBuckets[it->hash & bucketMask];
+				newBuckets[it->hash & bucketMask] = it;
+				it = next;
+			}
+		}
+
+		table.buckets = std::move(newBuckets);
+	}
+
+	Entry* entry = static_cast<Entry*>(allocateBytes(offsetof(Entry, str) + length + 1, alignof(Entry)));
+	RUSH_ASSERT_MSG(entry, "Failed to allocate interned string");
+
+	entry->hash   = hash;
+	entry->length = length;
+	memcpy(entry->str, str, length);
+	entry->str[length] = 0;
+
+	entry->next = table.buckets[hash & bucketMask];
+	table.buckets[hash & bucketMask] = entry;
+	table.entryCount++;
+
+	return entry;
+}
+
+} // namespace Rush
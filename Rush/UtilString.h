@@ -1,24 +1,33 @@
 #pragma once
 
 #include "Rush.h"
+#include "UtilHash.h"
+#include "UtilMemory.h"
+
 #include <string.h>
 
 namespace Rush
 {
 
+// String with small-string optimization: contents up to InlineCapacity characters are stored in the object itself
+// and don't allocate. Storage is selected by length, so the object never points into itself and may be memcpy-ed.
 class String
 {
 public:
 
-	String() = default;
+	static constexpr size_t InlineCapacity = 23;
+
+	String() { m_inline[0] = 0; }
 
 	String(const String& other)
 	{
+		m_inline[0] = 0;
 		copyFrom(other);
 	}
 
 	String(const char* data, size_t length=0)
 	{
+		m_inline[0] = 0;
 		if (length == 0 && data)
 		{
 			length = strlen(data);
@@ -28,6 +37,7 @@ public:
 
 	String(String&& other) noexcept
 	{
+		m_inline[0] = 0;
 		moveFrom((String&&)other);
 	}
 
@@ -39,7 +49,10 @@ public:
 
 	String& operator=(const String& other)
 	{
-		copyFrom(other);
+		if (&other != this)
+		{
+			copyFrom(other);
+		}
 		return *this;
 	}
 
@@ -51,65 +64,80 @@ public:
 
 	~String()
 	{
-		delete[] m_data;
+		freeHeap();
 	}
 
 	const char* c_str() const
 	{
-		return m_data ? m_data : getEmptyString();
+		return isInline() ? m_inline : m_heap;
 	}
 
 	char* data()
 	{
-		return m_data;
+		return isInline() ? m_inline : m_heap;
 	}
 
 	size_t length() const { return m_length; }
 	bool empty() const { return m_length == 0; }
+	bool isInline() const { return m_length <= InlineCapacity; }
 
 	char& operator [] (size_t idx)
 	{
-		return m_data[idx];
+		return data()[idx];
 	}
 
 	const char& operator [] (size_t idx) const
 	{
-		return m_data[idx];
+		return c_str()[idx];
+	}
+
+	bool operator == (const String& other) const
+	{
+		return m_length == other.m_length && memcmp(c_str(), other.c_str(), m_length) == 0;
+	}
+
+	bool operator != (const String& other) const
+	{
+		return !(*this == other);
 	}
 
+	// Contents of the new string are uninitialized, except for the terminator
 	void reset(size_t length)
 	{
-		delete[] m_data;
+		freeHeap();
 		m_length = length;
-		if (length)
-		{
-			m_data = new char[length + 1];
-			m_data[length] = 0;
-		}
-		else
+		if (!isInline())
 		{
-			m_data = nullptr;
+			m_heap = (char*)allocateBytes(length + 1, MemoryTag::String);
 		}
+		data()[length] = 0;
 	}
 
 	static const char* getEmptyString() { static const char* emptyString = ""; return emptyString; }
 
 private:
 
+	void freeHeap()
+	{
+		if (!isInline())
+		{
+			deallocateBytes(m_heap);
+			m_length = 0;
+		}
+	}
+
 	void copyFrom(const char* inData, size_t inLength)
 	{
-		delete[] m_data;
-		if (inData)
+		if (!inData)
 		{
-			m_length = inLength;
-			m_data = new char[inLength + 1];
-			memcpy(m_data, inData, inLength);
-			m_data[inLength] = 0;
+			inLength = 0;
 		}
-		else
+
+		reset(inLength);
+
+		if (inLength)
 		{
-			m_length = 0;
-			m_data = nullptr;
+			memcpy(data(), inData, inLength);
 		}
 	}
 
@@ -120,15 +148,34 @@ private:
 
 	void moveFrom(String&& other)
 	{
-		m_data = other.m_data;
-		m_length = other.m_length;
+		if (&other == this)
+		{
+			return;
+		}
+
+		if (other.isInline())
+		{
+			copyFrom(other.c_str(), other.length());
+		}
+		else
+		{
+			freeHeap();
+
+			m_heap = other.m_heap;
+			m_length = other.m_length;
+		}
 
-		other.m_data = nullptr;
 		other.m_length = 0;
+		other.m_inline[0] = 0;
 	}
 
-	char* m_data = nullptr;
 	size_t m_length = 0;
+
+	union
+	{
+		char* m_heap; // valid when length is above InlineCapacity
+		char  m_inline[InlineCapacity + 1];
+	};
 };
 
 class StringView
@@ -182,4 +229,75 @@ private:
 };
 
 
+// Interned string. Equal strings resolve to the same entry in a global table, so comparison and hashing are O(1).
+// Interned strings are never freed, so this is meant for names from a bounded set, such as shader entry points,
+// debug object names and markers, rather than arbitrary text. Interning is thread-safe.
+class StringId
+{
+public:
+
+	typedef u64 HashType;
+
+	// String literal hashed at compile time. Interning a literal skips hashing and it can be compared against
+	// an interned string without a table lookup.
+	struct Literal
+	{
+		template <size_t N>
+		consteval Literal(const char (&str)[N]) : str(str), length(N - 1), hash(hashFnv1a64CE(str, N - 1))
+		{
+		}
+
+		const char* str;
+		size_t      length;
+		HashType    hash;
+	};
+
+	StringId() = default;
+	explicit StringId(const char* str) : StringId(str, str ? strlen(str) : 0) {}
+	StringId(const char* str, size_t length) : m_entry(intern(str, length, computeHash(str, length))) {}
+	StringId(const Literal& literal) : m_entry(intern(literal.str, literal.length, literal.hash)) {}
+
+	const char* c_str() const { return m_entry ? m_entry->str : String::getEmptyString(); }
+	size_t      length() const { return m_entry ? m_entry->length : 0; }
+	bool        empty() const { return m_entry == nullptr; }
+	HashType    hash() const { return m_entry ? m_entry->hash : EmptyHash; }
+
+	bool operator==(const StringId& other) const { return m_entry == other.m_entry; }
+	bool operator!=(const StringId& other) const { return m_entry != other.m_entry; }
+
+	bool operator==(const Literal& literal) const
+	{
+		return hash() == literal.hash && length() == literal.length && memcmp(c_str(), literal.str, literal.length) == 0;
+	}
+	bool operator!=(const Literal& literal) const { return !(*this == literal); }
+
+	// Same value as hashFnv1a64(str, length), which matches hashStrFnv1a64(str) for ASCII strings
+	static HashType computeHash(const char* str, size_t length) { return hashFnv1a64(str, length); }
+
+	struct Hash
+	{
+		size_t operator()(const StringId& id) const { return size_t(id.hash()); }
+	};
+
+private:
+
+	static constexpr HashType EmptyHash = hashFnv1a64CE("", 0);
+
+	struct Entry
+	{
+		HashType hash;
+		size_t   length;
+		Entry*   next; // next entry in the same table bucket
+		char     str[1];
+	};
+
+	struct Table;
+	static Table& getTable();
+
+	// Returns null for empty strings
+	static const Entry* intern(const char* str, size_t length, HashType hash);
+
+	const Entry* m_entry = nullptr;
+};
+
 }
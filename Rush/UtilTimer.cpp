@@ -20,7 +20,7 @@ Timer::Timer(void)
 	QueryPerformanceFrequency((LARGE_INTEGER*)&m_denom);
 #else
 	m_numer = 1;
-	m_denom = 1;
+	m_denom = 1000000;
 #endif
 
 	reset();
@@ -33,9 +33,9 @@ void Timer::reset()
 #if defined(RUSH_PLATFORM_WINDOWS)
 	QueryPerformanceCounter((LARGE_INTEGER*)&m_start);
 #else
-	timeval t;
-	gettimeofday(&t, nullptr);
-	m_start = u64(t.tv_sec) * 1000000ULL + u64(t.tv_usec);
+	timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	m_start = u64(t.tv_sec) * 1000000ULL + u64(t.tv_nsec) / 1000ULL;
 #endif
 }
 
@@ -57,9 +57,9 @@ u64 Timer::ticks() const
 	QueryPerformanceCounter((LARGE_INTEGER*)&curtime);
 	return curtime - m_start;
 #else
-	timeval curtime;
-	gettimeofday(&curtime, nullptr);
-	u64 elapsed = (u64(curtime.tv_sec) * 1000000ULL + u64(curtime.tv_usec)) - m_start;
+	timespec curtime;
+	clock_gettime(CLOCK_MONOTONIC, &curtime);
+	u64 elapsed = (u64(curtime.tv_sec) * 1000000ULL + u64(curtime.tv_nsec) / 1000ULL) - m_start;
 	return elapsed;
 #endif
 }
@@ -69,4 +69,13 @@ u64 Timer::ticksPerSecond() const
 	return m_denom;
 }
 
+double Timer::timeFromSystemTicks(u64 systemTicks) const
+{
+#if defined(RUSH_PLATFORM_WINDOWS)
+	return double(s64(systemTicks - m_start)) / double(m_denom);
+#else
+	return (double(systemTicks) / 1000.0 - double(m_start)) / 1e6;
+#endif
+}
+
 }
@@ -18,6 +18,10 @@ public:
 	u64 ticks() const;
 	u64 ticksPerSecond() const;
 
+	// Converts a raw system clock value to elapsed time in seconds.
+	// System ticks are QueryPerformanceCounter values on Windows and CLOCK_MONOTONIC nanoseconds elsewhere.
+	double timeFromSystemTicks(u64 systemTicks) const;
+
 	static const Timer global;
 
 private:
@@ -0,0 +1,69 @@
+// Reference GPU culling shader used by GfxGpuCulling.
+// Tests instance bounding spheres against frustum planes and appends indirect draw arguments of visible instances.
+
+struct Constants
+{
+	float4 frustumPlanes[6]; // normalized, xyz = normal, w = distance; points inside have non-negative distance
+	uint instanceCount;
+	uint3 padding;
+};
+
+struct InstanceData
+{
+	float4 boundingSphere; // xyz = world space center, w = radius
+	uint indexCount;
+	uint firstIndex;
+	int vertexOffset;
+	uint firstInstance;
+};
+
+struct DrawIndexedArg
+{
+	uint indexCount;
+	uint instanceCount;
+	uint firstIndex;
+	int vertexOffset;
+	uint firstInstance;
+};
+
+cbuffer constantBuffer0 : register(b0)
+{
+	Constants constantBuffer0;
+};
+
+StructuredBuffer<InstanceData> instances : register(t1);
+RWStructuredBuffer<DrawIndexedArg> drawArgs : register(u2);
+RWByteAddressBuffer drawCount : register(u3);
+
+[numthreads(64, 1, 1)]
+void csCullInstances(uint3 tid : SV_DispatchThreadID)
+{
+	uint instanceIndex = tid.x;
+	if (instanceIndex >= constantBuffer0.instanceCount)
+	{
+		return;
+	}
+
+	InstanceData instance = instances[instanceIndex];
+
+	for (uint i = 0; i < 6; ++i)
+	{
+		float4 plane = constantBuffer0.frustumPlanes[i];
+		if (dot(plane.xyz, instance.boundingSphere.xyz) + plane.w + instance.boundingSphere.w < 0)
+		{
+			return;
+		}
+	}
+
+	uint drawIndex;
+	drawCount.InterlockedAdd(0, 1, drawIndex);
+
+	DrawIndexedArg arg;
+	arg.indexCount    = instance.indexCount;
+	arg.instanceCount = 1;
+	arg.firstIndex    = instance.firstIndex;
+	arg.vertexOffset  = instance.vertexOffset;
+	arg.firstInstance = instance.firstInstance;
+
+	drawArgs[drawIndex] = arg;
+}